@@ -2,6 +2,10 @@
 #define MPI_IALLREDUCEW_HPP
 
 #include <mpi.h>
+#include <cstring>
+#include <mutex>
+#include "data_type/aggregate.hpp"
+#include "Vector/map_vector.hpp"
 
 /*! \brief Set of wrapping classing for MPI_Iallreduce
  *
@@ -10,7 +14,336 @@
  */
 
 
+/*! \brief MPI datatype of a primitive
+ *
+ * value is false if T is not a primitive MPI can reduce
+ *
+ * \tparam T type
+ *
+ */
+template<typename T> struct MPI_TypeW
+{
+	//! not a primitive
+	static const bool value = false;
+};
+
+//! MPI datatype of char (MPI_CHAR is not valid in reductions, char is reduced as a signed integer)
+template<> struct MPI_TypeW<char>
+{
+	static const bool value = true;
+	static MPI_Datatype type() {return MPI_SIGNED_CHAR;}
+};
+
+//! MPI datatype of unsigned char
+template<> struct MPI_TypeW<unsigned char>
+{
+	static const bool value = true;
+	static MPI_Datatype type() {return MPI_UNSIGNED_CHAR;}
+};
+
+//! MPI datatype of short
+template<> struct MPI_TypeW<short>
+{
+	static const bool value = true;
+	static MPI_Datatype type() {return MPI_SHORT;}
+};
+
+//! MPI datatype of unsigned short
+template<> struct MPI_TypeW<unsigned short>
+{
+	static const bool value = true;
+	static MPI_Datatype type() {return MPI_UNSIGNED_SHORT;}
+};
+
+//! MPI datatype of int
+template<> struct MPI_TypeW<int>
+{
+	static const bool value = true;
+	static MPI_Datatype type() {return MPI_INT;}
+};
+
+//! MPI datatype of unsigned int
+template<> struct MPI_TypeW<unsigned int>
+{
+	static const bool value = true;
+	static MPI_Datatype type() {return MPI_UNSIGNED;}
+};
+
+//! MPI datatype of long int
+template<> struct MPI_TypeW<long int>
+{
+	static const bool value = true;
+	static MPI_Datatype type() {return MPI_LONG;}
+};
+
+//! MPI datatype of unsigned long int (size_t)
+template<> struct MPI_TypeW<unsigned long int>
+{
+	static const bool value = true;
+	static MPI_Datatype type() {return MPI_UNSIGNED_LONG;}
+};
+
+//! MPI datatype of long long int
+template<> struct MPI_TypeW<long long int>
+{
+	static const bool value = true;
+	static MPI_Datatype type() {return MPI_LONG_LONG;}
+};
+
+//! MPI datatype of unsigned long long int
+template<> struct MPI_TypeW<unsigned long long int>
+{
+	static const bool value = true;
+	static MPI_Datatype type() {return MPI_UNSIGNED_LONG_LONG;}
+};
+
+//! MPI datatype of float
+template<> struct MPI_TypeW<float>
+{
+	static const bool value = true;
+	static MPI_Datatype type() {return MPI_FLOAT;}
+};
+
+//! MPI datatype of double
+template<> struct MPI_TypeW<double>
+{
+	static const bool value = true;
+	static MPI_Datatype type() {return MPI_DOUBLE;}
+};
+
+/*! \brief Check that all the types have the same base type (removing the array extents)
+ *
+ */
+template<typename B, typename ... list> struct MPI_same_base_type
+{
+	static const bool value = true;
+};
+
+template<typename B, typename T, typename ... list> struct MPI_same_base_type<B,T,list...>
+{
+	static const bool value = std::is_same<B,typename std::remove_all_extents<T>::type>::value && MPI_same_base_type<B,list...>::value;
+};
+
+/*! \brief Decompose an object into a buffer of primitives to reduce element-wise
+ *
+ * It is defined for primitives, arrays of primitives, aggregates where all the properties have
+ * the same primitive type (or arrays of it) and openfpm::vector with linear layout of them
+ *
+ * \tparam T type to decompose
+ *
+ */
+template<typename T, bool is_prim = MPI_TypeW<typename std::remove_all_extents<T>::type>::value>
+struct MPI_reduce_decomp
+{
+	//! cannot be reduced
+	static const bool value = false;
+
+	//! base type
+	typedef T base_type;
+};
+
+//! Decomposition of primitives and arrays of primitives
+template<typename T>
+struct MPI_reduce_decomp<T,true>
+{
+	//! base type
+	typedef typename std::remove_all_extents<T>::type base_type;
+
+	//! can be reduced
+	static const bool value = true;
+
+	//! number of primitives for each object
+	static size_t n_prim()
+	{
+		return sizeof(T) / sizeof(base_type);
+	}
+
+	//! pointer to the primitives
+	static void * pointer(T & buf)
+	{
+		return &buf;
+	}
+
+	//! number of primitives
+	static size_t count(T & buf)
+	{
+		return n_prim();
+	}
+};
+
+//! Decomposition of aggregates
+template<typename T, typename ... list>
+struct MPI_reduce_decomp<aggregate<T,list...>,false>
+{
+	//! base type
+	typedef typename std::remove_all_extents<T>::type base_type;
+
+	//! all the properties must have the same base type
+	static const bool value = MPI_TypeW<base_type>::value && MPI_same_base_type<base_type,list...>::value;
+
+	//! number of primitives for each object
+	static size_t n_prim()
+	{
+		return sizeof(typename aggregate<T,list...>::type) / sizeof(base_type);
+	}
+
+	//! pointer to the primitives
+	static void * pointer(aggregate<T,list...> & buf)
+	{
+		return &buf.data;
+	}
+
+	//! number of primitives
+	static size_t count(aggregate<T,list...> & buf)
+	{
+		return n_prim();
+	}
+};
+
+//! Decomposition of vectors with linear layout
+template<typename T, typename Memory, typename grow_p, unsigned int impl>
+struct MPI_reduce_decomp<openfpm::vector<T,Memory,memory_traits_lin,grow_p,impl>,false>
+{
+	//! base type
+	typedef typename MPI_reduce_decomp<T>::base_type base_type;
+
+	//! can be reduced if the element can be reduced
+	static const bool value = MPI_reduce_decomp<T>::value;
+
+	//! pointer to the primitives
+	static void * pointer(openfpm::vector<T,Memory,memory_traits_lin,grow_p,impl> & buf)
+	{
+		return buf.getPointer();
+	}
+
+	//! number of primitives
+	static size_t count(openfpm::vector<T,Memory,memory_traits_lin,grow_p,impl> & buf)
+	{
+		return buf.size() * MPI_reduce_decomp<T>::n_prim();
+	}
+};
+
+/*! \brief Implementation of the general reduction
+ *
+ * \tparam T type to reduce
+ * \tparam reducible true if T can be decomposed in primitives
+ *
+ */
+template<typename T, bool reducible = MPI_reduce_decomp<T>::value>
+struct MPI_IallreduceW_impl
+{
+	static inline void reduce(T & buf,MPI_Op op, MPI_Request & req, MPI_Comm ext_comm)
+	{
+#ifndef DISABLE_ALL_RTTI
+		std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " cannot recognize " << typeid(T).name() << " use reduce<Op>() for user defined reductions\n";
+#endif
+	}
+};
+
+template<typename T>
+struct MPI_IallreduceW_impl<T,true>
+{
+	static inline void reduce(T & buf,MPI_Op op, MPI_Request & req, MPI_Comm ext_comm)
+	{
+		typedef MPI_reduce_decomp<T> dec;
+
+		size_t cnt = dec::count(buf);
+
+		// the count is the same on all the processors, so they all skip the collective
+		if (cnt > 2147483647)
+		{
+			std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " reduction of more than 2^31 elements is not supported\n";
+			req = MPI_REQUEST_NULL;
+			return;
+		}
+
+		MPI_SAFE_CALL(MPI_Iallreduce(MPI_IN_PLACE, dec::pointer(buf), cnt, MPI_TypeW<typename dec::base_type>::type(), op, ext_comm,&req));
+	}
+};
+
+/*! \brief Reduction of objects with a user defined operation
+ *
+ * The objects are transferred as bytes with a derived datatype, and combined with an MPI operation
+ * created over the functor Op. The datatype and the operation are created at the first use and
+ * cached (they are released by MPI_Finalize)
+ *
+ * Op must be default constructible and implement
+ *
+ * \code
+ * void operator()(const T & in, T & inout) const
+ * \endcode
+ *
+ * the operation must be associative and commutative
+ *
+ * \tparam T type to reduce (it must not contain pointers)
+ * \tparam Op functor
+ *
+ */
+template<typename T, typename Op>
+struct MPI_IallreduceW_op
+{
+	//! MPI user function that apply Op element by element
+	static void user_fn(void * in, void * inout, int * len, MPI_Datatype * dt)
+	{
+		Op op;
+
+		unsigned char * a = (unsigned char *)in;
+		unsigned char * b = (unsigned char *)inout;
+
+		for (int i = 0 ; i < *len ; i++)
+		{
+			// MPI does not guarantee the alignment of its temporal buffers
+			T x;
+			T y;
+
+			memcpy((void *)&x,a + i*sizeof(T),sizeof(T));
+			memcpy((void *)&y,b + i*sizeof(T),sizeof(T));
+
+			op(x,y);
+
+			memcpy(b + i*sizeof(T),(void *)&y,sizeof(T));
+		}
+	}
+
+	//! cached datatype (created once, also when several threads reduce at the same time)
+	static MPI_Datatype & type()
+	{
+		static MPI_Datatype dt = MPI_DATATYPE_NULL;
+		static std::once_flag created;
+
+		std::call_once(created,[]()
+		{
+			MPI_SAFE_CALL(MPI_Type_contiguous(sizeof(T),MPI_BYTE,&dt));
+			MPI_SAFE_CALL(MPI_Type_commit(&dt));
+		});
+
+		return dt;
+	}
+
+	//! cached operation (created once, also when several threads reduce at the same time)
+	static MPI_Op & op()
+	{
+		static MPI_Op mop = MPI_OP_NULL;
+		static std::once_flag created;
+
+		std::call_once(created,[]()
+		{
+			MPI_SAFE_CALL(MPI_Op_create(user_fn,1,&mop));
+		});
+
+		return mop;
+	}
+
+	static inline void reduce(T & buf, MPI_Request & req, MPI_Comm ext_comm)
+	{
+		MPI_SAFE_CALL(MPI_Iallreduce(MPI_IN_PLACE, &buf, 1, type(), op(), ext_comm,&req));
+	}
+};
+
 /*! \brief General reduction
+ *
+ * Arrays, aggregates with properties of the same primitive type and vectors of them are
+ * reduced element-wise with one MPI_Iallreduce
  *
  * \tparam any type
  *
@@ -21,9 +354,7 @@ template<typename T> class MPI_IallreduceW
 public:
 	static inline void reduce(T & buf,MPI_Op op, MPI_Request & req, MPI_Comm ext_comm)
 	{
-#ifndef DISABLE_ALL_RTTI
-		std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " cannot recognize " << typeid(T).name() << "\n";
-#endif
+		MPI_IallreduceW_impl<T>::reduce(buf,op,req,ext_comm);
 	}
 };
 
@@ -148,79 +479,4 @@ public:
 	}
 };
 
-////////////////// Specialization for vectors ///////////////
-
-/*! \brief specialization for vector integer
- *
- */
-/*template<> class MPI_IallreduceW<openfpm::vector<int>>
-{
-public:
-	static inline void reduce(openfpm::vector<int> & buf,MPI_Op op, MPI_Request & req, MPI_Comm ext_comm)
-	{
-		MPI_Iallreduce(MPI_IN_PLACE, &buf.get(0), buf.size(),MPI_INT, op, ext_comm,&req);
-	}
-};*/
-
-/*! \brief specialization for vector short
- *
- */
-/*template<> class MPI_IallreduceW<openfpm::vector<short>>
-{
-public:
-	static inline void reduce(openfpm::vector<short> & buf,MPI_Op op, MPI_Request & req, MPI_Comm ext_comm)
-	{
-		MPI_Iallreduce(MPI_IN_PLACE, &buf.get(0), buf.size(),MPI_SHORT, op, ext_comm,&req);
-	}
-};*/
-
-/*! \brief specialization for vector char
- *
- */
-/*template<> class MPI_IallreduceW<openfpm::vector<char>>
-{
-public:
-	static inline void reduce(openfpm::vector<char> & buf,MPI_Op op, MPI_Request & req, MPI_Comm ext_comm)
-	{
-		MPI_Iallreduce(MPI_IN_PLACE, &buf.get(0), buf.size(),MPI_CHAR, op, ext_comm,&req);
-	}
-};*/
-
-/*! \brief specialization for vector size_t
- *
- */
-/*template<> class MPI_IallreduceW<openfpm::vector<size_t>>
-{
-public:
-	static inline void reduce(openfpm::vector<size_t> & buf,MPI_Op op, MPI_Request & req, MPI_Comm ext_comm)
-	{
-		MPI_Iallreduce(MPI_IN_PLACE, &buf.get(0), buf.size(),MPI_UNSIGNED_LONG, op, ext_comm,&req);
-	}
-};*/
-
-/*! \brief specialization for vector float
- *
- */
-/*template<> class MPI_IallreduceW<openfpm::vector<float>>
-{
-public:
-	static inline void reduce(openfpm::vector<float> & buf,MPI_Op op, MPI_Request & req, MPI_Comm ext_comm)
-	{
-		MPI_Iallreduce(MPI_IN_PLACE, &buf.get(0), buf.size(),MPI_FLOAT, op, ext_comm,&req);
-	}
-};*/
-
-/*! \brief specialization for vector double
- *
- */
-
-/*template<> class MPI_IallreduceW<openfpm::vector<double>>
-{
-public:
-	static inline void reduce(openfpm::vector<double> & buf,MPI_Op op, MPI_Request & req, MPI_Comm ext_comm)
-	{
-		MPI_Iallreduce(MPI_IN_PLACE, &buf.get(0), buf.size(),MPI_DOUBLE, op, ext_comm,&req);
-	}
-};*/
-
 #endif
@@ -0,0 +1,68 @@
+/*
+ * MPI_IscanW.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef OPENFPM_VCLUSTER_SRC_MPI_WRAPPER_MPI_ISCANW_HPP_
+#define OPENFPM_VCLUSTER_SRC_MPI_WRAPPER_MPI_ISCANW_HPP_
+
+#include <mpi.h>
+#include "MPI_IallreduceW.hpp"
+
+/*! \brief Set of wrapping classes for MPI_Iscan and MPI_Iexscan
+ *
+ * The object is decomposed in primitives like for MPI_IallreduceW, so primitives, arrays,
+ * aggregates with properties of the same primitive type and vectors of them are scanned element-wise
+ *
+ * \tparam T type to scan
+ * \tparam reducible true if T can be decomposed in primitives
+ *
+ */
+template<typename T, bool reducible = MPI_reduce_decomp<T>::value>
+struct MPI_IscanW
+{
+	static inline void scan(T & buf, MPI_Op op, bool exclusive, MPI_Request & req, MPI_Comm ext_comm)
+	{
+#ifndef DISABLE_ALL_RTTI
+		std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " cannot recognize " << typeid(T).name() << "\n";
+#endif
+	}
+
+	static inline void zero(T & buf)
+	{}
+};
+
+template<typename T>
+struct MPI_IscanW<T,true>
+{
+	static inline void scan(T & buf, MPI_Op op, bool exclusive, MPI_Request & req, MPI_Comm ext_comm)
+	{
+		typedef MPI_reduce_decomp<T> dec;
+
+		size_t cnt = dec::count(buf);
+
+		// the count is the same on all the processors, so they all skip the collective
+		if (cnt > 2147483647)
+		{
+			std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " scan of more than 2^31 elements is not supported\n";
+			req = MPI_REQUEST_NULL;
+			return;
+		}
+
+		if (exclusive == true)
+		{MPI_SAFE_CALL(MPI_Iexscan(MPI_IN_PLACE, dec::pointer(buf), cnt, MPI_TypeW<typename dec::base_type>::type(), op, ext_comm,&req));}
+		else
+		{MPI_SAFE_CALL(MPI_Iscan(MPI_IN_PLACE, dec::pointer(buf), cnt, MPI_TypeW<typename dec::base_type>::type(), op, ext_comm,&req));}
+	}
+
+	//! set all the primitives to zero (result of the exclusive scan on the first processor)
+	static inline void zero(T & buf)
+	{
+		typedef MPI_reduce_decomp<T> dec;
+
+		memset(dec::pointer(buf),0,dec::count(buf)*sizeof(typename dec::base_type));
+	}
+};
+
+#endif /* OPENFPM_VCLUSTER_SRC_MPI_WRAPPER_MPI_ISCANW_HPP_ */
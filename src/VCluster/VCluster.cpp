@@ -17,8 +17,8 @@ std::vector<int> sieve_spf;
 size_t n_vcluster = 0;
 bool ofp_initialized = false;
 
-size_t tot_sent = 0;
-size_t tot_recv = 0;
+std::atomic<size_t> tot_sent(0);
+std::atomic<size_t> tot_recv(0);
 
 std::string program_name;
 
@@ -155,6 +155,10 @@ void openfpm_finalize()
 
 #endif
 
+	// write the communication profile (if requested)
+	if (global_v_cluster_private_heap != NULL)
+	{global_v_cluster_private_heap->finalizeProfile();}
+
 	delete_global_v_cluster_private();
 	ofp_initialized = false;
 
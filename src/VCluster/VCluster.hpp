@@ -9,9 +9,11 @@
 #define VCLUSTER_HPP
 
 #include <signal.h>
+#include <map>
 
 #include "VCluster_base.hpp"
 #include "VCluster_meta_function.hpp"
+#include "util/Vcluster_delta.hpp"
 #include "util/math_util_complex.hpp"
 #include "memory/mem_conf.hpp"
 #include "util/cuda_util.hpp"
@@ -76,6 +78,77 @@ class Vcluster: public Vcluster_base<InternalMemory>
 	// Internal Heap memory
 	HeapMemory * pmem[NQUEUE];
 
+	// scratch used by reorder_buffer (counters per processor and permutation)
+	openfpm::vector<size_t> reorder_cnt;
+	openfpm::vector<size_t> reorder_perm;
+
+	// lossy compression, fields of the element
+	std::vector<vcl_lossy_field> lossy_fields;
+
+	// lossy compression, encoded send buffers for each queue
+	std::vector<std::vector<unsigned char>> lossy_buf[NQUEUE];
+
+	// lossy compression, temporal buffer for decoding
+	std::vector<unsigned char> lossy_tmp;
+
+	// lossy compression is active on the queue
+	bool lossy_active[NQUEUE] = {false};
+
+	// delta exchange, encoded send buffers for each queue
+	std::vector<std::vector<unsigned char>> delta_buf[NQUEUE];
+
+	// delta exchange, occurrences of each processor
+	std::map<size_t,size_t> delta_occ;
+
+	// all-to-all, sizes of the buffers received from each processor
+	openfpm::vector<size_t> a2a_sz_recv;
+
+	// all-to-all, contiguous send and receive buffers
+	std::vector<unsigned char> a2a_sbuf;
+	std::vector<unsigned char> a2a_rbuf;
+
+	// all-to-all, counts and displacements in byte
+	openfpm::vector<int> a2a_scnt;
+	openfpm::vector<int> a2a_sdispl;
+	openfpm::vector<int> a2a_rcnt;
+	openfpm::vector<int> a2a_rdispl;
+
+	// all-to-all and scatter, sizes of the buffers sent to each processor
+	openfpm::vector<size_t> a2a_ssz;
+
+	// gather and scatter along a tree, records of the sub-tree
+	std::vector<unsigned char> tree_buf;
+
+	// gather along a tree, displacements of the records on root (the total can be bigger than 2GB)
+	openfpm::vector<size_t> tree_rdispl;
+
+	// scatter, displacements in byte of the chunks on root (the total can be bigger than 2GB along the tree)
+	openfpm::vector<size_t> scatter_sdispl;
+
+	// gather and scatter along a tree, messages bigger than this are sent in several parts
+	size_t tree_chunk = 1073741824;
+
+	// broadcast, size of the segments of the pipeline
+	size_t bcast_chunk = 1048576;
+
+	// broadcast, requests of the segments
+	openfpm::vector<MPI_Request> bcast_req;
+
+	// communication contexts for the threads
+	std::vector<Vcluster<InternalMemory> *> thr_ctx;
+
+	// communicators of the thread contexts
+	std::vector<MPI_Comm> thr_comm;
+
+	// processing units of this process (hybrid mode)
+	std::vector<Vcluster<InternalMemory> *> pe_ctx;
+
+	// communicators and mailboxes of the processing units
+	Vcluster_pe_group * pe_units = NULL;
+
+	// views on cached sub-communicators (the key is the kind of view with its parameters)
+	std::map<std::vector<long int>,std::pair<Vcluster<InternalMemory> *,MPI_Comm>> sub_vcl;
+
 	/*! \brief Base info
 	 *
 	 * \param recv_buf receive buffers
@@ -168,6 +241,8 @@ class Vcluster: public Vcluster_base<InternalMemory>
 	 * \param prc_recv list of processor from where we receive (output), in case of RECEIVE_KNOWN muts be filled
 	 * \param sz_recv size of each receiving message (output), in case of RECEICE_KNOWN must be filled
 	 * \param opt Options using RECEIVE_KNOWN enable patters with less latencies, in case of RECEIVE_KNOWN
+	 * \param err_bound if not NULL the floating point properties are compressed with this error bound (one for each property)
+	 * \param delta if not NULL only the part of the messages changed from the previous exchange are sent
 	 *
 	 */
 	template<typename op, typename T, typename S, template <typename> class layout_base>
@@ -177,8 +252,16 @@ class Vcluster: public Vcluster_base<InternalMemory>
 		openfpm::vector<size_t> & prc_send,
 		openfpm::vector<size_t> & prc_recv,
 		openfpm::vector<size_t> & sz_recv,
-		size_t opt
+		size_t opt,
+		const openfpm::vector<double> * err_bound = NULL,
+		Vcluster_delta * delta = NULL
 	) {
+		// the NBX used below are recorded as semantic send and receive
+		vcl_prof_scope ps(self_base::prof_sem,VCL_PROF_SSENDRECV);
+
+		double t_pack = self_base::trace.begin();
+		double t_pack_cnt = self_base::cnt.begin();
+
 		sz_recv_byte[NBX_prc_scnt].resize(sz_recv.size());
 
 		// Reset the receive buffer
@@ -253,11 +336,22 @@ class Vcluster: public Vcluster_base<InternalMemory>
 			pack_unpack_cond_with_prp<has_max_prop<T, has_value_type_ofp<T>::value>::value, op, T, S, layout_base>::packing(*mem[NBX_prc_scnt], send.get(i), sts, send_buf,opt);
 		}
 
+		lossy_active[NBX_prc_scnt] = false;
+		if (err_bound != NULL)
+		{lossy_encode<T,layout_base>(*err_bound);}
+
+		if (delta != NULL)
+		{delta_encode(*delta);}
+
+		self_base::trace.end("pack",t_pack);
+		self_base::cnt.time(VCL_TIME_PACK,t_pack_cnt);
+
 		// receive information
 		NBX_prc_bi[NBX_prc_scnt].set(&this->recv_buf[NBX_prc_scnt],prc_recv,sz_recv_byte[NBX_prc_scnt],this->tags[NBX_prc_scnt],opt);
 
-		// Send and recv multiple messages
-		if (opt & RECEIVE_KNOWN)
+		// Send and recv multiple messages (with several processing units per process the NBX discover
+		// the receive, so RECEIVE_KNOWN is ignored and prc_recv is filled)
+		if ((opt & RECEIVE_KNOWN) && self_base::getProcessingUnitsPerProcess() == 1)
 		{
 			// We we are passing the number of element but not the byte, calculate the byte
 			if (opt & KNOWN_ELEMENT_OR_BYTE)
@@ -289,10 +383,130 @@ class Vcluster: public Vcluster_base<InternalMemory>
 		{
 			self_base::tags[NBX_prc_scnt].clear();
 			prc_recv.clear();
-			self_base::sendrecvMultipleMessagesNBXAsync(prc_send_.size(),(size_t *)send_sz_byte.getPointer(),(size_t *)prc_send_.getPointer(),(void **)send_buf.getPointer(),msg_alloc,(void *)&NBX_prc_bi[NBX_prc_scnt]);
+			sz_recv_byte[NBX_prc_scnt].clear();
+			self_base::sendrecvMultipleMessagesNBXAsync(prc_send_.size(),(size_t *)send_sz_byte.getPointer(),(size_t *)prc_send_.getPointer(),(void **)send_buf.getPointer(),msg_alloc,(void *)&NBX_prc_bi[NBX_prc_scnt],opt);
+		}
+	}
+
+
+	/*! \brief Encode the send buffers with error bounded lossy compression
+	 *
+	 * \param err_bound error bound for each property (0 mean lossless)
+	 *
+	 */
+	template<typename T, template <typename> class layout_base>
+	void lossy_encode(const openfpm::vector<double> & err_bound)
+	{
+		size_t ele_size = 1;
+
+		lossy_fields.clear();
+		lossy_active[NBX_prc_scnt] = lossy_encode_selector<T,layout_base>::fields(lossy_fields,err_bound,ele_size);
+
+		if (lossy_active[NBX_prc_scnt] == false)
+		{return;}
+
+		lossy_buf[NBX_prc_scnt].resize(send_buf.size());
+
+		for (size_t i = 0 ; i < send_buf.size() ; i++)
+		{
+			// empty messages are not sent
+			if (send_sz_byte.get(i) == 0)
+			{continue;}
+
+			Vcluster_lossy::encode(send_buf.get(i),send_sz_byte.get(i) / ele_size,ele_size,lossy_fields,lossy_buf[NBX_prc_scnt][i]);
+
+			send_buf.get(i) = lossy_buf[NBX_prc_scnt][i].data();
+			send_sz_byte.get(i) = lossy_buf[NBX_prc_scnt][i].size();
+		}
+	}
+
+	/*! \brief Decode the receive buffers encoded with lossy_encode
+	 *
+	 */
+	void lossy_decode()
+	{
+		if (lossy_active[NBX_prc_pcnt] == false)
+		{return;}
+
+		auto & rbuf = self_base::recv_buf[NBX_prc_pcnt];
+
+		for (size_t i = 0 ; i < rbuf.size() ; i++)
+		{
+			size_t n = rbuf.get(i).size();
+
+			lossy_tmp.resize(n);
+			memcpy(lossy_tmp.data(),rbuf.get(i).getPointer(),n);
+
+			rbuf.get(i).resize(Vcluster_lossy::raw_size(lossy_tmp.data()));
+
+			if (Vcluster_lossy::decode(lossy_tmp.data(),n,lossy_fields,rbuf.get(i).getPointer()) == false)
+			{std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " corrupted lossy compressed message" << std::endl;}
+		}
+
+		lossy_active[NBX_prc_pcnt] = false;
+	}
+
+	/*! \brief Encode the send buffers sending only the changes from the previous exchange
+	 *
+	 * \param delta state of the exchange
+	 *
+	 */
+	void delta_encode(Vcluster_delta & delta)
+	{
+		delta_buf[NBX_prc_scnt].resize(send_buf.size());
+		delta_occ.clear();
+
+		for (size_t i = 0 ; i < send_buf.size() ; i++)
+		{
+			// empty messages are not sent
+			if (send_sz_byte.get(i) == 0)
+			{continue;}
+
+			size_t p = prc_send_.get(i);
+
+			delta.encode(p,delta_occ[p]++,send_buf.get(i),send_sz_byte.get(i),delta_buf[NBX_prc_scnt][i]);
+
+			send_buf.get(i) = delta_buf[NBX_prc_scnt][i].data();
+			send_sz_byte.get(i) = delta_buf[NBX_prc_scnt][i].size();
 		}
 	}
 
+	/*! \brief Reconstruct the full messages of a delta exchange
+	 *
+	 * \param delta state of the exchange
+	 * \param prc_recv processors from which we received (one or more buffers for each processor)
+	 *
+	 */
+	void delta_decode(Vcluster_delta & delta, openfpm::vector<size_t> & prc_recv)
+	{
+		auto & rbuf = self_base::recv_buf[NBX_prc_pcnt];
+
+		if (prc_recv.size() == 0)
+		{return;}
+
+		// In case of interleaved layout we have one buffer for each property
+		size_t nb = rbuf.size() / prc_recv.size();
+		if (nb == 0)
+		{nb = 1;}
+
+		delta_occ.clear();
+
+		for (size_t i = 0 ; i < rbuf.size() ; i++)
+		{
+			size_t p = prc_recv.get(i / nb);
+
+			const std::vector<unsigned char> * full = delta.decode(p,delta_occ[p]++,rbuf.get(i).getPointer(),rbuf.get(i).size());
+
+			if (full == NULL)
+			{
+				std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " the delta message from processor " << p << " cannot be applied, did you call reset() on all processors ?" << std::endl;
+				continue;
+			}
+
+			rbuf.get(i).resize(full->size());
+			memcpy(rbuf.get(i).getPointer(),full->data(),full->size());
+		}
+	}
 
 	/*! \brief Reset the receive buffer
 	 *
@@ -406,368 +620,1849 @@ class Vcluster: public Vcluster_base<InternalMemory>
 		op & op_param,
 		size_t opt
 	) {
+		vcl_trace_scope ts(self_base::trace,"unpack");
+		vcl_time_scope tc(self_base::cnt,VCL_TIME_UNPACK);
+
 		if (sz != NULL)
 		{sz->resize(self_base::recv_buf[NBX_prc_pcnt].size());}
 
 		pack_unpack_cond_with_prp<has_max_prop<T, has_value_type_ofp<T>::value>::value,op, T, S, layout_base, prp... >::unpacking(recv, self_base::recv_buf[NBX_prc_pcnt], sz, sz_byte, op_param,opt);
 	}
 
-	public:
-
-	/*! \brief Constructor
+	/*! \brief Get the packed send buffers as one contiguous buffer
 	 *
-	 * \param argc main number of arguments
-	 * \param argv main set of arguments
+	 * Serialized objects are already packed contiguously and are used directly, vectors of
+	 * primitives or aggregates are copied in a2a_sbuf
+	 *
+	 * \param tot_send total size in byte (output)
+	 *
+	 * \return the pointer to the contiguous buffer
 	 *
 	 */
-	Vcluster(int *argc, char ***argv, MPI_Comm ext_comm = MPI_COMM_WORLD)
-	:Vcluster_base<InternalMemory>(argc,argv, ext_comm)
+	const void * contiguous_send_buf(size_t & tot_send)
 	{
+		bool contiguous = true;
+		tot_send = 0;
+
+		for (size_t i = 0 ; i < send_buf.size() ; i++)
+		{
+			if (i != 0 && (const char *)send_buf.get(i) != (const char *)send_buf.get(i-1) + send_sz_byte.get(i-1))
+			{contiguous = false;}
+
+			tot_send += send_sz_byte.get(i);
+		}
+
+		if (contiguous == true)
+		{return (send_buf.size() != 0)?send_buf.get(0):NULL;}
+
+		a2a_sbuf.resize(tot_send);
+
+		size_t pos = 0;
+		for (size_t i = 0 ; i < send_buf.size() ; i++)
+		{
+			memcpy(a2a_sbuf.data() + pos,send_buf.get(i),send_sz_byte.get(i));
+			pos += send_sz_byte.get(i);
+		}
+
+		return a2a_sbuf.data();
 	}
 
-	/*! \brief Semantic Gather, gather the data from all processors into one node
+	/*! \brief Return true if the messages of the collectives must be recorded
 	 *
-	 * Semantic communication differ from the normal one. They in general
-	 * follow the following model.
+	 * \return true if the profiler or the histograms are active
 	 *
-	 * Gather(T,S,root,op=add);
+	 */
+	inline bool coll_record()
+	{
+		return self_base::prof.isActive() == true || self_base::hist.isActive() == true;
+	}
+
+	/*! \brief Record a message sent by a collective in the profiler and in the histograms
 	 *
-	 * "Gather" indicate the communication pattern, or how the information flow
-	 * T is the object to send, S is the object that will receive the data.
-	 * In order to work S must implement the interface S.add(T).
+	 * \param peer destination
+	 * \param bytes size of the message
 	 *
-	 * ### Example send a vector of structures, and merge all together in one vector
-	 * \snippet VCluster_semantic_unit_tests.hpp Gather the data on master
+	 */
+	inline void coll_send(size_t peer, size_t bytes)
+	{
+		self_base::prof.send(VCL_PROF_COLLECTIVE,peer,bytes);
+		self_base::hist.size(VCL_PROF_COLLECTIVE,bytes);
+	}
+
+	/*! \brief Record in the profiler the messages received by a collective
 	 *
-	 * ### Example send a vector of structures, and merge all together in one vector
-	 * \snippet VCluster_semantic_unit_tests.hpp Gather the data on master complex
+	 * \param prc processors of the messages in the receive buffer (the own processor is skipped)
+	 * \param nb number of buffers for each message
 	 *
-	 * \tparam T type of sending object
-	 * \tparam S type of receiving object
+	 */
+	void prof_collective_recv(const openfpm::vector<size_t> & prc, size_t nb)
+	{
+		auto & rbuf = self_base::recv_buf[NBX_prc_scnt];
+
+		for (size_t i = 0 ; i < prc.size() ; i++)
+		{
+			size_t tot = 0;
+			for (size_t j = 0 ; j < nb ; j++)
+			{tot += rbuf.get(i*nb + j).size();}
+
+			if (prc.get(i) != self_base::getProcessUnitID())
+			{self_base::prof.recv(VCL_PROF_COLLECTIVE,prc.get(i),tot);}
+		}
+	}
+
+	/*! \brief Split the buffer received by a collective in the receive buffers
 	 *
-	 * \param send Object to send
-	 * \param recv Object to receive
-	 * \param root witch node should collect the information
+	 * The messages are in processor order, empty messages are skipped
 	 *
-	 * \return true if the function completed succefully
+	 * \param nb number of buffers for each message (one for each property with interleaved layout)
+	 * \param prc_recv processors from which we received (output)
+	 * \param buf received data (the message of the processor i start at displ.get(i))
+	 * \param displ displacement of the message of each processor
 	 *
 	 */
-	template<typename T, typename S, template <typename> class layout_base=memory_traits_lin> bool SGather(T & send, S & recv,size_t root)
+	template<typename displ_type>
+	void split_collective_recv(size_t nb, openfpm::vector<size_t> & prc_recv, const unsigned char * buf, const openfpm::vector<displ_type> & displ)
 	{
-		openfpm::vector<size_t> prc;
-		openfpm::vector<size_t> sz;
+		prc_recv.clear();
+		auto & rbuf = self_base::recv_buf[NBX_prc_scnt];
 
-		return SGather<T,S,layout_base>(send,recv,prc,sz,root);
-	}
+		for (size_t i = 0 ; i < displ.size() ; i++)
+		{
+			size_t tot = 0;
+			for (size_t j = 0 ; j < nb ; j++)
+			{tot += a2a_sz_recv.get(i*nb + j);}
 
-	//! metafunction
-	template<size_t index, size_t N> struct MetaFuncOrd {
-	   enum { value = index };
-	};
+			if (tot == 0)
+			{continue;}
 
-	/*! \brief Semantic Gather, gather the data from all processors into one node
+			size_t rpos = displ.get(i);
+			for (size_t j = 0 ; j < nb ; j++)
+			{
+				size_t sz = a2a_sz_recv.get(i*nb + j);
+
+				rbuf.add();
+				rbuf.last().resize(sz);
+				memcpy(rbuf.last().getPointer(),buf + rpos,sz);
+				rpos += sz;
+			}
+
+			prc_recv.add(i);
+		}
+	}
+
+	/*! \brief Split the buffer received by a collective in the receive buffers
 	 *
-	 * Semantic communication differ from the normal one. They in general
-	 * follow the following model.
+	 * \param nb number of buffers for each message
+	 * \param prc_recv processors from which we received (output)
+	 * \param buf received data (the message of the processor i start at a2a_rdispl.get(i))
 	 *
-	 * Gather(T,S,root,op=add);
+	 */
+	void split_collective_recv(size_t nb, openfpm::vector<size_t> & prc_recv, const unsigned char * buf)
+	{
+		split_collective_recv(nb,prc_recv,buf,a2a_rdispl);
+	}
+
+	/*! \brief Compute the receive counts and displacements of a collective from a2a_sz_recv
 	 *
-	 * "Gather" indicate the communication pattern, or how the information flow
-	 * T is the object to send, S is the object that will receive the data.
-	 * In order to work S must implement the interface S.add(T).
+	 * \param np number of processors
+	 * \param nb number of buffers for each message
 	 *
-	 * ### Example send a vector of structures, and merge all together in one vector
-	 * \snippet VCluster_semantic_unit_tests.hpp Gather the data on master
+	 * \return the total size to receive
 	 *
-	 * ### Example send a vector of structures, and merge all together in one vector
-	 * \snippet VCluster_semantic_unit_tests.hpp Gather the data on master complex
+	 */
+	size_t collective_recv_displ(size_t np, size_t nb)
+	{
+		a2a_rcnt.resize(np);
+		a2a_rdispl.resize(np);
+
+		size_t tot_recv = 0;
+		for (size_t i = 0 ; i < np ; i++)
+		{
+			size_t sz = 0;
+			for (size_t j = 0 ; j < nb ; j++)
+			{sz += a2a_sz_recv.get(i*nb + j);}
+
+			a2a_rcnt.get(i) = sz;
+			a2a_rdispl.get(i) = tot_recv;
+			tot_recv += sz;
+		}
+
+		return tot_recv;
+	}
+
+	/*! \brief Pack one object in the send buffers (send_buf, send_sz_byte)
 	 *
-	 * \tparam T type of sending object
-	 * \tparam S type of receiving object
+	 * \param send object to pack
+	 * \param mem memory where serialized objects are packed (allocated here, must be released by the caller)
+	 * \param pmem heap memory used by mem
+	 * \param opt options
 	 *
-	 * \param send Object to send
-	 * \param recv Object to receive
-	 * \param root witch node should collect the information
-	 * \param prc processors from witch we received the information
-	 * \param sz size of the received information for each processor
+	 */
+	template<typename T, typename S, template <typename> class layout_base>
+	void pack_collective(T & send, ExtPreAlloc<HeapMemory> * & mem, HeapMemory & pmem, size_t opt)
+	{
+		size_t tot_size = 0;
+
+		//Pack requesting
+		pack_unpack_cond_with_prp<has_max_prop<T, has_value_type_ofp<T>::value>::value,op_ssend_recv_add<void>, T, S, layout_base>::packingRequest(send, tot_size, send_sz_byte);
+
+		mem = new ExtPreAlloc<HeapMemory>(tot_size,pmem);
+		mem->incRef();
+
+		//Packing
+		Pack_stat sts;
+
+		pack_unpack_cond_with_prp<has_max_prop<T, has_value_type_ofp<T>::value>::value, op_ssend_recv_add<void>, T, S, layout_base>::packing(*mem, send, sts, send_buf,opt);
+	}
+
+	/*! \brief Number of buffers produced by the packing of an object of type T
 	 *
-	 * \return true if the function completed succefully
+	 * It is one for serialized objects and vectors with linear layout, one for each property
+	 * for vectors with interleaved layout
+	 *
+	 * \return the number of buffers
 	 *
 	 */
-	template<typename T,
-		typename S,
-		template <typename> class layout_base = memory_traits_lin>
-	bool SGather(
-		T & send,
-		S & recv,
-		openfpm::vector<size_t> & prc,
-		openfpm::vector<size_t> & sz,
-	size_t root)
+	template<typename T, typename S, template <typename> class layout_base>
+	size_t n_pack_buffers()
 	{
-#ifdef SE_CLASS1
-		if (&send == (T *)&recv)
-		{std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " using SGather in general the sending object and the receiving object must be different" << std::endl;}
-#endif
+		T empty;
+		size_t tot_size = 0;
+		openfpm::vector<size_t> sz;
 
-		// Reset the receive buffer
-		reset_recv_buf();
+		pack_unpack_cond_with_prp<has_max_prop<T, has_value_type_ofp<T>::value>::value,op_ssend_recv_add<void>, T, S, layout_base>::packingRequest(empty, tot_size, sz);
 
-		// If we are on master collect the information
-		if (self_base::getProcessUnitID() == root)
+		return sz.size();
+	}
+
+	/*! \brief Send a message of the tree collectives
+	 *
+	 * The size is sent first, the message follow in parts of at most tree_chunk byte, so there is
+	 * no limit of 2GB
+	 *
+	 * \param buf message
+	 * \param sz size of the message
+	 * \param dest destination processor
+	 *
+	 */
+	void tree_send(const unsigned char * buf, size_t sz, size_t dest)
+	{
+		MPI_SAFE_CALL(MPI_Send(&sz,1,MPI_UNSIGNED_LONG,dest,GATHER_BASE,self_base::getMPIComm()));
+
+		for (size_t pos = 0 ; pos < sz ; pos += tree_chunk)
 		{
-			// send buffer (master does not send anything) so send req and send_buf
-			// remain buffer with size 0
-			openfpm::vector<size_t> send_req;
+			size_t cnt = (sz - pos < tree_chunk)?sz - pos:tree_chunk;
+			MPI_SAFE_CALL(MPI_Send(buf + pos,cnt,MPI_BYTE,dest,GATHER_BASE,self_base::getMPIComm()));
+		}
+	}
 
-			self_base::tags[NBX_prc_scnt].clear();
+	/*! \brief Receive a message of the tree collectives (sent with tree_send) at the end of tree_buf
+	 *
+	 * \param src source processor
+	 *
+	 */
+	void tree_recv(size_t src)
+	{
+		size_t sz;
+		MPI_SAFE_CALL(MPI_Recv(&sz,1,MPI_UNSIGNED_LONG,src,GATHER_BASE,self_base::getMPIComm(),MPI_STATUS_IGNORE));
 
-			// receive information
-			base_info<InternalMemory> bi(&this->recv_buf[NBX_prc_scnt],prc,sz,this->tags[NBX_prc_scnt],0);
+		size_t start = tree_buf.size();
+		tree_buf.resize(start + sz);
 
-			// Send and recv multiple messages
-			self_base::sendrecvMultipleMessagesNBX(send_req.size(),NULL,NULL,NULL,msg_alloc,&bi);
+		for (size_t pos = 0 ; pos < sz ; pos += tree_chunk)
+		{
+			size_t cnt = (sz - pos < tree_chunk)?sz - pos:tree_chunk;
+			MPI_SAFE_CALL(MPI_Recv(tree_buf.data() + start + pos,cnt,MPI_BYTE,src,GATHER_BASE,self_base::getMPIComm(),MPI_STATUS_IGNORE));
+		}
+	}
 
-			// we generate the list of the properties to unpack
-			typedef typename ::generate_indexes<int, has_max_prop<T, has_value_type_ofp<T>::value>::number, MetaFuncOrd>::result ind_prop_to_pack;
+	/*! \brief Gather the packed send buffers on root along a binomial tree
+	 *
+	 * Every processor receive the data of its sub-tree, append them to its own message and send
+	 * everything to its parent, so the root receive log(P) messages. The data are stored as records
+	 * (processor, size of each buffer, payload), on root the records are split in receive buffers
+	 * in order of processor
+	 *
+	 * \param root processor that collect the data
+	 * \param nb number of buffers for each message
+	 * \param prc processors from which we received (output, only on root)
+	 *
+	 */
+	void gather_tree(size_t root, size_t nb, openfpm::vector<size_t> & prc)
+	{
+		size_t np = self_base::getProcessingUnits();
+		size_t rank = self_base::getProcessUnitID();
+		size_t vr = (rank + np - root) % np;
 
-			// operation object
-			op_ssend_recv_add<void> opa;
+		size_t tot_send = 0;
+		const void * sbuf = contiguous_send_buf(tot_send);
 
-			// Reorder the buffer
-			reorder_buffer(prc,self_base::tags[NBX_prc_scnt],sz);
+		// own record (empty messages are not sent)
+		tree_buf.clear();
+		if (tot_send != 0)
+		{
+			uint64_t p = rank;
+			tree_buf.resize(sizeof(uint64_t)*(nb+1) + tot_send);
+			memcpy(tree_buf.data(),&p,sizeof(uint64_t));
 
-			index_gen<ind_prop_to_pack>::template process_recv<op_ssend_recv_add<void>,T,S,layout_base>(*this,recv,&sz,NULL,opa,0);
+			for (size_t j = 0 ; j < nb ; j++)
+			{
+				uint64_t sz = send_sz_byte.get(j);
+				memcpy(tree_buf.data() + sizeof(uint64_t)*(j+1),&sz,sizeof(uint64_t));
+			}
 
-			recv.add(send);
-			prc.add(root);
-			sz.add(send.size());
+			memcpy(tree_buf.data() + sizeof(uint64_t)*(nb+1),sbuf,tot_send);
 		}
-		else
+
+		for (size_t mask = 1 ; mask < np ; mask <<= 1)
 		{
-			// send buffer (master does not send anything) so send req and send_buf
-			// remain buffer with size 0
-			openfpm::vector<size_t> send_prc;
-			openfpm::vector<size_t> send_prc_;
-			send_prc.add(root);
+			if (vr & mask)
+			{
+				// send the sub-tree to the parent
+				size_t parent = (vr - mask + root) % np;
+
+				tree_send(tree_buf.data(),tree_buf.size(),parent);
+				break;
+			}
+			else if (vr + mask < np)
+			{
+				// receive the sub-tree of the child
+				size_t child = (vr + mask + root) % np;
+
+				tree_recv(child);
+			}
+		}
+
+		if (rank != root)
+		{return;}
+
+		// index the records by processor (processors without record have zero sizes)
+		tree_rdispl.resize(np);
+		a2a_sz_recv.resize(np*nb);
+
+		for (size_t i = 0 ; i < np*nb ; i++)
+		{a2a_sz_recv.get(i) = 0;}
+
+		size_t pos = 0;
+		while (pos < tree_buf.size())
+		{
+			uint64_t p;
+			memcpy(&p,tree_buf.data() + pos,sizeof(uint64_t));
+
+			size_t tot = 0;
+			for (size_t j = 0 ; j < nb ; j++)
+			{
+				uint64_t sz;
+				memcpy(&sz,tree_buf.data() + pos + sizeof(uint64_t)*(j+1),sizeof(uint64_t));
+				a2a_sz_recv.get(p*nb + j) = sz;
+				tot += sz;
+			}
+
+			pos += sizeof(uint64_t)*(nb+1);
+
+			tree_rdispl.get(p) = pos;
+
+			pos += tot;
+		}
+
+		// split in processor order
+		split_collective_recv(nb,prc,tree_buf.data(),tree_rdispl);
+	}
+
+	/*! \brief Scatter the chunks from root along a binomial tree
+	 *
+	 * Root build the records (size of each buffer, payload) in order of distance from root. Every
+	 * processor receive from its parent the records of its sub-tree, forward to its children their
+	 * parts and keep the first record. On root the chunk of the processor i start at scatter_sdispl.get(i)
+	 * in sbuf, and a2a_ssz contain the sizes of its buffers
+	 *
+	 * \param root processor that scatter the data
+	 * \param nb number of buffers for each message
+	 * \param sbuf send buffer (only root)
+	 *
+	 */
+	void scatter_tree(size_t root, size_t nb, const void * sbuf)
+	{
+		size_t np = self_base::getProcessingUnits();
+		size_t rank = self_base::getProcessUnitID();
+		size_t vr = (rank + np - root) % np;
+		size_t hd = sizeof(uint64_t)*nb;
+
+		// span of the sub-tree
+		size_t span = 1;
+		while (span < np)
+		{span <<= 1;}
+
+		tree_buf.clear();
+
+		if (vr == 0)
+		{
+			for (size_t v = 0 ; v < np ; v++)
+			{
+				size_t r = (v + root) % np;
+				size_t pos = tree_buf.size();
+
+				size_t tot = 0;
+				for (size_t j = 0 ; j < nb ; j++)
+				{tot += a2a_ssz.get(r*nb + j);}
+
+				tree_buf.resize(pos + hd + tot);
+
+				for (size_t j = 0 ; j < nb ; j++)
+				{
+					uint64_t sz = a2a_ssz.get(r*nb + j);
+					memcpy(tree_buf.data() + pos + j*sizeof(uint64_t),&sz,sizeof(uint64_t));
+				}
+
+				memcpy(tree_buf.data() + pos + hd,(const unsigned char *)sbuf + scatter_sdispl.get(r),tot);
+			}
+		}
+		else
+		{
+			span = vr & (~vr + 1);
+			size_t parent = (vr - span + root) % np;
+
+			tree_recv(parent);
+		}
+
+		// offsets of the records of the sub-tree
+		size_t n_rec = (vr + span < np)?span:np - vr;
+		std::vector<size_t> off(n_rec+1);
+
+		off[0] = 0;
+		for (size_t k = 0 ; k < n_rec ; k++)
+		{
+			size_t tot = 0;
+			for (size_t j = 0 ; j < nb ; j++)
+			{
+				uint64_t sz;
+				memcpy(&sz,tree_buf.data() + off[k] + j*sizeof(uint64_t),sizeof(uint64_t));
+				tot += sz;
+			}
+
+			off[k+1] = off[k] + hd + tot;
+		}
+
+		// forward to the children
+		for (size_t mask = span >> 1 ; mask > 0 ; mask >>= 1)
+		{
+			if (vr + mask >= np)
+			{continue;}
+
+			size_t child = (vr + mask + root) % np;
+			size_t last = (mask + mask < n_rec)?mask + mask:n_rec;
+
+			tree_send(tree_buf.data() + off[mask],off[last] - off[mask],child);
+		}
+
+		// keep the first record
+		if (off[1] == hd)
+		{return;}
+
+		a2a_sz_recv.resize(nb);
+		for (size_t j = 0 ; j < nb ; j++)
+		{
+			uint64_t sz;
+			memcpy(&sz,tree_buf.data() + j*sizeof(uint64_t),sizeof(uint64_t));
+			a2a_sz_recv.get(j) = sz;
+		}
+
+		tree_rdispl.resize(1);
+		tree_rdispl.get(0) = hd;
+
+		openfpm::vector<size_t> prc_recv;
+		split_collective_recv(nb,prc_recv,tree_buf.data(),tree_rdispl);
+	}
+
+	/*! \brief View on a sub-communicator (or on a duplicate for the thread contexts)
+	 *
+	 * \param parent Vcluster from which the view is created
+	 * \param sub sub-communicator
+	 *
+	 */
+	Vcluster(Vcluster<InternalMemory> & parent, MPI_Comm sub)
+	:Vcluster_base<InternalMemory>(parent,sub)
+	{
+	}
+
+	/*! \brief Get a cached view or create it
+	 *
+	 * \param key kind of view with its parameters
+	 * \param comm_create function that create the sub-communicator (collective)
+	 *
+	 * \return the view
+	 *
+	 */
+	template<typename F> Vcluster<InternalMemory> & get_view(const std::vector<long int> & key, F comm_create)
+	{
+		auto it = sub_vcl.find(key);
+
+		if (it != sub_vcl.end())
+		{return *it->second.first;}
+
+		MPI_Comm sub;
+		comm_create(sub);
+
+		Vcluster<InternalMemory> * v = new Vcluster<InternalMemory>(*this,sub);
+		sub_vcl[key] = std::make_pair(v,sub);
+
+		return *v;
+	}
+
+	public:
+
+	/*! \brief Constructor
+	 *
+	 * \param argc main number of arguments
+	 * \param argv main set of arguments
+	 *
+	 */
+	Vcluster(int *argc, char ***argv, MPI_Comm ext_comm = MPI_COMM_WORLD)
+	:Vcluster_base<InternalMemory>(argc,argv, ext_comm)
+	{
+	}
+
+	//! Destructor
+	~Vcluster()
+	{
+		destroyPEContexts();
+		destroyThreadContexts();
+		freeViews();
+	}
+
+	/*! \brief Create the communication contexts for the threads
+	 *
+	 * Each context is an independent Vcluster on a duplicate of the communicator, with its own
+	 * requests, NBX state and receive buffers, so n threads can communicate at the same time (each
+	 * thread use only its context). The contexts share the gpu context and the NBX parameters of
+	 * this Vcluster. Every context is usable with all the functions of Vcluster.
+	 * MPI must support MPI_THREAD_MULTIPLE (see VCLUSTER_THREAD_MULTIPLE)
+	 *
+	 * \code
+	 * vcl.createThreadContexts(omp_get_max_threads());
+	 *
+	 * #pragma omp parallel
+	 * {
+	 *   Vcluster<> & tcl = vcl.getThreadContext(omp_get_thread_num());
+	 *   tcl.SSendRecv(...);
+	 * }
+	 * \endcode
+	 *
+	 * \warning it is a collective operation and it must be called from one thread
+	 *
+	 * \param n number of contexts
+	 *
+	 * \return false if MPI does not support MPI_THREAD_MULTIPLE
+	 *
+	 */
+	bool createThreadContexts(size_t n)
+	{
+		if (n > 1 && self_base::isThreadMultiple() == false)
+		{
+			std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " concurrent communication require MPI initialized with MPI_THREAD_MULTIPLE (compile with VCLUSTER_THREAD_MULTIPLE or initialize MPI with MPI_Init_thread)" << std::endl;
+			return false;
+		}
+
+		destroyThreadContexts();
+
+		thr_comm.resize(n);
+		thr_ctx.resize(n);
+
+		for (size_t i = 0 ; i < n ; i++)
+		{
+			MPI_SAFE_CALL(MPI_Comm_dup(self_base::getMPIComm(),&thr_comm[i]));
+			thr_ctx[i] = new Vcluster<InternalMemory>(*this,thr_comm[i]);
+		}
+
+		return true;
+	}
+
+	/*! \brief Get the communication context of a thread
+	 *
+	 * \param i context (usually the thread id)
+	 *
+	 * \return the context
+	 *
+	 */
+	Vcluster<InternalMemory> & getThreadContext(size_t i)
+	{
+#ifdef SE_CLASS1
+		if (i >= thr_ctx.size())
+		{std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " thread context " << i << " does not exist, call createThreadContexts first" << std::endl;}
+#endif
+
+		return *thr_ctx[i];
+	}
+
+	/*! \brief Number of communication contexts for the threads
+	 *
+	 * \return the number of contexts
+	 *
+	 */
+	size_t getNThreadContexts()
+	{
+		return thr_ctx.size();
+	}
+
+	//! Destroy the communication contexts of the threads (collective)
+	void destroyThreadContexts()
+	{
+		for (size_t i = 0 ; i < thr_ctx.size() ; i++)
+		{
+			delete thr_ctx[i];
+			MPI_Comm_free(&thr_comm[i]);
+		}
+
+		thr_ctx.clear();
+		thr_comm.clear();
+	}
+
+	/*! \brief Create n processing units in this process (hybrid mode)
+	 *
+	 * Every processing unit is a Vcluster that look like a processor to the sparse exchanges, size()
+	 * return the number of processes multiplied by n and the processing unit p of the process r has
+	 * getProcessUnitID() r*n+p. The processing units are used by n threads (one for each), the sparse
+	 * exchanges (SSendRecv, SSendRecvP, ... and the sendrecvMultipleMessagesNBX family) address the
+	 * processing units. Messages between the processing units of the same process are copied by the
+	 * receiver from the send buffer, the others go through MPI.
+	 *
+	 * \code
+	 * vcl.createPEContexts(4);
+	 *
+	 * #pragma omp parallel num_threads(4)
+	 * {
+	 *   Vcluster<> & pcl = vcl.getPEContext(omp_get_thread_num());
+	 *   pcl.SSendRecv(send,recv,prc_send,prc_recv,sz_recv);
+	 * }
+	 * \endcode
+	 *
+	 * \warning collectives (sum, max, allGather, SGather, ...) and send/recv address the processes,
+	 *          use them on this Vcluster (on a processing unit they fail with an error). With several
+	 *          processing units RECEIVE_KNOWN is ignored
+	 *
+	 * \warning it is a collective operation and it must be called from one thread
+	 *
+	 * \param n number of processing units per process
+	 *
+	 * \return false if MPI does not support MPI_THREAD_MULTIPLE
+	 *
+	 */
+	bool createPEContexts(size_t n)
+	{
+		if (n > 1 && self_base::isThreadMultiple() == false)
+		{
+			std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " processing units require MPI initialized with MPI_THREAD_MULTIPLE (compile with VCLUSTER_THREAD_MULTIPLE or initialize MPI with MPI_Init_thread)" << std::endl;
+			return false;
+		}
+
+		destroyPEContexts();
+
+		pe_units = new Vcluster_pe_group(n,self_base::getMPIComm());
+		pe_ctx.resize(n);
+
+		for (size_t i = 0 ; i < n ; i++)
+		{
+			pe_ctx[i] = new Vcluster<InternalMemory>(*this,pe_units->getComm(i));
+			pe_ctx[i]->setPE(pe_units,i);
+		}
+
+		return true;
+	}
+
+	/*! \brief Get a processing unit of this process
+	 *
+	 * \param p processing unit (usually the thread id)
+	 *
+	 * \return the processing unit
+	 *
+	 */
+	Vcluster<InternalMemory> & getPEContext(size_t p)
+	{
+#ifdef SE_CLASS1
+		if (p >= pe_ctx.size())
+		{std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " processing unit " << p << " does not exist, call createPEContexts first" << std::endl;}
+#endif
+
+		return *pe_ctx[p];
+	}
+
+	/*! \brief Number of processing units of this process
+	 *
+	 * \return the number of processing units (0 if createPEContexts has not been called)
+	 *
+	 */
+	size_t getNPEContexts()
+	{
+		return pe_ctx.size();
+	}
+
+	//! Destroy the processing units of this process (collective)
+	void destroyPEContexts()
+	{
+		for (size_t i = 0 ; i < pe_ctx.size() ; i++)
+		{delete pe_ctx[i];}
+
+		pe_ctx.clear();
+
+		delete pe_units;
+		pe_units = NULL;
+	}
+
+	/*! \brief Get a Vcluster on a sub-set of the processors (like MPI_Comm_split)
+	 *
+	 * The view is created the first time and cached, so the next calls are free. The view is a
+	 * complete Vcluster (reductions, semantic communications, ...) on the sub-communicator
+	 *
+	 * \code
+	 * // row and column reductions on a nx * ny grid of processors
+	 * Vcluster<> & row = vcl.split(0,rank / nx, rank % nx);
+	 * Vcluster<> & col = vcl.split(1,rank % nx, rank / nx);
+	 * row.sum(row_val);
+	 * row.execute();
+	 * \endcode
+	 *
+	 * The cache is keyed on the view id and not on (color,key), because the pair of a processor
+	 * can be the same for two different splits (like on the diagonal of the grid above), and a
+	 * processor that find the view in the cache would skip the collective of the other processors
+	 *
+	 * \warning it is collective the first time the view id is used, all the processors must use
+	 *          the same view id for the same split, and the same (color,key) every time they use it
+	 *
+	 * \param id view id (the same on all the processors)
+	 * \param color processors with the same color are in the same view
+	 * \param key order of the processors in the view
+	 *
+	 * \return the view
+	 *
+	 */
+	Vcluster<InternalMemory> & split(size_t id, int color, int key)
+	{
+		return get_view({0,(long int)id},[&](MPI_Comm & sub)
+		{
+			MPI_SAFE_CALL(MPI_Comm_split(self_base::getMPIComm(),color,key,&sub));
+		});
+	}
+
+	/*! \brief Get a Vcluster on the processors of the same node (shared memory)
+	 *
+	 * \see split
+	 *
+	 * \return the view
+	 *
+	 */
+	Vcluster<InternalMemory> & node()
+	{
+		return get_view({1},[&](MPI_Comm & sub)
+		{
+			MPI_SAFE_CALL(MPI_Comm_split_type(self_base::getMPIComm(),MPI_COMM_TYPE_SHARED,self_base::getProcessUnitID(),MPI_INFO_NULL,&sub));
+		});
+	}
+
+	/*! \brief Get a Vcluster on the node leaders
+	 *
+	 * The first processor of each node get the view with the first processors of all the nodes.
+	 * In general the processor with rank i within its node get the view with the processors
+	 * of rank i within their nodes
+	 *
+	 * \see split
+	 *
+	 * \return the view
+	 *
+	 */
+	Vcluster<InternalMemory> & leaders()
+	{
+		return get_view({2},[&](MPI_Comm & sub)
+		{
+			int color = node().getProcessUnitID();
+			MPI_SAFE_CALL(MPI_Comm_split(self_base::getMPIComm(),color,self_base::getProcessUnitID(),&sub));
+		});
+	}
+
+	/*! \brief Get a Vcluster on a slice of a cartesian grid of processors
+	 *
+	 * The processors are placed in rank order on a grid (the first direction is the fastest) and the
+	 * view contain the processors that have the same coordinates in the directions that are not kept
+	 *
+	 * \code
+	 * // rows of a 4x3 grid of processors
+	 * size_t grid[2] = {4,3};
+	 * bool keep[2] = {true,false};
+	 * Vcluster<> & row = vcl.cartSub(grid,keep);
+	 * \endcode
+	 *
+	 * \see split
+	 *
+	 * \param grid number of processors in each direction (the product must be the number of processors)
+	 * \param keep directions kept in the view
+	 *
+	 * \return the view
+	 *
+	 */
+	template<unsigned int dim> Vcluster<InternalMemory> & cartSub(const size_t (& grid)[dim], const bool (& keep)[dim])
+	{
+		size_t tot = 1;
+		std::vector<long int> key;
+		key.push_back(3);
+
+		for (size_t i = 0 ; i < dim ; i++)
+		{
+			tot *= grid[i];
+			key.push_back(grid[i]);
+			key.push_back(keep[i]);
+		}
+
+		if (tot != self_base::getProcessingUnits())
+		{
+			std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " the grid has " << tot << " processors but there are " << self_base::getProcessingUnits() << " processors" << std::endl;
+			return *this;
+		}
+
+		return get_view(key,[&](MPI_Comm & sub)
+		{
+			// MPI use the last direction as the fastest
+			int dims[dim];
+			int periods[dim];
+			int remain[dim];
+
+			for (size_t i = 0 ; i < dim ; i++)
+			{
+				dims[i] = grid[dim - 1 - i];
+				periods[i] = 0;
+				remain[i] = keep[dim - 1 - i];
+			}
+
+			MPI_Comm cart;
+			MPI_SAFE_CALL(MPI_Cart_create(self_base::getMPIComm(),dim,dims,periods,0,&cart));
+			MPI_SAFE_CALL(MPI_Cart_sub(cart,remain,&sub));
+			MPI_SAFE_CALL(MPI_Comm_free(&cart));
+		});
+	}
+
+	/*! \brief Get a Vcluster where the processors are reordered following the communication graph
+	 *
+	 * \see createGraphComm startGraphRecording
+	 *
+	 * \code
+	 * vcl.startGraphRecording();
+	 * // ... some exchanges
+	 * vcl.stopGraphRecording();
+	 *
+	 * Vcluster<> & rvcl = vcl.reordered();
+	 * // this processor run now the task rvcl.getProcessUnitID(), that was on the processor
+	 * // vcl.getProcessUnitID() == rvcl.getProcessUnitID() before the reordering
+	 * \endcode
+	 *
+	 * \param method GRAPH_REORDER_NODE or GRAPH_REORDER_MPI
+	 *
+	 * \return the view (cached, call freeViews to build it again from a new graph)
+	 *
+	 */
+	Vcluster<InternalMemory> & reordered(int method = GRAPH_REORDER_NODE)
+	{
+		return get_view({4,method},[&](MPI_Comm & sub)
+		{
+			sub = self_base::createGraphComm(method);
+		});
+	}
+
+	//! Free all the cached views (collective)
+	void freeViews()
+	{
+		for (auto & v : sub_vcl)
+		{
+			delete v.second.first;
+			MPI_Comm_free(&v.second.second);
+		}
+
+		sub_vcl.clear();
+	}
+
+	/*! \brief Semantic Gather, gather the data from all processors into one node
+	 *
+	 * Semantic communication differ from the normal one. They in general
+	 * follow the following model.
+	 *
+	 * Gather(T,S,root,op=add);
+	 *
+	 * "Gather" indicate the communication pattern, or how the information flow
+	 * T is the object to send, S is the object that will receive the data.
+	 * In order to work S must implement the interface S.add(T).
+	 *
+	 * ### Example send a vector of structures, and merge all together in one vector
+	 * \snippet VCluster_semantic_unit_tests.hpp Gather the data on master
+	 *
+	 * ### Example send a vector of structures, and merge all together in one vector
+	 * \snippet VCluster_semantic_unit_tests.hpp Gather the data on master complex
+	 *
+	 * \tparam T type of sending object
+	 * \tparam S type of receiving object
+	 *
+	 * \param send Object to send
+	 * \param recv Object to receive
+	 * \param root witch node should collect the information
+	 * \param opt options, GATHER_TREE aggregate the data along a binomial tree
+	 *
+	 * \return true if the function completed succefully
+	 *
+	 */
+	template<typename T, typename S, template <typename> class layout_base=memory_traits_lin> bool SGather(T & send, S & recv,size_t root, size_t opt = NONE)
+	{
+		openfpm::vector<size_t> prc;
+		openfpm::vector<size_t> sz;
+
+		return SGather<T,S,layout_base>(send,recv,prc,sz,root,opt);
+	}
+
+	//! metafunction
+	template<size_t index, size_t N> struct MetaFuncOrd {
+	   enum { value = index };
+	};
+
+	/*! \brief Semantic Gather, gather the data from all processors into one node
+	 *
+	 * Semantic communication differ from the normal one. They in general
+	 * follow the following model.
+	 *
+	 * Gather(T,S,root,op=add);
+	 *
+	 * "Gather" indicate the communication pattern, or how the information flow
+	 * T is the object to send, S is the object that will receive the data.
+	 * In order to work S must implement the interface S.add(T).
+	 *
+	 * ### Example send a vector of structures, and merge all together in one vector
+	 * \snippet VCluster_semantic_unit_tests.hpp Gather the data on master
+	 *
+	 * ### Example send a vector of structures, and merge all together in one vector
+	 * \snippet VCluster_semantic_unit_tests.hpp Gather the data on master complex
+	 *
+	 * \tparam T type of sending object
+	 * \tparam S type of receiving object
+	 *
+	 * \param send Object to send
+	 * \param recv Object to receive
+	 * \param root witch node should collect the information
+	 * \param prc processors from witch we received the information
+	 * \param sz size of the received information for each processor
+	 * \param opt options, GATHER_TREE aggregate the data along a binomial tree (the master receive
+	 *        log(P) messages instead of P-1)
+	 *
+	 * \return true if the function completed succefully
+	 *
+	 */
+	template<typename T,
+		typename S,
+		template <typename> class layout_base = memory_traits_lin>
+	bool SGather(
+		T & send,
+		S & recv,
+		openfpm::vector<size_t> & prc,
+		openfpm::vector<size_t> & sz,
+		size_t root,
+		size_t opt = NONE)
+	{
+		if (self_base::check_process_level("SGather") == false)
+		{return false;}
+
+#ifdef SE_CLASS1
+		if (&send == (T *)&recv)
+		{std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " using SGather in general the sending object and the receiving object must be different" << std::endl;}
+#endif
+
+		vcl_hist_scope hs(self_base::hist,VCL_PROF_COLLECTIVE);
+
+		size_t np = self_base::getProcessingUnits();
+		bool is_root = (self_base::getProcessUnitID() == root);
+
+		// Reset the receive buffer
+		reset_recv_buf();
+
+		// Prepare the sending buffer
+		send_buf.resize(0);
+		send_sz_byte.resize(0);
+
+		HeapMemory pmem;
+		ExtPreAlloc<HeapMemory> * mem = NULL;
+
+		if (is_root == false)
+		{pack_collective<T,S,layout_base>(send,mem,pmem,NONE);}
+		else
+		{
+			// master does not send anything, we need only the number of buffers of a message
+			size_t tot_size = 0;
+			pack_unpack_cond_with_prp<has_max_prop<T, has_value_type_ofp<T>::value>::value,op_ssend_recv_add<void>, T, S, layout_base>::packingRequest(send, tot_size, send_sz_byte);
+
+			for (size_t i = 0 ; i < send_sz_byte.size() ; i++)
+			{send_sz_byte.get(i) = 0;}
+		}
+
+		// buffers for each message (one for each property with interleaved layout)
+		size_t nb = send_sz_byte.size();
+
+		if (opt & GATHER_TREE)
+		{gather_tree(root,nb,prc);}
+		else
+		{
+			// gather the sizes
+			a2a_sz_recv.resize((is_root == true)?np*nb:0);
+
+			MPI_Request req_sz;
+			MPI_SAFE_CALL(MPI_Igather(send_sz_byte.getPointer(),nb,MPI_UNSIGNED_LONG,a2a_sz_recv.getPointer(),nb,MPI_UNSIGNED_LONG,root,self_base::getMPIComm(),&req_sz));
+
+			// meanwhile make the send buffer contiguous
+			size_t tot_send = 0;
+			const void * sbuf = contiguous_send_buf(tot_send);
+
+			MPI_SAFE_CALL(MPI_Wait(&req_sz,MPI_STATUS_IGNORE));
+
+			// The master receive directly in a contiguous buffer
+			if (is_root == true)
+			{
+				size_t tot_recv = collective_recv_displ(np,nb);
+
+				if (tot_recv > 2147483647)
+				{std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " SGather of more than 2GB is not supported, use the option GATHER_TREE" << std::endl;}
+
+				a2a_rbuf.resize(tot_recv);
+			}
+
+			MPI_Request req_data;
+			MPI_SAFE_CALL(MPI_Igatherv(sbuf,tot_send,MPI_BYTE,
+			                           a2a_rbuf.data(),a2a_rcnt.getPointer(),a2a_rdispl.getPointer(),MPI_BYTE,
+			                           root,self_base::getMPIComm(),&req_data));
+			MPI_SAFE_CALL(MPI_Wait(&req_data,MPI_STATUS_IGNORE));
+
+			if (is_root == true)
+			{split_collective_recv(nb,prc,a2a_rbuf.data());}
+		}
+
+		if (coll_record() == true)
+		{
+			if (is_root == true)
+			{prof_collective_recv(prc,nb);}
+			else
+			{
+				size_t tot = 0;
+				for (size_t j = 0 ; j < nb ; j++)
+				{tot += send_sz_byte.get(j);}
+
+				coll_send(root,tot);
+			}
+		}
+
+		if (mem != NULL)
+		{
+			mem->decRef();
+			delete mem;
+		}
+
+		// If we are on master collect the information
+		if (is_root == true)
+		{
+			// we generate the list of the properties to unpack
+			typedef typename ::generate_indexes<int, has_max_prop<T, has_value_type_ofp<T>::value>::number, MetaFuncOrd>::result ind_prop_to_pack;
+
+			// operation object
+			op_ssend_recv_add<void> opa;
+
+			index_gen<ind_prop_to_pack>::template process_recv<op_ssend_recv_add<void>,T,S,layout_base>(*this,recv,&sz,NULL,opa,0);
+
+			recv.add(send);
+			prc.add(root);
+			sz.add(send.size());
+		}
+
+		return true;
+	}
+
+	/*! \brief Just a call to mpi_barrier
+	 *
+	 *
+	 */
+	void barrier()
+	{
+		if (self_base::check_process_level("barrier") == false)
+		{return;}
+
+		MPI_Barrier(this->getMPIComm());
+	}
+
+	/*! \brief Semantic Scatter, scatter the data from one processor to the other node
+	 *
+	 * Semantic communication differ from the normal one. They in general
+	 * follow the following model.
+	 *
+	 * Scatter(T,S,...,op=add);
+	 *
+	 * "Scatter" indicate the communication pattern, or how the information flow
+	 * T is the object to send, S is the object that will receive the data.
+	 * In order to work S must implement the interface S.add(T).
+	 *
+	 * The sizes are distributed with MPI_Iscatter and the chunks with MPI_Iscatterv, so the processors
+	 * receive without probing. prc and sz are used only on root. Vectors of primitives or aggregates
+	 * are sent directly from send, vectors of serializable objects are packed chunk by chunk
+	 *
+	 * ### Example scatter a vector of structures, to other processors
+	 * \snippet VCluster_semantic_unit_tests.hpp Scatter the data from master
+	 *
+	 * \tparam T type of sending object
+	 * \tparam S type of receiving object
+	 *
+	 * \param send Object to send
+	 * \param recv Object to receive
+	 * \param prc processor involved in the scatter
+	 * \param sz size of each chunks (number of elements)
+	 * \param root which processor should scatter the information
+	 * \param opt options, SCATTER_TREE distribute the chunks along a binomial tree (root send
+	 *        log(P) messages instead of P-1)
+	 *
+	 * \return true if the function completed succefully
+	 *
+	 */
+	template<typename T, typename S, template <typename> class layout_base=memory_traits_lin>
+	bool SScatter(T & send, S & recv, openfpm::vector<size_t> & prc, openfpm::vector<size_t> & sz, size_t root, size_t opt = NONE)
+	{
+		if (self_base::check_process_level("SScatter") == false)
+		{return false;}
+
+		vcl_hist_scope hs(self_base::hist,VCL_PROF_COLLECTIVE);
+
+		size_t np = self_base::getProcessingUnits();
+		bool is_root = (self_base::getProcessUnitID() == root);
+
+		// Reset the receive buffer
+		reset_recv_buf();
+
+		// Prepare the sending buffer
+		send_buf.resize(0);
+		send_sz_byte.resize(0);
+
+		// number of buffers for each message (one for each property with interleaved layout)
+		size_t nb = n_pack_buffers<T,S,layout_base>();
+
+		HeapMemory pmem;
+		ExtPreAlloc<HeapMemory> * mem = NULL;
+		const void * sbuf = NULL;
+
+		if (is_root == true)
+		{
+#ifdef SE_CLASS1
+			if (prc.size() != sz.size())
+			{std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " the number of processors prc.size() must match the number of chunks sz.size()" << std::endl;}
+#endif
+
+			a2a_ssz.resize(np*nb);
+			scatter_sdispl.resize(np);
+
+			for (size_t i = 0 ; i < a2a_ssz.size() ; i++)
+			{a2a_ssz.get(i) = 0;}
+
+			for (size_t i = 0 ; i < np ; i++)
+			{scatter_sdispl.get(i) = 0;}
+
+			if (has_pack_gen<typename T::value_type>::value == false && is_vector<T>::value == true && is_layout_mlin<layout_base<dummy_type>>::value == true)
+			{
+				// chunks are sent directly from the vector
+				size_t ptr = 0;
+
+				for (size_t i = 0; i < prc.size() ; i++)
+				{
+					a2a_ssz.get(prc.get(i)) = sz.get(i) * sizeof(typename T::value_type);
+					scatter_sdispl.get(prc.get(i)) = ptr * sizeof(typename T::value_type);
+					ptr += sz.get(i);
+				}
+
+				sbuf = send.getPointer();
+			}
+			else
+			{
+				// every chunk is packed as an object
+				openfpm::vector<T> chunks;
+				chunks.resize(prc.size());
+
+				size_t ptr = 0;
+				size_t tot_size = 0;
+
+				for (size_t i = 0; i < prc.size() ; i++)
+				{
+					for (size_t j = 0 ; j < sz.get(i) ; j++)
+					{chunks.get(i).add(send.get(ptr + j));}
+
+					ptr += sz.get(i);
+
+					//Pack requesting
+					size_t req = 0;
+					pack_unpack_cond_with_prp<has_max_prop<T, has_value_type_ofp<T>::value>::value,op_ssend_recv_add<void>, T, S, layout_base>::packingRequest(chunks.get(i), req, send_sz_byte);
+					tot_size += req;
+				}
+
+				mem = new ExtPreAlloc<HeapMemory>(tot_size,pmem);
+				mem->incRef();
+
+				for (size_t i = 0; i < prc.size() ; i++)
+				{
+					//Packing
+					Pack_stat sts;
+					pack_unpack_cond_with_prp<has_max_prop<T, has_value_type_ofp<T>::value>::value, op_ssend_recv_add<void>, T, S, layout_base>::packing(*mem, chunks.get(i), sts, send_buf);
+				}
+
+				size_t tot_send = 0;
+				sbuf = contiguous_send_buf(tot_send);
+
+				size_t pos = 0;
+				for (size_t i = 0; i < prc.size() ; i++)
+				{
+					scatter_sdispl.get(prc.get(i)) = pos;
+
+					for (size_t j = 0 ; j < nb ; j++)
+					{
+						a2a_ssz.get(prc.get(i)*nb + j) = send_sz_byte.get(i*nb + j);
+						pos += send_sz_byte.get(i*nb + j);
+					}
+				}
+			}
+
+			// MPI_Iscatterv take int counts and displacements
+			if (!(opt & SCATTER_TREE))
+			{
+				a2a_scnt.resize(np);
+				a2a_sdispl.resize(np);
+
+				size_t tot = 0;
+				for (size_t i = 0 ; i < np ; i++)
+				{
+					size_t cnt = 0;
+					for (size_t j = 0 ; j < nb ; j++)
+					{cnt += a2a_ssz.get(i*nb + j);}
+
+					a2a_scnt.get(i) = cnt;
+					a2a_sdispl.get(i) = scatter_sdispl.get(i);
+
+					if (scatter_sdispl.get(i) + cnt > tot)
+					{tot = scatter_sdispl.get(i) + cnt;}
+				}
+
+				if (tot > 2147483647)
+				{std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " SScatter of more than 2GB is not supported, use the option SCATTER_TREE" << std::endl;}
+			}
+		}
+
+		auto & rbuf = self_base::recv_buf[NBX_prc_scnt];
+
+		if (opt & SCATTER_TREE)
+		{scatter_tree(root,nb,sbuf);}
+		else
+		{
+			// scatter the sizes
+			a2a_sz_recv.resize(nb);
+
+			MPI_Request req_sz;
+			MPI_SAFE_CALL(MPI_Iscatter(a2a_ssz.getPointer(),nb,MPI_UNSIGNED_LONG,a2a_sz_recv.getPointer(),nb,MPI_UNSIGNED_LONG,root,self_base::getMPIComm(),&req_sz));
+			MPI_SAFE_CALL(MPI_Wait(&req_sz,MPI_STATUS_IGNORE));
+
+			size_t tot_recv = 0;
+			for (size_t j = 0 ; j < nb ; j++)
+			{tot_recv += a2a_sz_recv.get(j);}
+
+			// The chunk is received directly in the receive buffer
+			void * rptr = NULL;
+
+			if (nb == 1 && tot_recv != 0)
+			{
+				rbuf.add();
+				rbuf.last().resize(tot_recv);
+				rptr = rbuf.last().getPointer();
+			}
+			else
+			{
+				a2a_rbuf.resize(tot_recv);
+				rptr = a2a_rbuf.data();
+			}
+
+			MPI_Request req_data;
+			MPI_SAFE_CALL(MPI_Iscatterv(sbuf,a2a_scnt.getPointer(),a2a_sdispl.getPointer(),MPI_BYTE,
+			                            rptr,tot_recv,MPI_BYTE,
+			                            root,self_base::getMPIComm(),&req_data));
+			MPI_SAFE_CALL(MPI_Wait(&req_data,MPI_STATUS_IGNORE));
+
+			if (nb != 1 && tot_recv != 0)
+			{
+				a2a_rcnt.resize(1);
+				a2a_rdispl.resize(1);
+				a2a_rcnt.get(0) = tot_recv;
+				a2a_rdispl.get(0) = 0;
+
+				openfpm::vector<size_t> prc_recv;
+				split_collective_recv(nb,prc_recv,a2a_rbuf.data());
+			}
+		}
+
+		if (coll_record() == true)
+		{
+			if (is_root == true)
+			{
+				for (size_t i = 0 ; i < np ; i++)
+				{
+					size_t tot = 0;
+					for (size_t j = 0 ; j < nb ; j++)
+					{tot += a2a_ssz.get(i*nb + j);}
+
+					if (i != root && tot != 0)
+					{coll_send(i,tot);}
+				}
+			}
+			else if (rbuf.size() != 0)
+			{
+				openfpm::vector<size_t> prc_root;
+				prc_root.add(root);
+				prof_collective_recv(prc_root,rbuf.size());
+			}
+		}
+
+		if (mem != NULL)
+		{
+			mem->decRef();
+			delete mem;
+		}
+
+		// we generate the list of the properties to pack
+		typedef typename ::generate_indexes<int, has_max_prop<T, has_value_type_ofp<T>::value>::number, MetaFuncOrd>::result ind_prop_to_pack;
+
+		// operation object
+		op_ssend_recv_add<void> opa;
+
+		index_gen<ind_prop_to_pack>::template process_recv<op_ssend_recv_add<void>,T,S,layout_base>(*this,recv,NULL,NULL,opa,0);
+
+		return true;
+	}
+	
+	/*! \brief Semantic all-to-all, every processor send one object to each processor
+	 *
+	 * It is the dense version of SSendRecv, send.get(i) is sent to the processor i. The objects are
+	 * packed like in SSendRecv, the sizes are exchanged with MPI_Ialltoall and the data with one
+	 * MPI_Ialltoallv, so no probing is needed. The received data are merged in recv in order of
+	 * processor. Empty messages are not received (like in SSendRecv)
+	 *
+	 * \tparam T type of sending object
+	 * \tparam S type of receiving object
+	 *
+	 * \param send Objects to send (one for each processor)
+	 * \param recv Object to receive
+	 * \param prc_recv list of the processors from which we received
+	 * \param sz_recv number of elements added
+	 * \param opt options
+	 *
+	 * \return true if the function completed succefully
+	 *
+	 */
+	template<typename T,
+		typename S,
+		template <typename> class layout_base = memory_traits_lin>
+	bool SAlltoall(
+		openfpm::vector<T> & send,
+		S & recv,
+		openfpm::vector<size_t> & prc_recv,
+		openfpm::vector<size_t> & sz_recv,
+		size_t opt = NONE)
+	{
+		if (self_base::check_process_level("SAlltoall") == false)
+		{return false;}
+
+		vcl_hist_scope hs(self_base::hist,VCL_PROF_COLLECTIVE);
+
+		size_t np = self_base::getProcessingUnits();
+
+		if (send.size() != np)
+		{
+			std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " SAlltoall require one object for each processor, send.size() = " << send.size() << " number of processors = " << np << std::endl;
+			return false;
+		}
+
+		// Reset the receive buffer
+		reset_recv_buf();
+
+		// Prepare the sending buffer
+		send_buf.resize(0);
+		send_sz_byte.resize(0);
+
+		size_t tot_size = 0;
+
+		for (size_t i = 0; i < send.size() ; i++)
+		{
+			size_t req = 0;
+
+			//Pack requesting
+			pack_unpack_cond_with_prp<has_max_prop<T, has_value_type_ofp<T>::value>::value,op_ssend_recv_add<void>, T, S, layout_base>::packingRequest(send.get(i), req, send_sz_byte);
+			tot_size += req;
+		}
+
+		HeapMemory pmem;
+
+		ExtPreAlloc<HeapMemory> & mem = *(new ExtPreAlloc<HeapMemory>(tot_size,pmem));
+		mem.incRef();
+
+		for (size_t i = 0; i < send.size() ; i++)
+		{
+			//Packing
+
+			Pack_stat sts;
+
+			pack_unpack_cond_with_prp<has_max_prop<T, has_value_type_ofp<T>::value>::value, op_ssend_recv_add<void>, T, S, layout_base>::packing(mem, send.get(i), sts, send_buf,opt);
+		}
+
+		// buffers for each processor (one for each property with interleaved layout)
+		size_t nb = send_buf.size() / np;
+
+		// exchange the sizes
+		a2a_sz_recv.resize(np*nb);
+
+		MPI_Request req_sz;
+		MPI_SAFE_CALL(MPI_Ialltoall(send_sz_byte.getPointer(),nb,MPI_UNSIGNED_LONG,a2a_sz_recv.getPointer(),nb,MPI_UNSIGNED_LONG,self_base::getMPIComm(),&req_sz));
+
+		// meanwhile make the send buffer contiguous
+		size_t tot_send = 0;
+		const void * sbuf = contiguous_send_buf(tot_send);
+
+		a2a_scnt.resize(np);
+		a2a_sdispl.resize(np);
+
+		size_t pos = 0;
+		for (size_t i = 0 ; i < np ; i++)
+		{
+			size_t sz = 0;
+			for (size_t j = 0 ; j < nb ; j++)
+			{sz += send_sz_byte.get(i*nb + j);}
+
+			a2a_scnt.get(i) = sz;
+			a2a_sdispl.get(i) = pos;
+			pos += sz;
+		}
+
+		MPI_SAFE_CALL(MPI_Wait(&req_sz,MPI_STATUS_IGNORE));
+
+		size_t tot_recv = collective_recv_displ(np,nb);
+
+		if (tot_send > 2147483647 || tot_recv > 2147483647)
+		{std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " SAlltoall of more than 2GB per processor is not supported" << std::endl;}
+
+		a2a_rbuf.resize(tot_recv);
+
+		MPI_Request req_data;
+		MPI_SAFE_CALL(MPI_Ialltoallv(sbuf,a2a_scnt.getPointer(),a2a_sdispl.getPointer(),MPI_BYTE,
+		                             a2a_rbuf.data(),a2a_rcnt.getPointer(),a2a_rdispl.getPointer(),MPI_BYTE,
+		                             self_base::getMPIComm(),&req_data));
+		MPI_SAFE_CALL(MPI_Wait(&req_data,MPI_STATUS_IGNORE));
+
+		mem.decRef();
+		delete &mem;
+
+		// split the receive buffer in messages
+		split_collective_recv(nb,prc_recv,a2a_rbuf.data());
+
+		if (coll_record() == true)
+		{
+			for (size_t i = 0 ; i < np ; i++)
+			{
+				if (i != self_base::getProcessUnitID() && a2a_scnt.get(i) != 0)
+				{coll_send(i,a2a_scnt.get(i));}
+			}
+
+			prof_collective_recv(prc_recv,nb);
+		}
+
+		// we generate the list of the properties to pack
+		typedef typename ::generate_indexes<int, has_max_prop<T, has_value_type_ofp<T>::value>::number, MetaFuncOrd>::result ind_prop_to_pack;
+
+		op_ssend_recv_add<void> opa;
+
+		index_gen<ind_prop_to_pack>::template process_recv<op_ssend_recv_add<void>,T,S,layout_base>(*this,recv,&sz_recv,NULL,opa,opt);
+
+		return true;
+	}
+
+	/*! \brief Semantic all-gather, gather the data from all processors on all processors
+	 *
+	 * Like SGather, but every processor receive. The objects are packed like in SGather, the sizes are
+	 * exchanged with MPI_Iallgather and the data with one MPI_Iallgatherv. The received data are
+	 * merged in recv in order of processor (the local object included)
+	 *
+	 * \tparam T type of sending object
+	 * \tparam S type of receiving object
+	 *
+	 * \param send Object to send
+	 * \param recv Object to receive
+	 *
+	 * \return true if the function completed succefully
+	 *
+	 */
+	template<typename T, typename S, template <typename> class layout_base=memory_traits_lin>
+	bool SAllGather(T & send, S & recv)
+	{
+		openfpm::vector<size_t> prc;
+		openfpm::vector<size_t> sz;
+
+		return SAllGather<T,S,layout_base>(send,recv,prc,sz);
+	}
+
+	/*! \brief Semantic all-gather, gather the data from all processors on all processors
+	 *
+	 * \see SAllGather
+	 *
+	 * \tparam T type of sending object
+	 * \tparam S type of receiving object
+	 *
+	 * \param send Object to send
+	 * \param recv Object to receive
+	 * \param prc processors from witch we received the information
+	 * \param sz size of the received information for each processor
+	 * \param opt options
+	 *
+	 * \return true if the function completed succefully
+	 *
+	 */
+	template<typename T,
+		typename S,
+		template <typename> class layout_base = memory_traits_lin>
+	bool SAllGather(
+		T & send,
+		S & recv,
+		openfpm::vector<size_t> & prc,
+		openfpm::vector<size_t> & sz,
+		size_t opt = NONE)
+	{
+		if (self_base::check_process_level("SAllGather") == false)
+		{return false;}
+
+#ifdef SE_CLASS1
+		if (&send == (T *)&recv)
+		{std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " using SAllGather in general the sending object and the receiving object must be different" << std::endl;}
+#endif
+
+		vcl_hist_scope hs(self_base::hist,VCL_PROF_COLLECTIVE);
+
+		size_t np = self_base::getProcessingUnits();
+
+		// Reset the receive buffer
+		reset_recv_buf();
+
+		// Prepare the sending buffer
+		send_buf.resize(0);
+		send_sz_byte.resize(0);
 
-			openfpm::vector<size_t> sz;
+		HeapMemory pmem;
+		ExtPreAlloc<HeapMemory> * mem;
 
-			openfpm::vector<const void *> send_buf;
-				
-			//Pack requesting
+		pack_collective<T,S,layout_base>(send,mem,pmem,opt);
 
-			size_t tot_size = 0;
+		// buffers for each processor (one for each property with interleaved layout)
+		size_t nb = send_buf.size();
 
-			pack_unpack_cond_with_prp<has_max_prop<T, has_value_type_ofp<T>::value>::value,op_ssend_recv_add<void>, T, S, layout_base>::packingRequest(send, tot_size, sz);
+		// exchange the sizes
+		a2a_sz_recv.resize(np*nb);
 
-			HeapMemory pmem;
+		MPI_Request req_sz;
+		MPI_SAFE_CALL(MPI_Iallgather(send_sz_byte.getPointer(),nb,MPI_UNSIGNED_LONG,a2a_sz_recv.getPointer(),nb,MPI_UNSIGNED_LONG,self_base::getMPIComm(),&req_sz));
 
-			ExtPreAlloc<HeapMemory> & mem = *(new ExtPreAlloc<HeapMemory>(tot_size,pmem));
-			mem.incRef();
+		// meanwhile make the send buffer contiguous
+		size_t tot_send = 0;
+		const void * sbuf = contiguous_send_buf(tot_send);
 
-			//Packing
+		MPI_SAFE_CALL(MPI_Wait(&req_sz,MPI_STATUS_IGNORE));
 
-			Pack_stat sts;
-			
-			pack_unpack_cond_with_prp<has_max_prop<T, has_value_type_ofp<T>::value>::value,op_ssend_recv_add<void>, T, S, layout_base>::packing(mem, send, sts, send_buf);
+		size_t tot_recv = collective_recv_displ(np,nb);
 
-			pack_unpack_cond_with_prp_inte_lin<T>::construct_prc(send_prc,send_prc_);
+		if (tot_recv > 2147483647)
+		{std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " SAllGather of more than 2GB per processor is not supported" << std::endl;}
 
-			self_base::tags[NBX_prc_scnt].clear();
+		a2a_rbuf.resize(tot_recv);
+
+		MPI_Request req_data;
+		MPI_SAFE_CALL(MPI_Iallgatherv(sbuf,tot_send,MPI_BYTE,
+		                              a2a_rbuf.data(),a2a_rcnt.getPointer(),a2a_rdispl.getPointer(),MPI_BYTE,
+		                              self_base::getMPIComm(),&req_data));
+		MPI_SAFE_CALL(MPI_Wait(&req_data,MPI_STATUS_IGNORE));
 
-			// receive information
-			base_info<InternalMemory> bi(NULL,prc,sz,self_base::tags[NBX_prc_scnt],0);
+		mem->decRef();
+		delete mem;
 
-			// Send and recv multiple messages
-			self_base::sendrecvMultipleMessagesNBX(send_prc_.size(),(size_t *)sz.getPointer(),(size_t *)send_prc_.getPointer(),(void **)send_buf.getPointer(),msg_alloc,(void *)&bi,NONE);
+		// split the receive buffer in messages
+		split_collective_recv(nb,prc,a2a_rbuf.data());
 
-			mem.decRef();
-			delete &mem;
+		if (coll_record() == true)
+		{
+			for (size_t i = 0 ; i < np ; i++)
+			{
+				if (i != self_base::getProcessUnitID() && tot_send != 0)
+				{coll_send(i,tot_send);}
+			}
+
+			prof_collective_recv(prc,nb);
 		}
-		
+
+		// we generate the list of the properties to pack
+		typedef typename ::generate_indexes<int, has_max_prop<T, has_value_type_ofp<T>::value>::number, MetaFuncOrd>::result ind_prop_to_pack;
+
+		op_ssend_recv_add<void> opa;
+
+		index_gen<ind_prop_to_pack>::template process_recv<op_ssend_recv_add<void>,T,S,layout_base>(*this,recv,&sz,NULL,opa,opt);
+
 		return true;
 	}
 
-	/*! \brief Just a call to mpi_barrier
+	/*! \brief Set the size of the segments of SBcast
 	 *
+	 * \param chunk size in byte of each segment
 	 *
 	 */
-	void barrier()
+	void setBcastChunkSize(size_t chunk)
 	{
-		MPI_Barrier(this->getMPIComm());
+		bcast_chunk = (chunk == 0)?1:chunk;
 	}
 
-	/*! \brief Semantic Scatter, scatter the data from one processor to the other node
-	 *
-	 * Semantic communication differ from the normal one. They in general
-	 * follow the following model.
-	 *
-	 * Scatter(T,S,...,op=add);
+	/*! \brief Semantic broadcast, the non-root processors do not need to know the size
 	 *
-	 * "Scatter" indicate the communication pattern, or how the information flow
-	 * T is the object to send, S is the object that will receive the data.
-	 * In order to work S must implement the interface S.add(T).
+	 * The sizes of the packed buffers are broadcasted first, then the payload as a pipeline of
+	 * MPI_Ibcast segments (see setBcastChunkSize), so the processors in the middle of the broadcast
+	 * tree forward a segment while they receive the next one. Vectors of primitives or aggregates
+	 * with linear layout are sent from and received directly in the vector memory, the other
+	 * objects are packed and unpacked
 	 *
-	 * ### Example scatter a vector of structures, to other processors
-	 * \snippet VCluster_semantic_unit_tests.hpp Scatter the data from master
+	 * \warning on the non-root processors the content of v is replaced
 	 *
-	 * \tparam T type of sending object
-	 * \tparam S type of receiving object
+	 * \tparam T type of the object to broadcast
 	 *
-	 * \param send Object to send
-	 * \param recv Object to receive
-	 * \param prc processor involved in the scatter
-	 * \param sz size of each chunks
-	 * \param root which processor should scatter the information
+	 * \param v object to send on root, object that receive on the other processors
+	 * \param root processor that broadcast
 	 *
 	 * \return true if the function completed succefully
 	 *
 	 */
-	template<typename T, typename S, template <typename> class layout_base=memory_traits_lin>
-	bool SScatter(T & send, S & recv, openfpm::vector<size_t> & prc, openfpm::vector<size_t> & sz, size_t root)
+	template<typename T, template <typename> class layout_base = memory_traits_lin>
+	bool SBcast(T & v, size_t root)
 	{
+		if (self_base::check_process_level("SBcast") == false)
+		{return false;}
+
+		vcl_hist_scope hs(self_base::hist,VCL_PROF_COLLECTIVE);
+
+		bool is_root = (self_base::getProcessUnitID() == root);
+		const bool raw = has_pack_gen<typename T::value_type>::value == false && is_vector<T>::value == true && is_layout_mlin<layout_base<dummy_type>>::value == true;
+
 		// Reset the receive buffer
 		reset_recv_buf();
 
-		// If we are on master scatter the information
-		if (self_base::getProcessUnitID() == root)
-		{
-			// Prepare the sending buffer
-			openfpm::vector<const void *> send_buf;
+		// Prepare the sending buffer
+		send_buf.resize(0);
+		send_sz_byte.resize(0);
+
+		HeapMemory pmem;
+		ExtPreAlloc<HeapMemory> * mem = NULL;
 
+		size_t nb = 1;
 
-			openfpm::vector<size_t> sz_byte;
-			sz_byte.resize(sz.size());
+		if (is_root == true)
+		{
+			if (raw == true)
+			{send_sz_byte.add(v.size()*sizeof(typename T::value_type));}
+			else
+			{pack_collective<T,T,layout_base>(v,mem,pmem,NONE);}
 
-			size_t ptr = 0;
+			nb = send_sz_byte.size();
+		}
+		else if (raw == false)
+		{nb = n_pack_buffers<T,T,layout_base>();}
 
-			for (size_t i = 0; i < sz.size() ; i++)
-			{
-				send_buf.add((char *)send.getPointer() + sizeof(typename T::value_type)*ptr );
-				sz_byte.get(i) = sz.get(i) * sizeof(typename T::value_type);
-				ptr += sz.get(i);
-			}
+		// broadcast the sizes
+		a2a_sz_recv.resize(nb);
 
-			self_base::tags[NBX_prc_scnt].clear();
+		if (is_root == true)
+		{
+			for (size_t j = 0 ; j < nb ; j++)
+			{a2a_sz_recv.get(j) = send_sz_byte.get(j);}
+		}
 
-			// receive information
-			base_info<InternalMemory> bi(&this->recv_buf[NBX_prc_scnt],prc,sz,this->tags[NBX_prc_scnt],0);
+		MPI_Request req_sz;
+		MPI_SAFE_CALL(MPI_Ibcast(a2a_sz_recv.getPointer(),nb,MPI_UNSIGNED_LONG,root,self_base::getMPIComm(),&req_sz));
+		MPI_SAFE_CALL(MPI_Wait(&req_sz,MPI_STATUS_IGNORE));
 
-			// Send and recv multiple messages
-			self_base::sendrecvMultipleMessagesNBX(prc.size(),(size_t *)sz_byte.getPointer(),(size_t *)prc.getPointer(),(void **)send_buf.getPointer(),msg_alloc,(void *)&bi);
+		size_t tot = 0;
+		for (size_t j = 0 ; j < nb ; j++)
+		{tot += a2a_sz_recv.get(j);}
 
-			// we generate the list of the properties to pack
-			typedef typename ::generate_indexes<int, has_max_prop<T, has_value_type_ofp<T>::value>::number, MetaFuncOrd>::result ind_prop_to_pack;
+		void * buf;
 
-			// operation object
-			op_ssend_recv_add<void> opa;
+		if (raw == true)
+		{
+			if (is_root == false)
+			{v.resize(tot / sizeof(typename T::value_type));}
 
-			index_gen<ind_prop_to_pack>::template process_recv<op_ssend_recv_add<void>,T,S,layout_base>(*this,recv,NULL,NULL,opa,0);
+			buf = v.getPointer();
+		}
+		else if (is_root == true)
+		{
+			size_t tot_send = 0;
+			buf = const_cast<void *>(contiguous_send_buf(tot_send));
 		}
 		else
 		{
-			// The non-root receive
-			openfpm::vector<size_t> send_req;
+			a2a_rbuf.resize(tot);
+			buf = a2a_rbuf.data();
+		}
 
-			self_base::tags[NBX_prc_scnt].clear();
+		// pipeline of segments
+		bcast_req.clear();
 
-			// receive information
-			base_info<InternalMemory> bi(&this->recv_buf[NBX_prc_scnt],prc,sz,this->tags[NBX_prc_scnt],0);
+		for (size_t off = 0 ; off < tot ; off += bcast_chunk)
+		{
+			size_t seg = (tot - off < bcast_chunk)?tot - off:bcast_chunk;
 
-			// Send and recv multiple messages
-			self_base::sendrecvMultipleMessagesNBX(send_req.size(),NULL,NULL,NULL,msg_alloc,&bi);
+			bcast_req.add();
+			MPI_SAFE_CALL(MPI_Ibcast((char *)buf + off,seg,MPI_BYTE,root,self_base::getMPIComm(),&bcast_req.last()));
+		}
 
-			// we generate the list of the properties to pack
-			typedef typename ::generate_indexes<int, has_max_prop<T, has_value_type_ofp<T>::value>::number, MetaFuncOrd>::result ind_prop_to_pack;
+		if (bcast_req.size() != 0)
+		{MPI_SAFE_CALL(MPI_Waitall(bcast_req.size(),bcast_req.getPointer(),MPI_STATUSES_IGNORE));}
 
-			// operation object
-			op_ssend_recv_add<void> opa;
+		if (coll_record() == true)
+		{
+			if (is_root == true)
+			{
+				for (size_t i = 0 ; i < self_base::getProcessingUnits() ; i++)
+				{
+					if (i != root)
+					{coll_send(i,tot);}
+				}
+			}
+			else
+			{self_base::prof.recv(VCL_PROF_COLLECTIVE,root,tot);}
+		}
+
+		if (mem != NULL)
+		{
+			mem->decRef();
+			delete mem;
+		}
+
+		if (raw == true || is_root == true)
+		{return true;}
 
-			index_gen<ind_prop_to_pack>::template process_recv<op_ssend_recv_add<void>,T,S,layout_base>(*this,recv,NULL,NULL,opa,0);
+		// unpack
+		v.clear();
+
+		if (tot != 0)
+		{
+			a2a_rcnt.resize(1);
+			a2a_rdispl.resize(1);
+			a2a_rcnt.get(0) = tot;
+			a2a_rdispl.get(0) = 0;
+
+			openfpm::vector<size_t> prc_recv;
+			split_collective_recv(nb,prc_recv,a2a_rbuf.data());
 		}
 
+		// we generate the list of the properties to pack
+		typedef typename ::generate_indexes<int, has_max_prop<T, has_value_type_ofp<T>::value>::number, MetaFuncOrd>::result ind_prop_to_pack;
+
+		op_ssend_recv_add<void> opa;
+
+		index_gen<ind_prop_to_pack>::template process_recv<op_ssend_recv_add<void>,T,T,layout_base>(*this,v,NULL,NULL,opa,0);
+
 		return true;
 	}
-	
+
 	/*! \brief reorder the receiving buffer
+	 *
+	 * Messages are ordered by source processor and, for the same processor, by tag. The
+	 * permutation is computed with a counting sort on the source processor (messages coming
+	 * from the same processor are almost always one, so the tag ordering is an insertion
+	 * sort on already sorted data) and applied in place following its cycles. The scratch
+	 * vectors are members, so no allocation is done once they reach their steady size
 	 *
 	 * \param prc list of the receiving processors
+	 * \param tags list of the tags of the receiving messages
 	 * \param sz_recv list of size of the receiving messages (in byte)
 	 *
 	 */
 	void reorder_buffer(openfpm::vector<size_t> & prc, const openfpm::vector<size_t> & tags, openfpm::vector<size_t> & sz_recv)
 	{
+		vcl_trace_scope ts(self_base::trace,"reorder");
 
-		struct recv_buff_reorder
-		{
-			//! processor
-			size_t proc;
-
-			size_t tag;
-
-			//! position in the receive list
-			size_t pos;
-
-			//! default constructor
-			recv_buff_reorder()
-			:proc(0),tag(0),pos(0)
-			{};
+		auto & rbuf = self_base::recv_buf[NBX_prc_pcnt];
+		size_t n = rbuf.size();
 
-			//! needed to reorder
-			bool operator<(const recv_buff_reorder & rd) const
-			{
-				if (proc == rd.proc)
-				{return tag < rd.tag;}
-
-				return (proc < rd.proc);
-			}
+		auto tag_of = [&tags](size_t i) -> size_t
+		{
+			return (i < tags.size())?tags.get(i):(unsigned int)-1;
 		};
 
-		openfpm::vector<recv_buff_reorder> rcv;
+		auto less = [&prc,&tag_of](size_t i, size_t j) -> bool
+		{
+			if (prc.get(i) == prc.get(j))
+			{return tag_of(i) < tag_of(j);}
 
-		rcv.resize(self_base::recv_buf[NBX_prc_pcnt].size());
+			return prc.get(i) < prc.get(j);
+		};
 
-		for (size_t i = 0 ; i < rcv.size() ; i++)
+		// In most of the cases (known patterns) the messages are already ordered
+		size_t i = 1;
+		for ( ; i < n ; i++)
 		{
-			rcv.get(i).proc = prc.get(i);
-			if (i < tags.size())
-			{rcv.get(i).tag = tags.get(i);}
-			else
-			{rcv.get(i).tag = (unsigned int)-1;}
-			rcv.get(i).pos = i;
+			if (less(i,i-1) == true)
+			{break;}
 		}
 
-		// we sort based on processor
-		rcv.sort();
+		if (i >= n)
+		{return;}
+
+		// counting sort on the source processor
+		reorder_cnt.resize(self_base::size()+1);
+		for (size_t j = 0 ; j < reorder_cnt.size() ; j++)
+		{reorder_cnt.get(j) = 0;}
 
-		openfpm::vector_fr<BMemory<InternalMemory>> recv_ord;
-		recv_ord.resize(rcv.size());
+		for (size_t j = 0 ; j < n ; j++)
+		{reorder_cnt.get(prc.get(j)+1)++;}
 
-		openfpm::vector<size_t> prc_ord;
-		prc_ord.resize(rcv.size());
+		for (size_t j = 1 ; j < reorder_cnt.size() ; j++)
+		{reorder_cnt.get(j) += reorder_cnt.get(j-1);}
 
-		openfpm::vector<size_t> sz_recv_ord;
-		sz_recv_ord.resize(rcv.size());
+		// reorder_perm.get(k) is the position in the receive list of the k-th ordered message
+		reorder_perm.resize(n);
+		for (size_t j = 0 ; j < n ; j++)
+		{reorder_perm.get(reorder_cnt.get(prc.get(j))++) = j;}
 
-		// Now we reorder rcv
-		for (size_t i = 0 ; i < rcv.size() ; i++)
+		// messages from the same processor are ordered by tag
+		for (size_t j = 1 ; j < n ; j++)
 		{
-			recv_ord.get(i).swap(self_base::recv_buf[NBX_prc_pcnt].get(rcv.get(i).pos));
-			prc_ord.get(i) = rcv.get(i).proc;
-			sz_recv_ord.get(i) = sz_recv.get(rcv.get(i).pos);
+			size_t k = j;
+			size_t pos = reorder_perm.get(j);
+
+			while (k > 0 && less(pos,reorder_perm.get(k-1)) == true)
+			{
+				reorder_perm.get(k) = reorder_perm.get(k-1);
+				k--;
+			}
+
+			reorder_perm.get(k) = pos;
 		}
 
-		// move rcv into recv
-		// Now we swap back to recv_buf in an ordered way
-		for (size_t i = 0 ; i < rcv.size() ; i++)
+		// Apply the permutation in place following its cycles
+		for (size_t j = 0 ; j < n ; j++)
 		{
-			self_base::recv_buf[NBX_prc_pcnt].get(i).swap(recv_ord.get(i));
-		}
+			size_t k = j;
+
+			while (reorder_perm.get(k) != j)
+			{
+				size_t src = reorder_perm.get(k);
+
+				rbuf.get(k).swap(rbuf.get(src));
+				std::swap(prc.get(k),prc.get(src));
+				std::swap(sz_recv.get(k),sz_recv.get(src));
 
-		prc.swap(prc_ord);
-		sz_recv.swap(sz_recv_ord);
+				reorder_perm.get(k) = k;
+				k = src;
+			}
 
-		// reorder prc_recv and recv_sz
+			reorder_perm.get(k) = k;
+		}
 	}
 
 	/*! \brief Semantic Send and receive, send the data to processors and receive from the other processors
@@ -792,7 +2487,7 @@ class Vcluster: public Vcluster_base<InternalMemory>
 	 * \param prc_send destination processors
 	 * \param prc_recv list of the receiving processors
 	 * \param sz_recv number of elements added
-	 * \param opt options
+	 * \param opt options, MPI_COMPRESS compress the messages (see setCompressionParameters)
 	 *
 	 * \return true if the function completed succefully
 	 *
@@ -854,7 +2549,7 @@ class Vcluster: public Vcluster_base<InternalMemory>
 	 * \param prc_send destination processors
 	 * \param prc_recv list of the receiving processors
 	 * \param sz_recv number of elements added
-	 * \param opt options
+	 * \param opt options, MPI_COMPRESS compress the messages (see setCompressionParameters)
 	 *
 	 * \return true if the function completed succefully
 	 *
@@ -1039,6 +2734,126 @@ class Vcluster: public Vcluster_base<InternalMemory>
 		return true;
 	}
 
+	/*! \brief Semantic Send and receive with error bounded lossy compression of the floating point properties
+	 *
+	 * It work like SSendRecvP, but the float/double properties (or arrays of them) with a positive error bound
+	 * are quantized and compressed on the wire. Every received value differ from the sent one at most
+	 * by the error bound of its property. Supported only for vectors of POD elements with linear layout,
+	 * all the processors must call this function
+	 *
+	 * \tparam T type of sending object
+	 * \tparam S type of receiving object
+	 * \tparam prp properties for merging
+	 *
+	 * \param send Object to send
+	 * \param recv Object to receive
+	 * \param prc_send destination processors
+	 * \param prc_recv list of the processors from which we receive
+	 * \param sz_recv number of elements added per processors
+	 * \param err_bound absolute error bound for each property (0 or missing mean lossless)
+	 * \param opt options, KNOWN_ELEMENT_OR_BYTE is not supported
+	 *
+	 * \return true if the function completed succefully
+	 *
+	 */
+	template<typename T, typename S, template <typename> class layout_base, int ... prp>
+	bool SSendRecvP(
+		openfpm::vector<T> & send,
+		S & recv,
+		openfpm::vector<size_t> & prc_send,
+		openfpm::vector<size_t> & prc_recv,
+		openfpm::vector<size_t> & sz_recv,
+		const openfpm::vector<double> & err_bound,
+		size_t opt = NONE
+	) {
+		if (opt & KNOWN_ELEMENT_OR_BYTE)
+		{
+			std::cerr << __FILE__ << ":" << __LINE__ << " Error the option KNOWN_ELEMENT_OR_BYTE cannot be used with lossy compression, the receive size is calculated" << std::endl;
+			opt &= ~KNOWN_ELEMENT_OR_BYTE;
+		}
+
+		prepare_send_buffer<op_ssend_recv_add<void>,T,S,layout_base>(send,recv,prc_send,prc_recv,sz_recv,opt,&err_bound);
+
+		self_base::sendrecvMultipleMessagesNBXWait();
+
+		// Reorder the buffer
+		reorder_buffer(prc_recv,self_base::tags[NBX_prc_scnt],sz_recv_byte[NBX_prc_scnt]);
+
+		mem[NBX_prc_scnt]->decRef();
+		delete mem[NBX_prc_scnt];
+		delete pmem[NBX_prc_scnt];
+
+		lossy_decode();
+
+		// operation object
+		op_ssend_recv_add<void> opa;
+
+		// process the received information
+		process_receive_buffer_with_prp<op_ssend_recv_add<void>,T,S,layout_base,prp...>(recv,&sz_recv,NULL,opa,opt);
+
+		return true;
+	}
+
+	/*! \brief Semantic Send and receive, sending only the data changed from the previous exchange
+	 *
+	 * It work like SSendRecvP. For every message that has the same size of the previous one sent
+	 * to the same processor, only the changed ranges are sent and the receiver apply them on its copy
+	 * of the previous message. It is convenient for repeated exchanges with a known pattern where most
+	 * of the data does not change. All the processors must call this function with their own state object
+	 *
+	 * \tparam T type of sending object
+	 * \tparam S type of receiving object
+	 * \tparam prp properties for merging
+	 *
+	 * \param send Object to send
+	 * \param recv Object to receive
+	 * \param prc_send destination processors
+	 * \param prc_recv list of the processors from which we receive
+	 * \param sz_recv number of elements added per processors
+	 * \param delta state of the exchange (previous messages)
+	 * \param opt options, RECEIVE_KNOWN is suggested, KNOWN_ELEMENT_OR_BYTE is not supported
+	 *
+	 * \return true if the function completed succefully
+	 *
+	 */
+	template<typename T, typename S, template <typename> class layout_base, int ... prp>
+	bool SSendRecvP(
+		openfpm::vector<T> & send,
+		S & recv,
+		openfpm::vector<size_t> & prc_send,
+		openfpm::vector<size_t> & prc_recv,
+		openfpm::vector<size_t> & sz_recv,
+		Vcluster_delta & delta,
+		size_t opt = NONE
+	) {
+		if (opt & KNOWN_ELEMENT_OR_BYTE)
+		{
+			std::cerr << __FILE__ << ":" << __LINE__ << " Error the option KNOWN_ELEMENT_OR_BYTE cannot be used with delta exchange, the receive size is calculated" << std::endl;
+			opt &= ~KNOWN_ELEMENT_OR_BYTE;
+		}
+
+		prepare_send_buffer<op_ssend_recv_add<void>,T,S,layout_base>(send,recv,prc_send,prc_recv,sz_recv,opt,NULL,&delta);
+
+		self_base::sendrecvMultipleMessagesNBXWait();
+
+		// Reorder the buffer
+		reorder_buffer(prc_recv,self_base::tags[NBX_prc_scnt],sz_recv_byte[NBX_prc_scnt]);
+
+		mem[NBX_prc_scnt]->decRef();
+		delete mem[NBX_prc_scnt];
+		delete pmem[NBX_prc_scnt];
+
+		delta_decode(delta,prc_recv);
+
+		// operation object
+		op_ssend_recv_add<void> opa;
+
+		// process the received information
+		process_receive_buffer_with_prp<op_ssend_recv_add<void>,T,S,layout_base,prp...>(recv,&sz_recv,NULL,opa,opt);
+
+		return true;
+	}
+
 	/*! \brief Semantic Send and receive, send the data to processors and receive from the other processors (with properties)
 	 *         asynchronous version
 	 *
@@ -1152,6 +2967,69 @@ class Vcluster: public Vcluster_base<InternalMemory>
 		return true;
 	}
 
+	/*! \brief Semantic Send and receive with operation, sending only the data changed from the previous exchange
+	 *
+	 * It work like SSendRecvP_op (for example with op_ssend_gg_recv_merge to replace in place the received
+	 * ghost), but for every message that has the same size of the previous one sent to the same processor only
+	 * the changed ranges are sent. All the processors must call this function with their own state object
+	 *
+	 * \tparam op type of operation
+	 * \tparam T type of sending object
+	 * \tparam S type of receiving object
+	 * \tparam prp properties for merging
+	 *
+	 * \param send Object to send
+	 * \param recv Object to receive
+	 * \param prc_send destination processors
+	 * \param op_param operation object (operation to do im merging the information)
+	 * \param prc_recv from which processor we receive messages
+	 * \param recv_sz size of each receiving buffer
+	 * \param delta state of the exchange (previous messages)
+	 * \param opt options, RECEIVE_KNOWN is suggested, KNOWN_ELEMENT_OR_BYTE is not supported
+	 *
+	 * \return true if the function completed successful
+	 *
+	 */
+	template<typename op,
+	         typename T,
+			 typename S,
+			 template <typename> class layout_base,
+			 int ... prp>
+	bool SSendRecvP_op(
+		openfpm::vector<T> & send,
+		S & recv,
+		openfpm::vector<size_t> & prc_send,
+		op & op_param,
+		openfpm::vector<size_t> & prc_recv,
+		openfpm::vector<size_t> & recv_sz,
+		Vcluster_delta & delta,
+		size_t opt = NONE
+	) {
+		if (opt & KNOWN_ELEMENT_OR_BYTE)
+		{
+			std::cerr << __FILE__ << ":" << __LINE__ << " Error the option KNOWN_ELEMENT_OR_BYTE cannot be used with delta exchange, the receive size is calculated" << std::endl;
+			opt &= ~KNOWN_ELEMENT_OR_BYTE;
+		}
+
+		prepare_send_buffer<op,T,S,layout_base>(send,recv,prc_send,prc_recv,recv_sz,opt,NULL,&delta);
+
+		self_base::sendrecvMultipleMessagesNBXWait();
+
+		// Reorder the buffer
+		reorder_buffer(prc_recv,self_base::tags[NBX_prc_scnt],sz_recv_byte[NBX_prc_scnt]);
+
+		mem[NBX_prc_scnt]->decRef();
+		delete mem[NBX_prc_scnt];
+		delete pmem[NBX_prc_scnt];
+
+		delta_decode(delta,prc_recv);
+
+		// process the received information
+		process_receive_buffer_with_prp<op,T,S,layout_base,prp...>(recv,NULL,NULL,op_param,opt);
+
+		return true;
+	}
+
 	/*! \brief Semantic Send and receive, send the data to processors and receive from the other processors asynchronous version
 	 *
 	 * \see progressCommunication to incrementally progress the communication  SSendRecvP_opWait to synchronize
@@ -12,17 +12,34 @@
 #include "MPI_wrapper/MPI_util.hpp"
 #include "Vector/map_vector.hpp"
 #include "MPI_wrapper/MPI_IallreduceW.hpp"
+#include "MPI_wrapper/MPI_IscanW.hpp"
 #include "MPI_wrapper/MPI_IrecvW.hpp"
 #include "MPI_wrapper/MPI_IsendW.hpp"
 #include "MPI_wrapper/MPI_IAllGather.hpp"
 #include "MPI_wrapper/MPI_IBcastW.hpp"
 #include <exception>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <map>
+#include <algorithm>
+#include <sstream>
+#include <fstream>
+#include <cstdlib>
 #include "Vector/map_vector.hpp"
 #ifdef DEBUG
 #include "util/check_no_pointers.hpp"
 #include "util/util_debug.hpp"
 #endif
 #include "util/Vcluster_log.hpp"
+#include "util/Vcluster_compress.hpp"
+#include "util/Vcluster_repro_sum.hpp"
+#include "util/Vcluster_profiler.hpp"
+#include "util/Vcluster_trace.hpp"
+#include "util/Vcluster_counters.hpp"
+#include "util/Vcluster_histogram.hpp"
+#include "util/Vcluster_nbx_timing.hpp"
+#include "util/Vcluster_pe.hpp"
 #include "memory/BHeapMemory.hpp"
 #include "Packer_Unpacker/has_max_prop.hpp"
 #include "data_type/aggregate.hpp"
@@ -55,17 +72,25 @@ constexpr int GATHER_BASE = 24576;
 constexpr int RECEIVE_KNOWN = 4;
 constexpr int KNOWN_ELEMENT_OR_BYTE = 8;
 constexpr int MPI_GPU_DIRECT = 16;
+constexpr int MPI_COMPRESS = 32;
+constexpr int GATHER_TREE = 64;
+constexpr int SCATTER_TREE = 128;
 
 constexpr int NQUEUE = 4;
 
+//! reorder the processors with MPI_Dist_graph_create (the MPI implementation choose the mapping)
+constexpr int GRAPH_REORDER_MPI = 0;
+//! reorder the processors with a greedy mapping of the communication graph on the nodes
+constexpr int GRAPH_REORDER_NODE = 1;
+
 // number of vcluster instances
 extern size_t n_vcluster;
 // Global MPI initialization
 extern bool global_mpi_init;
 // initialization flag
 extern bool ofp_initialized;
-extern size_t tot_sent;
-extern size_t tot_recv;
+extern std::atomic<size_t> tot_sent;
+extern std::atomic<size_t> tot_recv;
 
 ///////////////////// Post functions /////////////
 
@@ -76,6 +101,49 @@ template<typename T> void assign(T * ptr1, T * ptr2)
 	*ptr1 = *ptr2;
 };
 
+/*! \brief Get the MPI datatype of a reduction that can be fused
+ *
+ * Only primitive scalars are fused
+ *
+ */
+template<typename T, bool prim = MPI_TypeW<T>::value>
+struct red_fusion_type
+{
+	static bool get(MPI_Datatype & dt)
+	{
+		return false;
+	}
+};
+
+template<typename T>
+struct red_fusion_type<T,true>
+{
+	static bool get(MPI_Datatype & dt)
+	{
+		dt = MPI_TypeW<T>::type();
+		return true;
+	}
+};
+
+//! A deferred scalar reduction
+struct red_deferred
+{
+	//! pointer to the variable to reduce
+	void * ptr;
+
+	//! datatype
+	MPI_Datatype type;
+
+	//! operation
+	MPI_Op op;
+
+	//! size of the variable
+	size_t size;
+
+	//! fused group (reductions with the same datatype and operation)
+	size_t group;
+};
+
 
 //! temporal buffer for reductions
 union red
@@ -160,11 +228,32 @@ class Vcluster_base
 	openfpm::vector<MPI_Status> stat;
 
 	//! vector of functions to execute after all the request has been performed
-	std::vector<int> post_exe;
+	std::vector<std::function<void()>> post_exe;
+
+	//! request group of each request
+	openfpm::vector<size_t> req_grp;
+
+	//! request group of each post function
+	openfpm::vector<size_t> post_grp;
+
+	//! request group of the new requests
+	size_t cur_grp = 0;
+
+	//! requests of the group waited or tested
+	openfpm::vector<MPI_Request> req_sel;
+
+	//! scalar reductions waiting for execute()
+	std::vector<red_deferred> red_queue;
+
+	//! fuse the scalar reductions
+	bool red_fusion = true;
 
 	//! standard context for gpu (if cuda is detected otherwise is unused)
 	gpu::ofp_context_t* gpuContext;
 
+	//! the gpu context is shared with the parent (sub-communicator views)
+	bool gpu_shared = false;
+
 	// Single objects
 
 	//! number of processes
@@ -175,6 +264,21 @@ class Vcluster_base
 	//! number of processing unit per process
 	int numPE = 1;
 
+	//! processing unit of this Vcluster inside the process
+	size_t pe = 0;
+
+	//! processing units of the process (NULL with one processing unit per process)
+	Vcluster_pe_group * pe_grp = NULL;
+
+	//! messages posted to the processing units of this process and not yet copied
+	std::atomic<size_t> pe_pending{0};
+
+	//! messages taken from the mailbox
+	std::vector<Vcluster_pe_msg> pe_in;
+
+	//! send also the empty messages (exchanges with known processors redirected on the NBX)
+	bool nbx_send_empty = false;
+
 	//////////////// NBX calls status variables ///////////////
 
 	NBX_Type NBX_active[NQUEUE];
@@ -188,6 +292,12 @@ class Vcluster_base
 	//! Is the barrier request reached
 	bool NBX_prc_reached_bar_req[NQUEUE];
 
+	//! for each queue the round signalled to the other processing units (0 if not signalled)
+	size_t NBX_prc_pe_round[NQUEUE];
+
+	//! for each queue the receive list of the exchanges with known processors redirected on the NBX
+	Vcluster_pe_known NBX_prc_known[NQUEUE];
+
 	////// Status variables for NBX send with known/unknown processors
 
 	int NBX_prc_cnt_base = 0;
@@ -232,511 +342,1980 @@ class Vcluster_base
 	//! NBX_cycle
 	int nbx_cycle;
 
-	//! disable copy constructor
-	Vcluster_base(const Vcluster_base &)
-	{};
+	//! message compressor (MPI_COMPRESS option)
+	Vcluster_compress cmp;
 
-	void queue_all_sends(size_t n_send , size_t sz[],
-						 size_t prc[], void * ptr[])
-	{
-		if (stat.size() != 0 || (req.size() != 0 && NBX_prc_qcnt == 0))
-		{std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " this function must be called when no other requests are in progress. Please remember that if you use function like max(),sum(),send(),recv() check that you did not miss to call the function execute() \n";}
+	//! for each queue, indicate if the messages are compressed
+	bool NBX_prc_compress[NQUEUE];
 
+	//! compressed send buffers for each queue
+	std::vector<std::vector<unsigned char>> cmp_send_buf[NQUEUE];
 
-		if (NBX_prc_qcnt == 0)
-		{
-			stat.clear();
-			req.clear();
-			// Do MPI_Issend
-		}
+	//! receive buffer for compressed messages
+	std::vector<unsigned char> cmp_recv_buf;
 
-		for (size_t i = 0 ; i < n_send ; i++)
-		{
-			if (sz[i] != 0)
-			{
-				req.add();
+	//! for each queue, messages to this processor (delivered without MPI)
+	openfpm::vector<size_t> self_send[NQUEUE];
 
-#ifdef SE_CLASS2
-				check_valid(ptr[i],sz[i]);
-#endif
+	//! bytes sent to each processor (communication graph)
+	openfpm::vector<size_t> comm_graph;
 
-				tot_sent += sz[i];
+	//! the communication graph is recorded
+	bool graph_rec = false;
 
-//				std::cout << "TAG: " << SEND_SPARSE + (NBX_cnt + NBX_prc_qcnt)*131072 + i << "   " << NBX_cnt << "   "  << NBX_prc_qcnt << "  " << " rank: " << rank() << "   " << NBX_prc_cnt_base << "  nbx_cycle: " << nbx_cycle << std::endl;
+	//! category of the communications done with send() and recv()
+	int prof_api = VCL_PROF_P2P;
 
-				if (sz[i] > 2147483647)
-				{MPI_SAFE_CALL(MPI_Issend(ptr[i], (sz[i] >> 3) + 1 , MPI_DOUBLE, prc[i], SEND_SPARSE + (NBX_cnt + NBX_prc_qcnt)*131072 + i, ext_comm,&req.last()));}
-				else
-				{MPI_SAFE_CALL(MPI_Issend(ptr[i], sz[i], MPI_BYTE, prc[i], SEND_SPARSE + (NBX_cnt + NBX_prc_qcnt)*131072 + i, ext_comm,&req.last()));}
-				log.logSend(prc[i]);
-			}
-		}
+	//! for each queue the category
+	int NBX_prc_api[NQUEUE];
+
+	//! for each queue the start time of the exchange (histograms of the latencies)
+	double NBX_prc_t0[NQUEUE];
+
+	//! for each queue the time when the exchange has been posted
+	double NBX_prc_tstart[NQUEUE];
+
+	//! for each queue the time spent receiving
+	double NBX_prc_trecv[NQUEUE];
+
+	//! times of the last NBX
+	Vcluster_nbx_timing nbx_last;
+
+	//! times of the NBX accumulated since the last reset
+	Vcluster_nbx_timing nbx_tot;
+
+	/*! \brief Store the times of a completed NBX
+	 *
+	 * \param q queue
+	 * \param t_reach time when the local sends completed
+	 *
+	 */
+	void nbx_timing(size_t q, double t_reach)
+	{
+		double t_end = MPI_Wtime();
+
+		nbx_last.n = 1;
+		nbx_last.t[VCL_NBX_SEND] = t_reach - NBX_prc_tstart[q];
+		nbx_last.t[VCL_NBX_BARRIER] = t_end - t_reach;
+		nbx_last.t[VCL_NBX_RECV] = NBX_prc_trecv[q];
+		nbx_last.t[VCL_NBX_TOTAL] = t_end - NBX_prc_tstart[q];
+
+		nbx_tot.add(nbx_last);
 	}
 
-protected:
+	//! file where the histograms are written at finalize
+	std::string hist_file;
 
-	//! Receive buffers
-	openfpm::vector_fr<BMemory<InternalMemory>> recv_buf[NQUEUE];
+	//! file where the profile is written at finalize
+	std::string prof_file;
 
-	//! tags receiving
-	openfpm::vector<size_t> tags[NQUEUE];
+	//! file where the trace is written at finalize
+	std::string trace_file;
 
-public:
+	/*! \brief Category of a communication
+	 *
+	 * \param api category of the function called
+	 *
+	 * \return the category to record
+	 *
+	 */
+	inline int prof_cat(int api)
+	{
+		return (prof_sem >= 0)?prof_sem:api;
+	}
 
-	// Finalize the MPI program
-	~Vcluster_base()
+	/*! \brief Gather the text of all the processors on the processor 0
+	 *
+	 * \param loc text of this processor
+	 * \param all concatenated text in processor order, followed by a zero (only on processor 0)
+	 *
+	 * \return true on the processor 0
+	 *
+	 */
+	bool gather_text(const std::string & loc, std::vector<char> & all)
 	{
-#ifdef SE_CLASS2
-		check_delete(this);
-#endif
-		n_vcluster--;
+		int sz = loc.size();
+		openfpm::vector<int> sz_all;
+		openfpm::vector<int> displ;
 
-		// if there are no other vcluster instances finalize
-		if (n_vcluster == 0)
+		if (m_rank == 0)
+		{sz_all.resize(m_size);}
+
+		MPI_SAFE_CALL(MPI_Gather(&sz,1,MPI_INT,sz_all.getPointer(),1,MPI_INT,0,ext_comm));
+
+		if (m_rank == 0)
 		{
-			int already_finalised;
+			displ.resize(m_size);
 
-			MPI_Finalized(&already_finalised);
-			if (!already_finalised && ext_comm == MPI_COMM_WORLD)
+			size_t tot = 0;
+			for (size_t i = 0 ; i < (size_t)m_size ; i++)
 			{
-				if (MPI_Finalize() != 0)
-				{
-					std::cerr << __FILE__ << ":" << __LINE__  << " MPI_Finalize FAILED \n";
-				}
+				displ.get(i) = tot;
+				tot += sz_all.get(i);
 			}
+
+			all.resize(tot+1);
+			all[tot] = 0;
 		}
 
-		delete gpuContext;
+		MPI_SAFE_CALL(MPI_Gatherv(loc.data(),sz,MPI_CHAR,all.data(),sz_all.getPointer(),displ.getPointer(),MPI_CHAR,0,ext_comm));
+
+		return m_rank == 0;
 	}
-	/*! \brief Virtual cluster constructor
+
+	/*! \brief Record a message in the communication graph
 	 *
-	 * \param argc pointer to arguments counts passed to the program
-	 * \param argv pointer to arguments vector passed to the program
+	 * \param prc destination processor
+	 * \param sz size of the message in byte
 	 *
 	 */
-	Vcluster_base(int *argc, char ***argv, MPI_Comm ext_comm)
-	:ext_comm(ext_comm),NBX_cnt(0)
+	inline void record_send(size_t prc, size_t sz)
 	{
-		// reset NBX_Active
+		if (graph_rec == true)
+		{comm_graph.get(prc) += sz;}
+	}
 
-		for (unsigned int i = 0 ; i < NQUEUE ; i++)
+	/*! \brief Greedy mapping of the communication graph on the nodes
+	 *
+	 * Node after node, the processor with the biggest traffic still unassigned is placed on
+	 * the node, then the node is filled with the processors that communicate most with the
+	 * ones already placed
+	 *
+	 * \param adj for each processor its edges (neighbor, weight), every edge is stored on both the
+	 *        processors and the weights of repeated edges are summed
+	 * \param node_of node of each processor
+	 * \param key for each processor the task (new rank) that it get
+	 *
+	 */
+	void greedy_node_map(const std::vector<std::vector<std::pair<size_t,double>>> & adj, const openfpm::vector<int> & node_of, openfpm::vector<int> & key)
+	{
+		size_t np = node_of.size();
+
+		// slots of each node (nodes are identified by their first processor)
+		std::map<int,std::vector<size_t>> slots;
+		for (size_t i = 0 ; i < np ; i++)
+		{slots[node_of.get(i)].push_back(i);}
+
+		std::vector<double> tot(np,0.0);
+		for (size_t i = 0 ; i < np ; i++)
 		{
-			NBX_active[i] = NBX_Type::NBX_UNACTIVE;
-			rid[i] = 0;
+			for (auto & e : adj[i])
+			{tot[i] += e.second;}
 		}
 
-#ifdef SE_CLASS2
-		check_new(this,8,VCLUSTER_EVENT,PRJ_VCLUSTER);
-#endif
+		std::vector<bool> assigned(np,false);
+		std::vector<double> conn(np);
+		key.resize(np);
 
-		n_vcluster++;
+		for (auto & n : slots)
+		{
+			std::fill(conn.begin(),conn.end(),0.0);
 
-		int already_initialised;
-		MPI_Initialized(&already_initialised);
+			for (size_t k = 0 ; k < n.second.size() ; k++)
+			{
+				// the seed is the processor with more traffic, then the most connected
+				const std::vector<double> & score = (k == 0)?tot:conn;
 
-		// Check if MPI is already initialized
-		if (!already_initialised)
-		{
-			MPI_Init(argc,argv);
+				size_t best = np;
+				for (size_t i = 0 ; i < np ; i++)
+				{
+					if (assigned[i] == false && (best == np || score[i] > score[best]))
+					{best = i;}
+				}
+
+				assigned[best] = true;
+				key.get(n.second[k]) = best;
+
+				for (auto & e : adj[best])
+				{conn[e.first] += e.second;}
+			}
 		}
+	}
 
-		// We try to get the local processors rank
+	//! disable copy constructor
+	Vcluster_base(const Vcluster_base &)
+	{};
 
-		MPI_Comm shmcomm;
-		MPI_Comm_split_type(ext_comm, MPI_COMM_TYPE_SHARED, 0,
-							MPI_INFO_NULL, &shmcomm);
+	/*! \brief Queue a scalar reduction to be fused with the others at execute()
+	 *
+	 * \param num variable to reduce
+	 * \param op operation
+	 *
+	 * \return true if the reduction has been queued
+	 *
+	 */
+	template<typename T> bool defer_reduction(T & num, MPI_Op op)
+	{
+		MPI_Datatype dt;
 
-		MPI_Comm_rank(shmcomm, &shmrank);
-		MPI_Comm_free(&shmcomm);
+		if (red_fusion == false || red_fusion_type<T>::get(dt) == false)
+		{return false;}
 
-		// Get the total number of process
-		// and the rank of this process
+		red_queue.push_back({&num,dt,op,sizeof(T),0});
 
-		MPI_Comm_size(ext_comm, &m_size);
-		MPI_Comm_rank(ext_comm, &m_rank);
+		return true;
+	}
 
-#ifdef SE_CLASS2
-			process_v_cl = m_rank;
-#endif
+	/*! \brief Post the queued reductions
+	 *
+	 * Reductions with the same datatype and operation are packed in one buffer and reduced
+	 * with one MPI_Iallreduce, the results are copied back after the requests complete. The groups
+	 * are formed in the order of the calls, so they are the same on all the processors. The packed
+	 * buffers are owned by the post functions, so they are released with their request group
+	 *
+	 */
+	void flush_reductions()
+	{
+		if (red_queue.size() == 0)
+		{return;}
 
-		// create and fill map scatter with one
-		map_scatter.resize(m_size);
+		// for each fused group the first reduction and the number of reductions
+		std::vector<std::pair<size_t,size_t>> red_group;
 
-		for (size_t i = 0 ; i < map_scatter.size() ; i++)
+		for (size_t i = 0 ; i < red_queue.size() ; i++)
 		{
-			map_scatter.get(i) = 1;
+			size_t g = 0;
+			for ( ; g < red_group.size() ; g++)
+			{
+				red_deferred & f = red_queue[red_group[g].first];
+				if (f.type == red_queue[i].type && f.op == red_queue[i].op)
+				{break;}
+			}
+
+			if (g == red_group.size())
+			{red_group.push_back(std::make_pair(i,(size_t)0));}
+
+			red_group[g].second++;
+			red_queue[i].group = g;
 		}
 
-		// open the log file
-		log.openLog(m_rank);
+		for (size_t g = 0 ; g < red_group.size() ; g++)
+		{
+			red_deferred & f = red_queue[red_group[g].first];
 
-		// Initialize bar_req
-		bar_req = MPI_Request();
-		bar_stat = MPI_Status();
+			req.add();
 
-#ifdef EXTERNAL_SET_GPU
-		int dev;
-		cudaGetDevice(&dev);
-		gpuContext = new gpu::ofp_context_t(gpu::gpu_context_opt::no_print_props,dev);
-#else
-		gpuContext = new gpu::ofp_context_t(gpu::gpu_context_opt::no_print_props,shmrank);
-#endif
+			if (red_group[g].second == 1)
+			{
+				MPI_SAFE_CALL(MPI_Iallreduce(MPI_IN_PLACE, f.ptr, 1, f.type, f.op, ext_comm,&req.last()));
+				continue;
+			}
 
+			// pack
+			size_t sz = f.size;
+			std::shared_ptr<std::vector<unsigned char>> buf(new std::vector<unsigned char>(red_group[g].second*sz));
+			std::vector<void *> dst;
 
-#if defined(PRINT_RANK_TO_GPU) && defined(CUDA_GPU)
+			for (size_t i = red_group[g].first ; i < red_queue.size() ; i++)
+			{
+				if (red_queue[i].group != g)
+				{continue;}
 
-		char node_name[MPI_MAX_PROCESSOR_NAME];
-		int len;
+				memcpy(buf->data() + dst.size()*sz,red_queue[i].ptr,sz);
+				dst.push_back(red_queue[i].ptr);
+			}
 
-		MPI_Get_processor_name(node_name,&len);
+			MPI_SAFE_CALL(MPI_Iallreduce(MPI_IN_PLACE, buf->data(), red_group[g].second, f.type, f.op, ext_comm,&req.last()));
 
-		std::cout << "Rank: " << m_rank << " on host: " << node_name << " work on GPU: " << gpuContext->getDevice() << "/" << gpuContext->getNDevice() << std::endl;
-#endif
+			// unpack when completed
+			post_exe.push_back([buf,dst,sz]()
+			{
+				for (size_t k = 0 ; k < dst.size() ; k++)
+				{memcpy(dst[k],buf->data() + k*sz,sz);}
+			});
+		}
 
-		int flag;
-		void *tag_ub_v;
-		int tag_ub;
+		red_queue.clear();
+	}
 
-		MPI_Comm_get_attr(ext_comm, MPI_TAG_UB, &tag_ub_v, &flag);
+	/*! \brief Assign the current request group to the requests and the post functions not yet assigned
+	 *
+	 */
+	void tag_requests()
+	{
+		// the NBX communications clear the requests by themself
+		if (req_grp.size() > req.size())
+		{req_grp.resize(req.size());}
 
-		if (flag == true)
+		while (req_grp.size() < req.size())
+		{req_grp.add(cur_grp);}
+
+		if (post_grp.size() > post_exe.size())
+		{post_grp.resize(post_exe.size());}
+
+		while (post_grp.size() < post_exe.size())
+		{post_grp.add(cur_grp);}
+	}
+
+	/*! \brief Execute the post functions of a completed group and remove its requests
+	 *
+	 * \param g group
+	 *
+	 */
+	void release_group(size_t g)
+	{
+		size_t k = 0;
+		for (size_t i = 0 ; i < req.size() ; i++)
 		{
-			tag_ub = *(int*)tag_ub_v;
-			nbx_cycle = (tag_ub - SEND_SPARSE - 131072 - NQUEUE*131072) / 131072;
+			if (req_grp.get(i) == g)
+			{continue;}
 
-			if (nbx_cycle < NQUEUE*2) {
-				std::cerr << __FILE__ << ":" << __LINE__ << " Error MPI_TAG_UB is too small for OpenFPM" << std::endl;
-			}
+			req.get(k) = req.get(i);
+			req_grp.get(k) = req_grp.get(i);
+			k++;
 		}
-		else
+
+		req.resize(k);
+		req_grp.resize(k);
+
+		// the post functions can queue other post functions, so they are moved out before
+		std::vector<std::function<void()>> pe;
+		openfpm::vector<size_t> pg;
+
+		pe.swap(post_exe);
+		pg.swap(post_grp);
+
+		for (size_t i = 0 ; i < pe.size() ; i++)
 		{
-			nbx_cycle = 2048;
+			if (pg.get(i) == g)
+			{pe[i]();}
+			else
+			{
+				post_exe.push_back(pe[i]);
+				post_grp.add(pg.get(i));
+			}
 		}
 	}
 
-#ifdef SE_CLASS1
-
-	/*! \brief Check for wrong types
+	/*! \brief Tag of a message of the NBX on the current queue
 	 *
-	 * In general we do not know if a type T make sense to be sent or not, but if it has pointer
-	 * inside it does not. This function check if the basic type T has a method called noPointers,
-	 * This function in general notify if T has internally pointers. If T has pointer an error
-	 * is printed, is T does not have the method a WARNING is printed
+	 * With several processing units per process the tag also carry the processing unit of the
+	 * sender (the MPI source is only the process)
 	 *
-	 * \tparam T type to check
+	 * \param i message
+	 *
+	 * \return the tag
 	 *
 	 */
-	template<typename T> void checkType()
+	inline size_t nbx_tag(size_t i)
 	{
-		// if T is a primitive like int, long int, float, double, ... make sense
-		// (pointers, l-references and r-references are not fundamentals)
-		if (std::is_fundamental<T>::value == true)
-		{return;}
+		return SEND_SPARSE + (NBX_cnt + NBX_prc_qcnt)*131072 + i*numPE + pe;
+	}
 
-		// if it is a pointer make no sense
-		if (std::is_pointer<T>::value == true)
-		{std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " the type " << demangle(typeid(T).name()) << " is a pointer, sending pointers values has no sense\n";}
+	/*! \brief Deliver the messages that the processor send to itself
+	 *
+	 * They are copied directly in the buffer given by the call-back, without MPI messages.
+	 * It must be called when the call-back of the queue is set
+	 *
+	 * \param sz size of the messages
+	 * \param ptr messages
+	 *
+	 */
+	void deliver_self(size_t sz[], void * ptr[])
+	{
+		if (self_send[NBX_prc_qcnt].size() == 0)
+		{return;}
 
-		// if it is an l-value reference make no send
-		if (std::is_lvalue_reference<T>::value == true)
-		{std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " the type " << demangle(typeid(T).name()) << " is a pointer, sending pointers values has no sense\n";}
+		vcl_trace_scope ts(trace,"nbx_self");
 
-		// if it is an r-value reference make no send
-		if (std::is_rvalue_reference<T>::value == true)
-		{std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " the type " << demangle(typeid(T).name()) << " is a pointer, sending pointers values has no sense\n";}
+		for (size_t k = 0 ; k < self_send[NBX_prc_qcnt].size() ; k++)
+		{
+			size_t i = self_send[NBX_prc_qcnt].get(k);
 
-		// ... if not, check that T has a method called noPointers
-		switch (check_no_pointers<T>::value())
+			void * ptr_r = this->NBX_prc_msg_alloc[NBX_prc_qcnt](sz[i],0,0,getProcessUnitID(),rid[NBX_prc_qcnt],nbx_tag(i),this->NBX_prc_ptr_arg[NBX_prc_qcnt]);
+
+			rid[NBX_prc_qcnt]++;
+
+			if (sz[i] != 0)
+			{memcpy(ptr_r,ptr[i],sz[i]);}
+
+			prof.send(NBX_prc_api[NBX_prc_qcnt],getProcessUnitID(),sz[i]);
+			prof.recv(NBX_prc_api[NBX_prc_qcnt],getProcessUnitID(),sz[i]);
+		}
+
+		self_send[NBX_prc_qcnt].clear();
+	}
+
+	void queue_all_sends(size_t n_send , size_t sz[],
+						 size_t prc[], void * ptr[], long int opt = NONE)
+	{
+		if (stat.size() != 0 || (req.size() != 0 && NBX_prc_qcnt == 0))
+		{std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " this function must be called when no other requests are in progress. Please remember that if you use function like max(),sum(),send(),recv() check that you did not miss to call the function execute() \n";}
+
+
+		if (NBX_prc_qcnt == 0)
 		{
-			case PNP::UNKNOWN:
+			stat.clear();
+			req.clear();
+			// Do MPI_Issend
+		}
+
+		NBX_prc_api[NBX_prc_qcnt] = prof_cat(VCL_PROF_NBX_UNKNOWN);
+		NBX_prc_tstart[NBX_prc_qcnt] = MPI_Wtime();
+		NBX_prc_trecv[NBX_prc_qcnt] = 0.0;
+		cnt.nbx_round();
+
+		// In case of compression every message is encoded (header + payload)
+		NBX_prc_compress[NBX_prc_qcnt] = (opt & MPI_COMPRESS) && !(opt & MPI_GPU_DIRECT);
+
+		if (NBX_prc_compress[NBX_prc_qcnt] == true)
+		{cmp_send_buf[NBX_prc_qcnt].resize(n_send);}
+
+		self_send[NBX_prc_qcnt].clear();
+
+		if (n_send*numPE >= 131072)
+		{std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " too many messages (" << n_send << ") for " << numPE << " processing units per process" << std::endl;}
+
+		for (size_t i = 0 ; i < n_send ; i++)
+		{
+			bool send_msg = (sz[i] != 0 || nbx_send_empty == true);
+			bool local = send_msg == true && !(opt & MPI_GPU_DIRECT) && NBX_prc_compress[NBX_prc_qcnt] == false;
+
+			// messages to this processor are copied by deliver_self (compressed messages keep going
+			// through MPI so the compression statistics cover all the messages)
+			if (local == true && prc[i] == getProcessUnitID())
 			{
-				std::cerr << "Warning: " << __FILE__ << ":" << __LINE__ << " impossible to check the type " << demangle(typeid(T).name()) << " please consider to add a static method \"static bool noPointers()\" \n" ;
-				break;
+				self_send[NBX_prc_qcnt].add(i);
+				continue;
 			}
-			case PNP::POINTERS:
+
+			// messages to the other processing units of the process are copied by the receiver
+			if (local == true && pe_grp != NULL && prc[i] / numPE == (size_t)m_rank)
 			{
-				std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " the type " << demangle(typeid(T).name()) << " has pointers inside, sending pointers values has no sense\n";
-				break;
+				Vcluster_pe_msg m;
+				m.ptr = ptr[i];
+				m.sz = sz[i];
+				m.src = getProcessUnitID();
+				m.tag = nbx_tag(i);
+				m.pending = &pe_pending;
+
+				pe_pending++;
+				pe_grp->post(prc[i] % numPE,m);
+
+				tot_sent += sz[i];
+				prof.send(NBX_prc_api[NBX_prc_qcnt],prc[i],sz[i]);
+				hist.size(NBX_prc_api[NBX_prc_qcnt],sz[i]);
+				cnt.send(sz[i]);
+				continue;
 			}
-			default:
+
+			if (send_msg == true)
 			{
+				req.add();
+
+#ifdef SE_CLASS2
+				check_valid(ptr[i],sz[i]);
+#endif
+
+				void * ptr_s = ptr[i];
+				size_t sz_s = sz[i];
+
+				if (NBX_prc_compress[NBX_prc_qcnt] == true)
+				{
+					cmp.encode(ptr[i],sz[i],cmp_send_buf[NBX_prc_qcnt][i]);
+					ptr_s = cmp_send_buf[NBX_prc_qcnt][i].data();
+					sz_s = cmp_send_buf[NBX_prc_qcnt][i].size();
+				}
+
+				tot_sent += sz_s;
+				record_send(prc[i] / numPE,sz_s);
+				prof.send(NBX_prc_api[NBX_prc_qcnt],prc[i],sz_s);
+				hist.size(NBX_prc_api[NBX_prc_qcnt],sz_s);
+				cnt.send(sz_s);
+
+//				std::cout << "TAG: " << SEND_SPARSE + (NBX_cnt + NBX_prc_qcnt)*131072 + i << "   " << NBX_cnt << "   "  << NBX_prc_qcnt << "  " << " rank: " << rank() << "   " << NBX_prc_cnt_base << "  nbx_cycle: " << nbx_cycle << std::endl;
 
+				// with several processing units the message go to the communicator of the receiving one
+				int dst = prc[i] / numPE;
+				MPI_Comm comm = (pe_grp != NULL)?pe_grp->getComm(prc[i] % numPE):ext_comm;
+
+				if (sz_s > 2147483647)
+				{MPI_SAFE_CALL(MPI_Issend(ptr_s, (sz_s >> 3) + 1 , MPI_DOUBLE, dst, nbx_tag(i), comm,&req.last()));}
+				else
+				{MPI_SAFE_CALL(MPI_Issend(ptr_s, sz_s, MPI_BYTE, dst, nbx_tag(i), comm,&req.last()));}
+				log.logSend(prc[i]);
 			}
 		}
 	}
 
-#endif
-
-	/*! \brief If nvidia cuda is activated return a gpu context
+	/*! \brief Receive the messages posted by the other processing units of the process
 	 *
-	 * \param iw ignore warning
+	 * Only the messages of the queues in progress are taken, the others stay in the mailbox
 	 *
 	 */
-	gpu::ofp_context_t& getGpuContext(bool iw = true)
+	void pe_receive()
 	{
-		if (gpuContext == NULL && iw == true)
+		pe_in.clear();
+
+		pe_grp->drain(pe,[this](const Vcluster_pe_msg & m)
 		{
-			std::cout << __FILE__ << ":" << __LINE__ << " Warning: it seem that a gpu context is not initialized."
-														"Either a compatible working cuda device has not been found, either openfpm_init has been called in a file that not compiled with NVCC" << std::endl;
-		}
+			unsigned int i = (m.tag - SEND_SPARSE) / 131072 - NBX_prc_cnt_base;
+			return i < NQUEUE && NBX_active[i] == NBX_Type::NBX_UNKNOWN;
+		},pe_in);
 
-		return *gpuContext;
+		for (size_t k = 0 ; k < pe_in.size() ; k++)
+		{
+			Vcluster_pe_msg & m = pe_in[k];
+			unsigned int i = (m.tag - SEND_SPARSE) / 131072 - NBX_prc_cnt_base;
+
+			void * ptr = this->NBX_prc_msg_alloc[i](m.sz,0,0,m.src,rid[i],m.tag,this->NBX_prc_ptr_arg[i]);
+
+			rid[i]++;
+
+			if (m.sz != 0)
+			{memcpy(ptr,m.ptr,m.sz);}
+
+			tot_recv += m.sz;
+			prof.recv(NBX_prc_api[i],m.src,m.sz);
+			cnt.recv(m.sz);
+
+			// the sender can now reuse the buffer
+			m.pending->fetch_sub(1);
+		}
 	}
 
-	/*! \brief Get the MPI_Communicator (or processor group) this VCluster is using
+	/*! \brief Check if all the processing units of the process completed their sends
 	 *
-	 * \return MPI comunicator
+	 * The first time the local sends are completed (MPI and mailbox) it is signalled to the other
+	 * processing units
+	 *
+	 * \param i queue
+	 *
+	 * \return true if the barrier of the queue can be called
 	 *
 	 */
-	MPI_Comm getMPIComm()
+	bool pe_reached(unsigned int i)
 	{
-		return ext_comm;
+		if (NBX_prc_pe_round[i] == 0)
+		{
+			if (pe_pending.load() != 0)
+			{return false;}
+
+			NBX_prc_pe_round[i] = pe_grp->signal(pe);
+		}
+
+		return pe_grp->reached(NBX_prc_pe_round[i]);
 	}
 
-	/*! \brief Get the total number of processors
-	 *
-	 * \return the total number of processors
+	/*! \brief Check the status of all the MPI_issend and call the barrier if finished
 	 *
 	 */
-	size_t getProcessingUnits()
+	void test_sends()
 	{
-		return m_size*numPE;
+		for (unsigned int i = 0 ; i < NQUEUE ; i++)
+		{
+			if (i >= NQUEUE || NBX_active[i] == NBX_Type::NBX_UNACTIVE || NBX_active[i] == NBX_Type::NBX_KNOWN || NBX_active[i] == NBX_Type::NBX_KNOWN_PRC)
+			{continue;}
+
+			if (NBX_prc_reached_bar_req[i] == false)
+			{
+				int flag = false;
+				if (req.size() != 0)
+				{MPI_SAFE_CALL(MPI_Testall(req.size(),&req.get(0),&flag,MPI_STATUSES_IGNORE));}
+				else
+				{flag = true;}
+
+				// with several processing units wait also the other processing units of the process
+				if (flag == true && pe_grp != NULL)
+				{flag = pe_reached(i);}
+
+				// If all send has been completed
+				if (flag == true)
+				{MPI_SAFE_CALL(MPI_Ibarrier(ext_comm,&bar_req));NBX_prc_reached_bar_req[i] = true;}
+			}
+		}
 	}
 
-	/*! \brief Get the total number of processors
+	/*! \brief Run an exchange with known processors on the NBX
 	 *
-	 * It is the same as getProcessingUnits()
-	 *
-	 * \see getProcessingUnits()
+	 * With several processing units per process the exchanges with known processors are done with
+	 * the NBX. Also the empty messages are sent, so the call-back is called for every receive like with MPI
 	 *
-	 * \return the total number of processors
+	 * \param n_send number of send
+	 * \param sz size of the messages
+	 * \param prc destination processors
+	 * \param ptr messages
+	 * \param n_recv number of receive
+	 * \param prc_recv processors from which we receive
+	 * \param sz_recv size of the messages to receive (NULL if not known)
+	 * \param sz_out where to store the received sizes (NULL if not needed)
+	 * \param msg_alloc call-back
+	 * \param ptr_arg argument of the call-back
+	 * \param async use sendrecvMultipleMessagesNBXAsync
 	 *
 	 */
-	size_t size()
+	void pe_known_nbx(size_t n_send , size_t sz[], size_t prc[], void * ptr[],
+					  size_t n_recv, size_t prc_recv[], size_t sz_recv[], size_t sz_out[],
+					  void * (* msg_alloc)(size_t,size_t,size_t,size_t,size_t,size_t,void *),
+					  void * ptr_arg, bool async)
 	{
-		return this->m_size*numPE;
-	}
+		if (NBX_prc_qcnt + 1 >= NQUEUE)
+		{
+			std::cout << __FILE__ << ":" << __LINE__ << " error you can queue at most " << NQUEUE << " asychronous communication functions " << std::endl;
+			return;
+		}
 
-	void print_stats()
-	{
-#ifdef VCLUSTER_PERF_REPORT
-		std::cout << "-- REPORT COMMUNICATIONS -- " << std::endl;
+		Vcluster_pe_known & k = NBX_prc_known[NBX_prc_qcnt+1];
 
-		std::cout << "Processor " << this->rank() << " sent: " << tot_sent << std::endl;
-		std::cout << "Processor " << this->rank() << " received: " << tot_recv << std::endl;
+		k.n_recv = n_recv;
+		k.prc_recv = prc_recv;
+		k.sz_recv = sz_recv;
+		k.sz_out = sz_out;
+		k.done.assign(n_recv,false);
+		k.msg_alloc = msg_alloc;
+		k.ptr_arg = ptr_arg;
 
-		std::cout << "Processor " << this->rank() << " time spent: " << time_spent << std::endl;
-		std::cout << "Processor " << this->rank() << " Bandwidth: S:"  << (double)tot_sent / time_spent * 1e-9 << "GB/s  R:" << (double)tot_recv / time_spent * 1e-9 << "GB/s" <<  std::endl;
-#else
+		nbx_send_empty = true;
 
-		std::cout << "Error to activate performance stats on VCluster enable VCLUSTER_PERF_REPORT" << std::endl;
+		if (async == true)
+		{sendrecvMultipleMessagesNBXAsync(n_send,sz,prc,ptr,Vcluster_pe_known::msg_alloc_pe,&k);}
+		else
+		{sendrecvMultipleMessagesNBX(n_send,sz,prc,ptr,Vcluster_pe_known::msg_alloc_pe,&k);}
 
-#endif
+		nbx_send_empty = false;
 	}
 
-	void clear_stats()
-	{
-#ifdef VCLUSTER_PERF_REPORT
-
-		tot_sent = 0;
-		tot_recv = 0;
-
-		time_spent = 0;
-#else
-
-		std::cout << "Error to activate performance stats on VCluster enable VCLUSTER_PERF_REPORT" << std::endl;
-
-#endif
-	}
+protected:
 
-	/*! \brief Get the process unit id
+	/*! \brief Make this Vcluster a processing unit of a process
 	 *
-	 * \return the process ID (rank in MPI)
+	 * \param grp processing units of the process
+	 * \param p processing unit
 	 *
 	 */
-	size_t getProcessUnitID()
+	void setPE(Vcluster_pe_group * grp, size_t p)
 	{
-		return m_rank;
+		pe_grp = grp;
+		pe = p;
+		numPE = grp->size();
+
+		prof.init(m_size*numPE);
 	}
 
-	/*! \brief Get the process unit id
+	/*! \brief Check that the function is not called on a processing unit
 	 *
-	 * It is the same as getProcessUnitID()
+	 * Collectives and send()/recv() address the processes. On a processing unit they would run on
+	 * its duplicate communicator and return the result of only one processing unit per process
 	 *
-	 * \see getProcessUnitID()
+	 * \param fun name of the function
 	 *
-	 * \return the process ID
+	 * \return false (with an error) if this Vcluster is a processing unit
 	 *
 	 */
-	size_t rank()
+	bool check_process_level(const char * fun)
 	{
-		return m_rank;
+		if (pe_grp != NULL)
+		{
+			std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " " << fun << " address the processes and cannot be called on a processing unit, call it on the Vcluster of the process" << std::endl;
+			return false;
+		}
+
+		return true;
 	}
 
+	//! Receive buffers
+	openfpm::vector_fr<BMemory<InternalMemory>> recv_buf[NQUEUE];
 
-	/*! \brief Sum the numbers across all processors and get the result
-	 *
-	 * \param num to reduce, input and output
-	 *
-	 */
+	//! tags receiving
+	openfpm::vector<size_t> tags[NQUEUE];
 
-	template<typename T> void sum(T & num)
-	{
-#ifdef SE_CLASS1
-		checkType<T>();
-#endif
+	//! per-peer profiler
+	Vcluster_profiler prof;
 
-		// reduce over MPI
+	//! category that override the others (set by the semantic communications), -1 if none
+	int prof_sem = -1;
 
-		// Create one request
-		req.add();
+	//! timeline of the communication phases
+	Vcluster_trace trace;
 
-		// reduce
-		MPI_IallreduceW<T>::reduce(num,MPI_SUM,req.last(), ext_comm);
-	}
+	//! communication counters
+	Vcluster_counters cnt;
 
-	/*! \brief Get the maximum number across all processors (or reduction with infinity norm)
-	 *
-	 * \param num to reduce
-	 *
-	 */
-	template<typename T> void max(T & num)
+	//! histograms of message sizes and latencies
+	Vcluster_histograms hist;
+
+public:
+
+	// Finalize the MPI program
+	~Vcluster_base()
 	{
-#ifdef SE_CLASS1
-		checkType<T>();
+#ifdef SE_CLASS2
+		check_delete(this);
 #endif
-		// reduce over MPI
+		n_vcluster--;
 
-		// Create one request
-		req.add();
+		// if there are no other vcluster instances finalize
+		if (n_vcluster == 0)
+		{
+			int already_finalised;
 
-		// reduce
-		MPI_IallreduceW<T>::reduce(num,MPI_MAX,req.last(), ext_comm);
-	}
+			MPI_Finalized(&already_finalised);
+			if (!already_finalised && ext_comm == MPI_COMM_WORLD)
+			{
+				if (MPI_Finalize() != 0)
+				{
+					std::cerr << __FILE__ << ":" << __LINE__  << " MPI_Finalize FAILED \n";
+				}
+			}
+		}
 
-	/*! \brief Get the minimum number across all processors (or reduction with insinity norm)
+		if (gpu_shared == false)
+		{delete gpuContext;}
+	}
+	/*! \brief Virtual cluster constructor
 	 *
-	 * \param num to reduce
+	 * \param argc pointer to arguments counts passed to the program
+	 * \param argv pointer to arguments vector passed to the program
 	 *
 	 */
-
-	template<typename T> void min(T & num)
+	Vcluster_base(int *argc, char ***argv, MPI_Comm ext_comm)
+	:ext_comm(ext_comm),NBX_cnt(0)
 	{
-#ifdef SE_CLASS1
-		checkType<T>();
-#endif
-		// reduce over MPI
+		// reset NBX_Active
 
-		// Create one request
-		req.add();
+		for (unsigned int i = 0 ; i < NQUEUE ; i++)
+		{
+			NBX_active[i] = NBX_Type::NBX_UNACTIVE;
+			NBX_prc_compress[i] = false;
+			NBX_prc_api[i] = VCL_PROF_NBX_UNKNOWN;
+			NBX_prc_t0[i] = -1.0;
+			NBX_prc_tstart[i] = 0.0;
+			NBX_prc_trecv[i] = 0.0;
+			NBX_prc_pe_round[i] = 0;
+			rid[i] = 0;
+		}
 
-		// reduce
-		MPI_IallreduceW<T>::reduce(num,MPI_MIN,req.last(), ext_comm);
+		nbx_last.zero();
+		nbx_tot.zero();
+
+#ifdef SE_CLASS2
+		check_new(this,8,VCLUSTER_EVENT,PRJ_VCLUSTER);
+#endif
+
+		n_vcluster++;
+
+		int already_initialised;
+		MPI_Initialized(&already_initialised);
+
+		// Check if MPI is already initialized
+		if (!already_initialised)
+		{
+#ifdef VCLUSTER_THREAD_MULTIPLE
+			int provided;
+			MPI_Init_thread(argc,argv,MPI_THREAD_MULTIPLE,&provided);
+
+			if (provided != MPI_THREAD_MULTIPLE)
+			{std::cerr << "Warning: " << __FILE__ << ":" << __LINE__ << " MPI does not support MPI_THREAD_MULTIPLE, the threads cannot communicate concurrently" << std::endl;}
+#else
+			MPI_Init(argc,argv);
+#endif
+		}
+
+		// We try to get the local processors rank
+
+		MPI_Comm shmcomm;
+		MPI_Comm_split_type(ext_comm, MPI_COMM_TYPE_SHARED, 0,
+							MPI_INFO_NULL, &shmcomm);
+
+		MPI_Comm_rank(shmcomm, &shmrank);
+		MPI_Comm_free(&shmcomm);
+
+		// Get the total number of process
+		// and the rank of this process
+
+		MPI_Comm_size(ext_comm, &m_size);
+		MPI_Comm_rank(ext_comm, &m_rank);
+
+#ifdef SE_CLASS2
+			process_v_cl = m_rank;
+#endif
+
+		// create and fill map scatter with one
+		map_scatter.resize(m_size);
+
+		for (size_t i = 0 ; i < map_scatter.size() ; i++)
+		{
+			map_scatter.get(i) = 1;
+		}
+
+		// open the log file
+		log.openLog(m_rank);
+
+		// the profiler can be activated from the environment
+		prof.init(m_size);
+
+		const char * prof_env = getenv("VCLUSTER_PROFILE");
+		if (prof_env != NULL)
+		{setProfileOutput(prof_env);}
+
+		const char * trace_env = getenv("VCLUSTER_TRACE");
+		if (trace_env != NULL)
+		{setTraceOutput(trace_env);}
+
+		const char * cnt_env = getenv("VCLUSTER_COUNTERS");
+		if (cnt_env != NULL && atoi(cnt_env) != 0)
+		{cnt.enable(true);}
+
+		const char * hist_env = getenv("VCLUSTER_HISTOGRAMS");
+		if (hist_env != NULL)
+		{setHistogramOutput(hist_env);}
+
+		// Initialize bar_req
+		bar_req = MPI_Request();
+		bar_stat = MPI_Status();
+
+#ifdef EXTERNAL_SET_GPU
+		int dev;
+		cudaGetDevice(&dev);
+		gpuContext = new gpu::ofp_context_t(gpu::gpu_context_opt::no_print_props,dev);
+#else
+		gpuContext = new gpu::ofp_context_t(gpu::gpu_context_opt::no_print_props,shmrank);
+#endif
+
+
+#if defined(PRINT_RANK_TO_GPU) && defined(CUDA_GPU)
+
+		char node_name[MPI_MAX_PROCESSOR_NAME];
+		int len;
+
+		MPI_Get_processor_name(node_name,&len);
+
+		std::cout << "Rank: " << m_rank << " on host: " << node_name << " work on GPU: " << gpuContext->getDevice() << "/" << gpuContext->getNDevice() << std::endl;
+#endif
+
+		int flag;
+		void *tag_ub_v;
+		int tag_ub;
+
+		MPI_Comm_get_attr(ext_comm, MPI_TAG_UB, &tag_ub_v, &flag);
+
+		if (flag == true)
+		{
+			tag_ub = *(int*)tag_ub_v;
+			nbx_cycle = (tag_ub - SEND_SPARSE - 131072 - NQUEUE*131072) / 131072;
+
+			if (nbx_cycle < NQUEUE*2) {
+				std::cerr << __FILE__ << ":" << __LINE__ << " Error MPI_TAG_UB is too small for OpenFPM" << std::endl;
+			}
+		}
+		else
+		{
+			nbx_cycle = 2048;
+		}
 	}
 
-	/*! \brief In case of Asynchonous communications like sendrecvMultipleMessagesNBXAsync this function
-	 * progress the communication
+	/*! \brief Constructor of a view on a sub-communicator
 	 *
+	 * MPI is already initialized, the gpu context and the NBX parameters are taken from the parent
+	 *
+	 * \param parent Vcluster of the communicator from which sub has been created
+	 * \param sub sub-communicator
 	 *
 	 */
-	void progressCommunication()
+	Vcluster_base(Vcluster_base<InternalMemory> & parent, MPI_Comm sub)
+	:ext_comm(sub),NBX_cnt(0)
 	{
-		MPI_Status stat_t;
-		int stat = false;
-		MPI_SAFE_CALL(MPI_Iprobe(MPI_ANY_SOURCE,MPI_ANY_TAG, ext_comm,&stat,&stat_t));
+		for (unsigned int i = 0 ; i < NQUEUE ; i++)
+		{
+			NBX_active[i] = NBX_Type::NBX_UNACTIVE;
+			NBX_prc_compress[i] = false;
+			NBX_prc_api[i] = VCL_PROF_NBX_UNKNOWN;
+			NBX_prc_t0[i] = -1.0;
+			NBX_prc_tstart[i] = 0.0;
+			NBX_prc_trecv[i] = 0.0;
+			NBX_prc_pe_round[i] = 0;
+			rid[i] = 0;
+		}
 
-		// If I have an incoming message and is related to this NBX communication
-		if (stat == true)
+		nbx_last.zero();
+		nbx_tot.zero();
+
+		n_vcluster++;
+
+		MPI_Comm_size(ext_comm, &m_size);
+		MPI_Comm_rank(ext_comm, &m_rank);
+
+		map_scatter.resize(m_size);
+
+		for (size_t i = 0 ; i < map_scatter.size() ; i++)
 		{
-			unsigned int i = (stat_t.MPI_TAG - SEND_SPARSE) / 131072 - NBX_prc_cnt_base;
+			map_scatter.get(i) = 1;
+		}
 
-			if (i >= NQUEUE || NBX_active[i] == NBX_Type::NBX_UNACTIVE || NBX_active[i] == NBX_Type::NBX_KNOWN  || NBX_active[i] == NBX_Type::NBX_KNOWN_PRC)
-			{return;}
+		bar_req = MPI_Request();
+		bar_stat = MPI_Status();
 
-			int msize_;
-			long int msize;
-			bool big_data = true;
+		prof.init(m_size);
 
-			// Get the message tag and size
+		shmrank = parent.shmrank;
+		nbx_cycle = parent.nbx_cycle;
+		gpuContext = parent.gpuContext;
+		gpu_shared = true;
+	}
 
-			MPI_SAFE_CALL(MPI_Get_count(&stat_t,MPI_DOUBLE,&msize_));
-			if (msize_ == MPI_UNDEFINED)
+#ifdef SE_CLASS1
+
+	/*! \brief Check for wrong types
+	 *
+	 * In general we do not know if a type T make sense to be sent or not, but if it has pointer
+	 * inside it does not. This function check if the basic type T has a method called noPointers,
+	 * This function in general notify if T has internally pointers. If T has pointer an error
+	 * is printed, is T does not have the method a WARNING is printed
+	 *
+	 * \tparam T type to check
+	 *
+	 */
+	template<typename T> void checkType()
+	{
+		// if T is a primitive like int, long int, float, double, ... make sense
+		// (pointers, l-references and r-references are not fundamentals)
+		if (std::is_fundamental<T>::value == true)
+		{return;}
+
+		// if it is a pointer make no sense
+		if (std::is_pointer<T>::value == true)
+		{std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " the type " << demangle(typeid(T).name()) << " is a pointer, sending pointers values has no sense\n";}
+
+		// if it is an l-value reference make no send
+		if (std::is_lvalue_reference<T>::value == true)
+		{std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " the type " << demangle(typeid(T).name()) << " is a pointer, sending pointers values has no sense\n";}
+
+		// if it is an r-value reference make no send
+		if (std::is_rvalue_reference<T>::value == true)
+		{std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " the type " << demangle(typeid(T).name()) << " is a pointer, sending pointers values has no sense\n";}
+
+		// ... if not, check that T has a method called noPointers
+		switch (check_no_pointers<T>::value())
+		{
+			case PNP::UNKNOWN:
 			{
-				big_data = false;
-				MPI_SAFE_CALL(MPI_Get_count(&stat_t,MPI_BYTE,&msize_));
-				msize = msize_;
+				std::cerr << "Warning: " << __FILE__ << ":" << __LINE__ << " impossible to check the type " << demangle(typeid(T).name()) << " please consider to add a static method \"static bool noPointers()\" \n" ;
+				break;
 			}
-			else
+			case PNP::POINTERS:
 			{
-				msize = ((size_t)msize_) << 3;
+				std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " the type " << demangle(typeid(T).name()) << " has pointers inside, sending pointers values has no sense\n";
+				break;
 			}
-
-			// Ok we check if the TAG come from one of our send TAG
-			if (stat_t.MPI_TAG >= (int)(SEND_SPARSE + NBX_prc_cnt_base*131072) && stat_t.MPI_TAG < (int)(SEND_SPARSE + (NBX_prc_cnt_base + NBX_prc_qcnt + 1)*131072))
+			default:
 			{
-				// Get the pointer to receive the message
-				void * ptr = this->NBX_prc_msg_alloc[i](msize,0,0,stat_t.MPI_SOURCE,rid[i],stat_t.MPI_TAG,this->NBX_prc_ptr_arg[i]);
-
-				// Log the receiving request
-				log.logRecv(stat_t);
 
-				rid[i]++;
+			}
+		}
+	}
 
-				// Check the pointer
-#ifdef SE_CLASS2
-				check_valid(ptr,msize);
-#endif
-				tot_recv += msize;
-#ifdef VCLUSTER_GARBAGE_INJECTOR
-#if defined (__NVCC__) && !defined(CUDA_ON_CPU)
-					cudaPointerAttributes cpa;
-					auto error = cudaPointerGetAttributes(&cpa,ptr);
-					if (error == cudaSuccess)
-					{
-						if(cpa.type == cudaMemoryTypeDevice)
-						{cudaMemset(ptr,0xFF,msize);}
-						else
-						{memset(ptr,0xFF,msize);}
-					}
-#else
-					memset(ptr,0xFF,msize);
 #endif
+
+	/*! \brief If nvidia cuda is activated return a gpu context
+	 *
+	 * \param iw ignore warning
+	 *
+	 */
+	gpu::ofp_context_t& getGpuContext(bool iw = true)
+	{
+		if (gpuContext == NULL && iw == true)
+		{
+			std::cout << __FILE__ << ":" << __LINE__ << " Warning: it seem that a gpu context is not initialized."
+														"Either a compatible working cuda device has not been found, either openfpm_init has been called in a file that not compiled with NVCC" << std::endl;
+		}
+
+		return *gpuContext;
+	}
+
+	/*! \brief Get the MPI_Communicator (or processor group) this VCluster is using
+	 *
+	 * \return MPI comunicator
+	 *
+	 */
+	MPI_Comm getMPIComm()
+	{
+		return ext_comm;
+	}
+
+	/*! \brief Check if the threads can communicate concurrently
+	 *
+	 * \return true if MPI has been initialized with MPI_THREAD_MULTIPLE
+	 *
+	 */
+	bool isThreadMultiple()
+	{
+		int provided;
+		MPI_SAFE_CALL(MPI_Query_thread(&provided));
+
+		return provided == MPI_THREAD_MULTIPLE;
+	}
+
+	/*! \brief Get the total number of processors
+	 *
+	 * \return the total number of processors
+	 *
+	 */
+	size_t getProcessingUnits()
+	{
+		return m_size*numPE;
+	}
+
+	/*! \brief Get the number of processing units of each process
+	 *
+	 * \return 1, or the number of PE contexts if this Vcluster is one of them (see Vcluster::createPEContexts)
+	 *
+	 */
+	size_t getProcessingUnitsPerProcess()
+	{
+		return numPE;
+	}
+
+	/*! \brief Get the total number of processors
+	 *
+	 * It is the same as getProcessingUnits()
+	 *
+	 * \see getProcessingUnits()
+	 *
+	 * \return the total number of processors
+	 *
+	 */
+	size_t size()
+	{
+		return this->m_size*numPE;
+	}
+
+	/*! \brief Print the communication statistics
+	 *
+	 * Without VCLUSTER_PERF_REPORT the runtime counters are printed (see enableCounters)
+	 *
+	 */
+	void print_stats()
+	{
+#ifdef VCLUSTER_PERF_REPORT
+		std::cout << "-- REPORT COMMUNICATIONS -- " << std::endl;
+
+		std::cout << "Processor " << this->rank() << " sent: " << tot_sent << std::endl;
+		std::cout << "Processor " << this->rank() << " received: " << tot_recv << std::endl;
+
+		std::cout << "Processor " << this->rank() << " time spent: " << time_spent << std::endl;
+		std::cout << "Processor " << this->rank() << " Bandwidth: S:"  << (double)tot_sent / time_spent * 1e-9 << "GB/s  R:" << (double)tot_recv / time_spent * 1e-9 << "GB/s" <<  std::endl;
+#else
+
+		if (cnt.isActive() == false)
+		{
+			std::cout << "Error to activate performance stats on VCluster call enableCounters(true), set VCLUSTER_COUNTERS=1 or enable VCLUSTER_PERF_REPORT" << std::endl;
+			return;
+		}
+
+		Vcluster_stats st = cnt.get();
+
+		std::cout << "-- REPORT COMMUNICATIONS -- " << std::endl;
+
+		std::cout << "Processor " << this->rank() << " sent: " << st.bytes_sent << " bytes in " << st.msgs_sent << " messages" << std::endl;
+		std::cout << "Processor " << this->rank() << " received: " << st.bytes_recv << " bytes in " << st.msgs_recv << " messages" << std::endl;
+		std::cout << "Processor " << this->rank() << " NBX: " << st.nbx_rounds << " time spent: " << st.nbx_time << " barrier wait: " << st.barrier_wait << std::endl;
+		std::cout << "Processor " << this->rank() << " pack: " << st.pack_time << " unpack: " << st.unpack_time << std::endl;
+
+		if (st.nbx_time != 0.0)
+		{std::cout << "Processor " << this->rank() << " Bandwidth: S:"  << (double)st.bytes_sent / st.nbx_time * 1e-9 << "GB/s  R:" << (double)st.bytes_recv / st.nbx_time * 1e-9 << "GB/s" <<  std::endl;}
+
+#endif
+	}
+
+	//! Set the communication statistics to zero
+	void clear_stats()
+	{
+#ifdef VCLUSTER_PERF_REPORT
+
+		tot_sent = 0;
+		tot_recv = 0;
+
+		time_spent = 0;
+#else
+
+		cnt.reset();
+
+#endif
+	}
+
+	/*! \brief Start or stop the communication counters
+	 *
+	 * They are also activated setting the environment variable VCLUSTER_COUNTERS=1
+	 *
+	 * \param active true to start
+	 *
+	 */
+	void enableCounters(bool active)
+	{
+		cnt.enable(active);
+	}
+
+	/*! \brief Get the communication counters of this Vcluster
+	 *
+	 * \code
+	 * vcl.enableCounters(true);
+	 * // ... communications
+	 * Vcluster_stats st = vcl.getStats();
+	 * \endcode
+	 *
+	 * \return a snapshot of the counters (bytes, messages, NBX exchanges, and times in seconds)
+	 *
+	 */
+	Vcluster_stats getStats() const
+	{
+		return cnt.get();
+	}
+
+	/*! \brief Get the communication counters
+	 *
+	 * \return the counters
+	 *
+	 */
+	Vcluster_counters & getCounters()
+	{
+		return cnt;
+	}
+
+	/*! \brief Get the times of the last NBX with unknown processors
+	 *
+	 * \return the times (send completion, barrier wait, receive, total)
+	 *
+	 */
+	const Vcluster_nbx_timing & getLastNBXTiming() const
+	{
+		return nbx_last;
+	}
+
+	/*! \brief Get the times of the NBX with unknown processors accumulated since the last reset
+	 *
+	 * \return the times (send completion, barrier wait, receive, total)
+	 *
+	 */
+	const Vcluster_nbx_timing & getNBXTiming() const
+	{
+		return nbx_tot;
+	}
+
+	//! Reset the accumulated NBX times
+	void resetNBXTiming()
+	{
+		nbx_last.zero();
+		nbx_tot.zero();
+	}
+
+	/*! \brief Reduce the NBX times over all the processors to find the slowest ones
+	 *
+	 * \code
+	 * Vcluster_nbx_imbalance imb;
+	 * vcl.reduceNBXTiming(imb);
+	 *
+	 * if (vcl.rank() == 0 && imb.waitFraction() > 0.5)
+	 * {std::cout << "load imbalance, slowest processor " << imb.slowest() << std::endl;}
+	 * \endcode
+	 *
+	 * \warning it is collective
+	 *
+	 * \param imb maximum, minimum (with the processors) and average of every time
+	 * \param last true to reduce the times of the last NBX instead of the accumulated ones
+	 *
+	 */
+	void reduceNBXTiming(Vcluster_nbx_imbalance & imb, bool last = false)
+	{
+		const Vcluster_nbx_timing & tm = (last == true)?nbx_last:nbx_tot;
+
+		// the minimum is the maximum of the opposite, so one MAXLOC give both
+		struct
+		{
+			double val;
+			int rank;
+		} loc[2*VCL_NBX_N], glob[2*VCL_NBX_N];
+
+		double sum[VCL_NBX_N];
+
+		for (int i = 0 ; i < VCL_NBX_N ; i++)
+		{
+			loc[i].val = tm.t[i];
+			loc[i].rank = m_rank;
+			loc[VCL_NBX_N + i].val = -tm.t[i];
+			loc[VCL_NBX_N + i].rank = m_rank;
+		}
+
+		MPI_SAFE_CALL(MPI_Allreduce(loc,glob,2*VCL_NBX_N,MPI_DOUBLE_INT,MPI_MAXLOC,ext_comm));
+		MPI_SAFE_CALL(MPI_Allreduce(tm.t,sum,VCL_NBX_N,MPI_DOUBLE,MPI_SUM,ext_comm));
+
+		for (int i = 0 ; i < VCL_NBX_N ; i++)
+		{
+			imb.max[i] = glob[i].val;
+			imb.max_rank[i] = glob[i].rank;
+			imb.min[i] = -glob[VCL_NBX_N + i].val;
+			imb.min_rank[i] = glob[VCL_NBX_N + i].rank;
+			imb.avg[i] = sum[i] / m_size;
+		}
+	}
+
+	/*! \brief Set the parameters used by the MPI_COMPRESS option
+	 *
+	 * \param threshold messages smaller than threshold (in byte) are not compressed
+	 * \param stride size of the elements used for byte-shuffling (8 for double, 4 for float, 1 disable the shuffling)
+	 *
+	 */
+	void setCompressionParameters(size_t threshold, size_t stride = 8)
+	{
+		cmp.setParameters(threshold,stride);
+	}
+
+	/*! \brief Get the compression statistics of the last exchange and accumulated
+	 *
+	 * \return the statistics (raw and compressed bytes sent/received, compression/decompression time)
+	 *
+	 */
+	const Vcluster_compress_stats & getCompressionStats() const
+	{
+		return cmp.getStats();
+	}
+
+	//! Reset the compression statistics
+	void resetCompressionStats()
+	{
+		cmp.resetStats();
+	}
+
+	/*! \brief Get the process unit id
+	 *
+	 * With several processing units per process the processing units of the process m_rank are
+	 * numbered m_rank*numPE ... (m_rank+1)*numPE - 1
+	 *
+	 * \return the process ID (rank in MPI)
+	 *
+	 */
+	size_t getProcessUnitID()
+	{
+		return m_rank*numPE + pe;
+	}
+
+	/*! \brief Get the process unit id
+	 *
+	 * It is the same as getProcessUnitID()
+	 *
+	 * \see getProcessUnitID()
+	 *
+	 * \return the process ID
+	 *
+	 */
+	size_t rank()
+	{
+		return m_rank*numPE + pe;
+	}
+
+
+	/*! \brief Sum the numbers across all processors and get the result
+	 *
+	 * num can be a primitive, an array of primitives, an aggregate with all the properties of the same
+	 * primitive type, or an openfpm::vector of them. In the last cases the reduction is element-wise
+	 * and done with one collective
+	 *
+	 * \param num to reduce, input and output
+	 *
+	 */
+
+	template<typename T> void sum(T & num)
+	{
+		if (check_process_level("sum") == false)
+		{return;}
+
+#ifdef SE_CLASS1
+		checkType<typename MPI_reduce_decomp<T>::base_type>();
+#endif
+
+		// scalar reductions are fused at execute()
+		if (defer_reduction(num,MPI_SUM) == true)
+		{return;}
+
+		// reduce over MPI
+
+		// Create one request
+		req.add();
+
+		// reduce
+		MPI_IallreduceW<T>::reduce(num,MPI_SUM,req.last(), ext_comm);
+	}
+
+	/*! \brief Get the maximum number across all processors (or reduction with infinity norm)
+	 *
+	 * \see sum for the supported types (arrays and vectors are reduced element-wise)
+	 *
+	 * \param num to reduce
+	 *
+	 */
+	template<typename T> void max(T & num)
+	{
+		if (check_process_level("max") == false)
+		{return;}
+
+#ifdef SE_CLASS1
+		checkType<typename MPI_reduce_decomp<T>::base_type>();
+#endif
+		// scalar reductions are fused at execute()
+		if (defer_reduction(num,MPI_MAX) == true)
+		{return;}
+
+		// reduce over MPI
+
+		// Create one request
+		req.add();
+
+		// reduce
+		MPI_IallreduceW<T>::reduce(num,MPI_MAX,req.last(), ext_comm);
+	}
+
+	/*! \brief Get the minimum number across all processors (or reduction with insinity norm)
+	 *
+	 * \see sum for the supported types (arrays and vectors are reduced element-wise)
+	 *
+	 * \param num to reduce
+	 *
+	 */
+
+	template<typename T> void min(T & num)
+	{
+		if (check_process_level("min") == false)
+		{return;}
+
+#ifdef SE_CLASS1
+		checkType<typename MPI_reduce_decomp<T>::base_type>();
+#endif
+		// scalar reductions are fused at execute()
+		if (defer_reduction(num,MPI_MIN) == true)
+		{return;}
+
+		// reduce over MPI
+
+		// Create one request
+		req.add();
+
+		// reduce
+		MPI_IallreduceW<T>::reduce(num,MPI_MIN,req.last(), ext_comm);
+	}
+
+	/*! \brief Inclusive prefix sum across the processors
+	 *
+	 * On the processor i num become the sum of the num of the processors 0 ... i. It is
+	 * useful to compute offsets or global ids without gathering the counts of all the processors.
+	 * The types supported are the same of sum() (arrays and vectors are scanned element-wise)
+	 *
+	 * \warning operation is asynchronous execute must be called to get the result
+	 *
+	 * \param num to scan, input and output
+	 *
+	 */
+	template<typename T> void scan(T & num)
+	{
+		if (check_process_level("scan") == false)
+		{return;}
+
+#ifdef SE_CLASS1
+		checkType<typename MPI_reduce_decomp<T>::base_type>();
+#endif
+
+		// Create one request
+		req.add();
+
+		MPI_IscanW<T>::scan(num,MPI_SUM,false,req.last(),ext_comm);
+	}
+
+	/*! \brief Exclusive prefix sum across the processors
+	 *
+	 * On the processor i num become the sum of the num of the processors 0 ... i-1 (zero
+	 * on the processor 0)
+	 *
+	 * \code
+	 * size_t offset = n_local;
+	 * vcl.exscan(offset);
+	 * vcl.execute();
+	 * // global id of the local element k is offset + k
+	 * \endcode
+	 *
+	 * \see scan for the supported types
+	 *
+	 * \warning operation is asynchronous execute must be called to get the result
+	 *
+	 * \param num to scan, input and output
+	 *
+	 */
+	template<typename T> void exscan(T & num)
+	{
+		if (check_process_level("exscan") == false)
+		{return;}
+
+#ifdef SE_CLASS1
+		checkType<typename MPI_reduce_decomp<T>::base_type>();
+#endif
+
+		// Create one request
+		req.add();
+
+		MPI_IscanW<T>::scan(num,MPI_SUM,true,req.last(),ext_comm);
+
+		// MPI leave the result of the processor 0 undefined
+		if (m_rank == 0)
+		{
+			post_exe.push_back([&num]()
+			{
+				MPI_IscanW<T>::zero(num);
+			});
+		}
+	}
+
+	/*! \brief Sum the numbers across all processors with a reproducible result
+	 *
+	 * The result does not depend on the number of processors, on the decomposition or on the
+	 * order of the operations (the numbers are accumulated exactly in a fixed point accumulator
+	 * and rounded at the end). It cost one collective like sum()
+	 *
+	 * \warning operation is asynchronous execute must be called to get the result
+	 *
+	 * \param num to reduce (float or double), input and output
+	 *
+	 */
+	template<typename T> void sum_reproducible(T & num)
+	{
+		sum_reproducible(&num,1,num);
+	}
+
+	/*! \brief Sum the elements of the arrays across all processors with a reproducible result
+	 *
+	 * \see sum_reproducible
+	 *
+	 * \param v local array (float or double)
+	 * \param n number of elements
+	 * \param res sum of all the elements on all processors
+	 *
+	 */
+	template<typename T> void sum_reproducible(const T * v, size_t n, T & res)
+	{
+		static_assert(std::is_same<T,float>::value || std::is_same<T,double>::value,"sum_reproducible support only float and double");
+
+		if (check_process_level("sum_reproducible") == false)
+		{return;}
+
+		// the accumulator is owned by the post function, so it is released with its request group
+		std::shared_ptr<Vcluster_repro_acc> acc(new Vcluster_repro_acc);
+
+		acc->zero();
+		acc->add(v,n);
+
+		// Create one request
+		req.add();
+
+		MPI_IallreduceW_op<Vcluster_repro_acc,Vcluster_repro_acc>::reduce(*acc,req.last(),ext_comm);
+
+		// round when completed
+		T * ptr = &res;
+		post_exe.push_back([acc,ptr]()
+		{
+			*ptr = (T)acc->get();
+		});
+	}
+
+	/*! \brief Sum the elements of the vectors across all processors with a reproducible result
+	 *
+	 * \see sum_reproducible
+	 *
+	 * \param v local vector (of float or double)
+	 * \param res sum of all the elements on all processors
+	 *
+	 */
+	template<typename T, typename Mem, template<typename> class layout_base>
+	void sum_reproducible(openfpm::vector<T,Mem,layout_base> & v, T & res)
+	{
+		sum_reproducible(v.getPointer(),v.size(),res);
+	}
+
+	/*! \brief Reduce an object across all processors with a user defined operation
+	 *
+	 * It is useful for trivially copyable objects like aggregates or Point, when several quantities
+	 * must be reduced together (for example the minimum with its location or a bounding box).
+	 * The reduction is done with one collective
+	 *
+	 * \code
+	 * struct min_loc
+	 * {
+	 *   void operator()(const aggregate<double,size_t> & in, aggregate<double,size_t> & inout) const
+	 *   {
+	 *     if (in.template get<0>() < inout.template get<0>())
+	 *     {inout = in;}
+	 *   }
+	 * };
+	 *
+	 * vcl.reduce<min_loc>(ml);
+	 * vcl.execute();
+	 * \endcode
+	 *
+	 * \tparam Op functor (it must be associative and commutative) see MPI_IallreduceW_op
+	 *
+	 * \param num to reduce, input and output
+	 *
+	 */
+	template<typename Op, typename T> void reduce(T & num)
+	{
+		if (check_process_level("reduce") == false)
+		{return;}
+
+#ifdef SE_CLASS1
+		checkType<T>();
+#endif
+
+		// Create one request
+		req.add();
+
+		// reduce
+		MPI_IallreduceW_op<T,Op>::reduce(num,req.last(),ext_comm);
+	}
+
+	/*! \brief In case of Asynchonous communications like sendrecvMultipleMessagesNBXAsync this function
+	 * progress the communication
+	 *
+	 *
+	 */
+	void progressCommunication()
+	{
+		if (pe_grp != NULL)
+		{pe_receive();}
+
+		MPI_Status stat_t;
+		int stat = false;
+		MPI_SAFE_CALL(MPI_Iprobe(MPI_ANY_SOURCE,MPI_ANY_TAG, ext_comm,&stat,&stat_t));
+
+		// If I have an incoming message and is related to this NBX communication
+		if (stat == true)
+		{
+			unsigned int i = (stat_t.MPI_TAG - SEND_SPARSE) / 131072 - NBX_prc_cnt_base;
+
+			// a message of another communication (with several processing units it can come from a processing
+			// unit already in the next NBX, so the barrier must still be checked)
+			if (i >= NQUEUE || NBX_active[i] == NBX_Type::NBX_UNACTIVE || NBX_active[i] == NBX_Type::NBX_KNOWN  || NBX_active[i] == NBX_Type::NBX_KNOWN_PRC)
+			{test_sends();return;}
+
+			// processing unit that sent the message
+			size_t src = stat_t.MPI_SOURCE*numPE + ((stat_t.MPI_TAG - SEND_SPARSE) % 131072) % numPE;
+
+			double t_recv = MPI_Wtime();
+
+			int msize_;
+			long int msize;
+			bool big_data = true;
+
+			// Get the message tag and size
+
+			MPI_SAFE_CALL(MPI_Get_count(&stat_t,MPI_DOUBLE,&msize_));
+			if (msize_ == MPI_UNDEFINED)
+			{
+				big_data = false;
+				MPI_SAFE_CALL(MPI_Get_count(&stat_t,MPI_BYTE,&msize_));
+				msize = msize_;
+			}
+			else
+			{
+				msize = ((size_t)msize_) << 3;
+			}
+
+			// Ok we check if the TAG come from one of our send TAG
+			if (stat_t.MPI_TAG >= (int)(SEND_SPARSE + NBX_prc_cnt_base*131072) && stat_t.MPI_TAG < (int)(SEND_SPARSE + (NBX_prc_cnt_base + NBX_prc_qcnt + 1)*131072) && NBX_prc_compress[i] == true)
+			{
+				// The message is received in a temporal buffer and decoded directly in the user buffer
+				cmp_recv_buf.resize(msize);
+
+				if (big_data == true)
+				{MPI_SAFE_CALL(MPI_Recv(cmp_recv_buf.data(),msize >> 3,MPI_DOUBLE,stat_t.MPI_SOURCE,stat_t.MPI_TAG,ext_comm,&stat_t));}
+				else
+				{MPI_SAFE_CALL(MPI_Recv(cmp_recv_buf.data(),msize,MPI_BYTE,stat_t.MPI_SOURCE,stat_t.MPI_TAG,ext_comm,&stat_t));}
+
+				size_t raw_size = Vcluster_compress::raw_size(cmp_recv_buf.data());
+
+				void * ptr = this->NBX_prc_msg_alloc[i](raw_size,0,0,src,rid[i],stat_t.MPI_TAG,this->NBX_prc_ptr_arg[i]);
+
+				// Log the receiving request
+				log.logRecv(stat_t);
+
+				rid[i]++;
+
+				tot_recv += msize;
+				prof.recv(NBX_prc_api[i],src,msize);
+				cnt.recv(msize);
+
+				if (cmp.decode(cmp_recv_buf.data(),msize,ptr) == false)
+				{std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " corrupted compressed message from processor " << stat_t.MPI_SOURCE << std::endl;}
+
+#ifdef SE_CLASS2
+				check_valid(ptr,raw_size);
+#endif
+			}
+			else if (stat_t.MPI_TAG >= (int)(SEND_SPARSE + NBX_prc_cnt_base*131072) && stat_t.MPI_TAG < (int)(SEND_SPARSE + (NBX_prc_cnt_base + NBX_prc_qcnt + 1)*131072))
+			{
+				// Get the pointer to receive the message
+				void * ptr = this->NBX_prc_msg_alloc[i](msize,0,0,src,rid[i],stat_t.MPI_TAG,this->NBX_prc_ptr_arg[i]);
+
+				// Log the receiving request
+				log.logRecv(stat_t);
+
+				rid[i]++;
+
+				// Check the pointer
+#ifdef SE_CLASS2
+				check_valid(ptr,msize);
+#endif
+				tot_recv += msize;
+				prof.recv(NBX_prc_api[i],src,msize);
+				cnt.recv(msize);
+#ifdef VCLUSTER_GARBAGE_INJECTOR
+#if defined (__NVCC__) && !defined(CUDA_ON_CPU)
+					cudaPointerAttributes cpa;
+					auto error = cudaPointerGetAttributes(&cpa,ptr);
+					if (error == cudaSuccess)
+					{
+						if(cpa.type == cudaMemoryTypeDevice)
+						{cudaMemset(ptr,0xFF,msize);}
+						else
+						{memset(ptr,0xFF,msize);}
+					}
+#else
+					memset(ptr,0xFF,msize);
+#endif
+#endif
+				if (big_data == true)
+				{
+//					std::cout << "RECEVING BIG MESSAGE " << msize_ << "   "  << msize << std::endl;
+					MPI_SAFE_CALL(MPI_Recv(ptr,msize >> 3,MPI_DOUBLE,stat_t.MPI_SOURCE,stat_t.MPI_TAG,ext_comm,&stat_t));
+				}
+				else
+				{
+					MPI_SAFE_CALL(MPI_Recv(ptr,msize,MPI_BYTE,stat_t.MPI_SOURCE,stat_t.MPI_TAG,ext_comm,&stat_t));
+				}
+#ifdef SE_CLASS2
+				check_valid(ptr,msize);
+#endif
+			}
+
+			NBX_prc_trecv[i] += MPI_Wtime() - t_recv;
+		}
+
+		test_sends();
+	}
+
+	/*! \brief Send and receive multiple messages
+	 *
+	 * It send multiple messages to a set of processors the and receive
+	 * multiple messages from another set of processors, all the processor must call this
+	 * function. In this particular case the receiver know from which processor is going
+	 * to receive.
+	 *
+	 *
+	 * suppose the following situation the calling processor want to communicate
+	 * * 2 messages of size 100 byte to processor 1
+	 * * 1 message of size 50 byte to processor 6
+	 * * 1 message of size 48 byte to processor 7
+	 * * 1 message of size 70 byte to processor 8
+	 *
+	 *
+	 * \param prc list of processor with which it should communicate
+	 *        [1,1,6,7,8]
+	 *
+	 * \param data data to send for each processors in contain a pointer to some type T
+	 *        this type T must have a method size() that return the size of the data-structure
+	 *
+	 * \param prc_recv processor that receive data
+	 *
+	 * \param recv_sz for each processor indicate the size of the data received
+	 *
+	 * \param msg_alloc This is a call-back with the purpose of allocate space
+	 *        for the incoming message and give back a valid pointer, supposing that this call-back has been triggered by
+	 *        the processor of id 5 that want to communicate with me a message of size 100 byte the call-back will have
+	 *        the following 6 parameters
+	 *        in the call-back are in order:
+	 *        * message size required to receive the message [100]
+	 *        * total message size to receive from all the processors (NBX does not provide this information)
+	 *        * the total number of processor want to communicate with you (NBX does not provide this information)
+	 *        * processor id [5]
+	 *        * ri request id (it is an id that goes from 0 to total_p, and is incremented
+	 *           every time message_alloc is called)
+	 *        * void pointer, parameter for additional data to pass to the call-back
+	 *
+	 * \param ptr_arg data passed to the call-back function specified
+	 *
+	 * \param opt options, NONE (MPI_COMPRESS is not supported, the messages are received with the size given in the receive list)
+	 *
+	 */
+	template<typename T> void sendrecvMultipleMessagesNBX(
+		openfpm::vector< size_t > & prc,
+		openfpm::vector< T > & data,
+		openfpm::vector< size_t > & prc_recv,
+		openfpm::vector< size_t > & recv_sz ,
+		void * (* msg_alloc)(size_t,size_t,size_t,size_t,size_t,size_t,void *),
+		void * ptr_arg,
+		long int opt=NONE
+	) {
+		if (pe_grp != NULL)
+		{
+			ptr_send[NBX_prc_qcnt+1].resize(prc.size());
+			sz_send[NBX_prc_qcnt+1].resize(prc.size());
+
+			for (size_t i = 0 ; i < prc.size() ; i++)
+			{
+				ptr_send[NBX_prc_qcnt+1].get(i) = data.get(i).getPointer();
+				sz_send[NBX_prc_qcnt+1].get(i) = data.get(i).size();
+			}
+
+			pe_known_nbx(prc.size(),(size_t *)sz_send[NBX_prc_qcnt+1].getPointer(),(size_t *)prc.getPointer(),(void **)ptr_send[NBX_prc_qcnt+1].getPointer(),
+						 prc_recv.size(),(size_t *)prc_recv.getPointer(),(size_t *)recv_sz.getPointer(),NULL,msg_alloc,ptr_arg,false);
+			return;
+		}
+
+		vcl_prof_scope ps(prof_api,prof_cat(VCL_PROF_NBX_KNOWN));
+		vcl_trace_scope ts(trace,"nbx_known");
+		vcl_time_scope tc(cnt,VCL_TIME_NBX);
+		vcl_hist_scope hs(hist,prof_api);
+		cnt.nbx_round();
+
+#ifdef VCLUSTER_PERF_REPORT
+		timer nbx_timer;
+		nbx_timer.start();
+
+#endif
+
+		// Allocate the buffers
+
+		for (size_t i = 0 ; i < prc.size() ; i++)
+		{send(prc.get(i),SEND_SPARSE + NBX_cnt*131072,data.get(i).getPointer(),data.get(i).size());}
+
+		for (size_t i = 0 ; i < prc_recv.size() ; i++)
+		{
+			void * ptr_recv = msg_alloc(recv_sz.get(i),0,0,prc_recv.get(i),i,SEND_SPARSE + NBX_cnt*131072,ptr_arg);
+
+			recv(prc_recv.get(i),SEND_SPARSE + NBX_cnt*131072,ptr_recv,recv_sz.get(i));
+		}
+
+		execute();
+
+		// Circular counter
+		NBX_cnt = (NBX_cnt + 1) % nbx_cycle;
+
+#ifdef VCLUSTER_PERF_REPORT
+		nbx_timer.stop();
+		time_spent += nbx_timer.getwct();
+#endif
+	}
+
+	/*! \brief Send and receive multiple messages asynchronous version
+	 *
+	 * It send multiple messages to a set of processors the and receive
+	 * multiple messages from another set of processors, all the processor must call this
+	 * function. In this particular case the receiver know from which processor is going
+	 * to receive.
+	 *
+	 *
+	 * suppose the following situation the calling processor want to communicate
+	 * * 2 messages of size 100 byte to processor 1
+	 * * 1 message of size 50 byte to processor 6
+	 * * 1 message of size 48 byte to processor 7
+	 * * 1 message of size 70 byte to processor 8
+	 *
+	 *
+	 * \param prc list of processor with which it should communicate
+	 *        [1,1,6,7,8]
+	 *
+	 * \param data data to send for each processors in contain a pointer to some type T
+	 *        this type T must have a method size() that return the size of the data-structure
+	 *
+	 * \param prc_recv processor that receive data
+	 *
+	 * \param recv_sz for each processor indicate the size of the data received
+	 *
+	 * \param msg_alloc This is a call-back with the purpose of allocate space
+	 *        for the incoming message and give back a valid pointer, supposing that this call-back has been triggered by
+	 *        the processor of id 5 that want to communicate with me a message of size 100 byte the call-back will have
+	 *        the following 6 parameters
+	 *        in the call-back are in order:
+	 *        * message size required to receive the message [100]
+	 *        * total message size to receive from all the processors (NBX does not provide this information)
+	 *        * the total number of processor want to communicate with you (NBX does not provide this information)
+	 *        * processor id [5]
+	 *        * ri request id (it is an id that goes from 0 to total_p, and is incremented
+	 *           every time message_alloc is called)
+	 *        * void pointer, parameter for additional data to pass to the call-back
+	 *
+	 * \param ptr_arg data passed to the call-back function specified
+	 *
+	 * \param opt options, NONE (MPI_COMPRESS is not supported, the messages are received with the size given in the receive list)
+	 *
+	 */
+	template<typename T> void sendrecvMultipleMessagesNBXAsync(
+		openfpm::vector< size_t > & prc,
+		openfpm::vector< T > & data,
+		openfpm::vector< size_t > & prc_recv,
+		openfpm::vector< size_t > & recv_sz ,
+		void * (* msg_alloc)(size_t,size_t,size_t,size_t,size_t,size_t,void *),
+		void * ptr_arg,
+		long int opt=NONE
+	) {
+		if (pe_grp != NULL)
+		{
+			ptr_send[NBX_prc_qcnt+1].resize(prc.size());
+			sz_send[NBX_prc_qcnt+1].resize(prc.size());
+
+			for (size_t i = 0 ; i < prc.size() ; i++)
+			{
+				ptr_send[NBX_prc_qcnt+1].get(i) = data.get(i).getPointer();
+				sz_send[NBX_prc_qcnt+1].get(i) = data.get(i).size();
+			}
+
+			pe_known_nbx(prc.size(),(size_t *)sz_send[NBX_prc_qcnt+1].getPointer(),(size_t *)prc.getPointer(),(void **)ptr_send[NBX_prc_qcnt+1].getPointer(),
+						 prc_recv.size(),(size_t *)prc_recv.getPointer(),(size_t *)recv_sz.getPointer(),NULL,msg_alloc,ptr_arg,true);
+			return;
+		}
+
+		vcl_prof_scope ps(prof_api,prof_cat(VCL_PROF_NBX_KNOWN));
+		vcl_trace_scope ts(trace,"nbx_known");
+		cnt.nbx_round();
+
+		NBX_prc_qcnt++;
+		if (NBX_prc_qcnt >= NQUEUE)
+		{
+			std::cout << __FILE__ << ":" << __LINE__ << " error you can queue at most " << NQUEUE << " asychronous communication functions " << std::endl;
+			return;
+		}
+
+		// Allocate the buffers
+
+		for (size_t i = 0 ; i < prc.size() ; i++)
+		{send(prc.get(i),SEND_SPARSE + NBX_cnt*131072,data.get(i).getPointer(),data.get(i).size());}
+
+		for (size_t i = 0 ; i < prc_recv.size() ; i++)
+		{
+			void * ptr_recv = msg_alloc(recv_sz.get(i),0,0,prc_recv.get(i),i,SEND_SPARSE + NBX_cnt*131072,ptr_arg);
+
+			recv(prc_recv.get(i),SEND_SPARSE + NBX_cnt*131072,ptr_recv,recv_sz.get(i));
+		}
+
+		NBX_active[NBX_prc_qcnt] = NBX_Type::NBX_KNOWN;
+		NBX_prc_api[NBX_prc_qcnt] = prof_api;
+		NBX_prc_t0[NBX_prc_qcnt] = hist.begin();
+		if (NBX_prc_qcnt == 0)
+		{NBX_prc_cnt_base = NBX_cnt;}
+	}
+
+	/*! \brief Send and receive multiple messages
+	 *
+	 * It send multiple messages to a set of processors the and receive
+	 * multiple messages from another set of processors, all the processor must call this
+	 * function
+	 *
+	 * suppose the following situation the calling processor want to communicate
+	 * * 2 vector of 100 integers to processor 1
+	 * * 1 vector of 50 integers to processor 6
+	 * * 1 vector of 48 integers to processor 7
+	 * * 1 vector of 70 integers to processor 8
+	 *
+	 * \param prc list of processors you should communicate with [1,1,6,7,8]
+	 *
+	 * \param data vector containing the data to send [v=vector<vector<int>>, v.size()=4, T=vector<int>], T at the moment
+	 *          is only tested for vectors of 0 or more generic elements (without pointers)
+	 *
+	 * \param msg_alloc This is a call-back with the purpose to allocate space
+	 *        for the incoming messages and give back a valid pointer, supposing that this call-back has been triggered by
+	 *        the processor of id 5 that want to communicate with me a message of size 100 byte the call-back will have
+	 *        the following 6 parameters
+	 *        in the call-back in order:
+	 *        * message size required to receive the message (100)
+	 *        * total message size to receive from all the processors (NBX does not provide this information)
+	 *        * the total number of processor want to communicate with you (NBX does not provide this information)
+	 *        * processor id (5)
+	 *        * ri request id (it is an id that goes from 0 to total_p, and is incremented
+	 *           every time message_alloc is called)
+	 *        * void pointer, parameter for additional data to pass to the call-back
+	 *
+	 * \param ptr_arg data passed to the call-back function specified
+	 *
+	 * \param opt options, NONE or MPI_COMPRESS
+	 *
+	 */
+	template<typename T>
+	void sendrecvMultipleMessagesNBX(
+		openfpm::vector< size_t > & prc,
+		openfpm::vector< T > & data,
+		void * (* msg_alloc)(size_t,size_t,size_t,size_t,size_t,size_t,void *),
+		void * ptr_arg, long int opt=NONE)
+	{
+#ifdef SE_CLASS1
+		checkType<typename T::value_type>();
+#endif
+
+		// resize the pointer list
+		ptr_send[NBX_prc_qcnt+1].resize(prc.size());
+		sz_send[NBX_prc_qcnt+1].resize(prc.size());
+
+		for (size_t i = 0 ; i < prc.size() ; i++)
+		{
+			ptr_send[NBX_prc_qcnt+1].get(i) = data.get(i).getPointer();
+			sz_send[NBX_prc_qcnt+1].get(i) = data.get(i).size() * sizeof(typename T::value_type);
+		}
+
+		sendrecvMultipleMessagesNBX(prc.size(),(size_t *)sz_send[NBX_prc_qcnt+1].getPointer(),(size_t *)prc.getPointer(),(void **)ptr_send[NBX_prc_qcnt+1].getPointer(),msg_alloc,ptr_arg,opt);
+	}
+
+	/*! \brief Send and receive multiple messages asynchronous version
+	 *
+	 * This is the Asynchronous version of Send and receive NBX. This call return immediately, use
+	 * sendrecvMultipleMessagesNBXWait to synchronize. Optionally you can use the function progress_communication
+	 * to move on the communication
+	 *
+	 * It send multiple messages to a set of processors the and receive
+	 * multiple messages from another set of processors, all the processor must call this
+	 * function
+	 *
+	 * suppose the following situation the calling processor want to communicate
+	 * * 2 vector of 100 integers to processor 1
+	 * * 1 vector of 50 integers to processor 6
+	 * * 1 vector of 48 integers to processor 7
+	 * * 1 vector of 70 integers to processor 8
+	 *
+	 * \param prc list of processors you should communicate with [1,1,6,7,8]
+	 *
+	 * \param data vector containing the data to send [v=vector<vector<int>>, v.size()=4, T=vector<int>], T at the moment
+	 *          is only tested for vectors of 0 or more generic elements (without pointers)
+	 *
+	 * \param msg_alloc This is a call-back with the purpose to allocate space
+	 *        for the incoming messages and give back a valid pointer, supposing that this call-back has been triggered by
+	 *        the processor of id 5 that want to communicate with me a message of size 100 byte the call-back will have
+	 *        the following 6 parameters
+	 *        in the call-back in order:
+	 *        * message size required to receive the message (100)
+	 *        * total message size to receive from all the processors (NBX does not provide this information)
+	 *        * the total number of processor want to communicate with you (NBX does not provide this information)
+	 *        * processor id (5)
+	 *        * ri request id (it is an id that goes from 0 to total_p, and is incremented
+	 *           every time message_alloc is called)
+	 *        * void pointer, parameter for additional data to pass to the call-back
+	 *
+	 * \param ptr_arg data passed to the call-back function specified
+	 *
+	 * \param opt options, NONE or MPI_COMPRESS
+	 *
+	 */
+	template<typename T>
+	void sendrecvMultipleMessagesNBXAsync(openfpm::vector< size_t > & prc,
+									 openfpm::vector< T > & data,
+									 void * (* msg_alloc)(size_t,size_t,size_t,size_t,size_t,size_t,void *),
+									 void * ptr_arg, long int opt=NONE)
+	{
+#ifdef SE_CLASS1
+		checkType<typename T::value_type>();
 #endif
-				if (big_data == true)
-				{
-//					std::cout << "RECEVING BIG MESSAGE " << msize_ << "   "  << msize << std::endl;
-					MPI_SAFE_CALL(MPI_Recv(ptr,msize >> 3,MPI_DOUBLE,stat_t.MPI_SOURCE,stat_t.MPI_TAG,ext_comm,&stat_t));
-				}
-				else
-				{
-					MPI_SAFE_CALL(MPI_Recv(ptr,msize,MPI_BYTE,stat_t.MPI_SOURCE,stat_t.MPI_TAG,ext_comm,&stat_t));
-				}
-#ifdef SE_CLASS2
-				check_valid(ptr,msize);
-#endif
-			}
-		}
-
-		// Check the status of all the MPI_issend and call the barrier if finished
+		// resize the pointer list
+		ptr_send[NBX_prc_qcnt+1].resize(prc.size());
+		sz_send[NBX_prc_qcnt+1].resize(prc.size());
 
-		for (unsigned int i = 0 ; i < NQUEUE ; i++)
+		for (size_t i = 0 ; i < prc.size() ; i++)
 		{
-			if (i >= NQUEUE || NBX_active[i] == NBX_Type::NBX_UNACTIVE || NBX_active[i] == NBX_Type::NBX_KNOWN || NBX_active[i] == NBX_Type::NBX_KNOWN_PRC)
-			{continue;}
-
-			if (NBX_prc_reached_bar_req[i] == false)
-			{
-				int flag = false;
-				if (req.size() != 0)
-				{MPI_SAFE_CALL(MPI_Testall(req.size(),&req.get(0),&flag,MPI_STATUSES_IGNORE));}
-				else
-				{flag = true;}
-
-				// If all send has been completed
-				if (flag == true)
-				{MPI_SAFE_CALL(MPI_Ibarrier(ext_comm,&bar_req));NBX_prc_reached_bar_req[i] = true;}
-			}
+			ptr_send[NBX_prc_qcnt+1].get(i) = data.get(i).getPointer();
+			sz_send[NBX_prc_qcnt+1].get(i) = data.get(i).size() * sizeof(typename T::value_type);
 		}
+
+		sendrecvMultipleMessagesNBXAsync(prc.size(),(size_t *)sz_send[NBX_prc_qcnt+1].getPointer(),(size_t *)prc.getPointer(),(void **)ptr_send[NBX_prc_qcnt+1].getPointer(),msg_alloc,ptr_arg,opt);
 	}
 
 	/*! \brief Send and receive multiple messages
@@ -746,6 +2325,7 @@ public:
 	 * function. In this particular case the receiver know from which processor is going
 	 * to receive.
 	 *
+	 * \warning this function only work with one send for each processor
 	 *
 	 * suppose the following situation the calling processor want to communicate
 	 * * 2 messages of size 100 byte to processor 1
@@ -753,16 +2333,15 @@ public:
 	 * * 1 message of size 48 byte to processor 7
 	 * * 1 message of size 70 byte to processor 8
 	 *
+	 * \param n_send number of send for this processor [4]
 	 *
 	 * \param prc list of processor with which it should communicate
 	 *        [1,1,6,7,8]
 	 *
-	 * \param data data to send for each processors in contain a pointer to some type T
-	 *        this type T must have a method size() that return the size of the data-structure
-	 *
-	 * \param prc_recv processor that receive data
+	 * \param sz the array contain the size of the message for each processor
+	 *        (zeros must not be presents) [100,100,50,48,70]
 	 *
-	 * \param recv_sz for each processor indicate the size of the data received
+	 * \param ptr array that contain the pointers to the message to send
 	 *
 	 * \param msg_alloc This is a call-back with the purpose of allocate space
 	 *        for the incoming message and give back a valid pointer, supposing that this call-back has been triggered by
@@ -779,18 +2358,27 @@ public:
 	 *
 	 * \param ptr_arg data passed to the call-back function specified
 	 *
-	 * \param opt options, NONE (ignored in this moment)
+	 * \param opt options, NONE (MPI_COMPRESS is not supported, the messages are received with the size given in the receive list)
 	 *
 	 */
-	template<typename T> void sendrecvMultipleMessagesNBX(
-		openfpm::vector< size_t > & prc,
-		openfpm::vector< T > & data,
-		openfpm::vector< size_t > & prc_recv,
-		openfpm::vector< size_t > & recv_sz ,
-		void * (* msg_alloc)(size_t,size_t,size_t,size_t,size_t,size_t,void *),
-		void * ptr_arg,
-		long int opt=NONE
-	) {
+	void sendrecvMultipleMessagesNBX(size_t n_send , size_t sz[],
+									 size_t prc[] , void * ptr[],
+									 size_t n_recv, size_t prc_recv[] ,
+									 size_t sz_recv[] ,void * (* msg_alloc)(size_t,size_t,size_t,size_t,size_t, size_t,void *),
+									 void * ptr_arg, long int opt=NONE)
+	{
+		if (pe_grp != NULL)
+		{
+			pe_known_nbx(n_send,sz,prc,ptr,n_recv,prc_recv,sz_recv,NULL,msg_alloc,ptr_arg,false);
+			return;
+		}
+
+		vcl_prof_scope ps(prof_api,prof_cat(VCL_PROF_NBX_KNOWN));
+		vcl_trace_scope ts(trace,"nbx_known");
+		vcl_time_scope tc(cnt,VCL_TIME_NBX);
+		vcl_hist_scope hs(hist,prof_api);
+		cnt.nbx_round();
+
 #ifdef VCLUSTER_PERF_REPORT
 		timer nbx_timer;
 		nbx_timer.start();
@@ -799,14 +2387,14 @@ public:
 
 		// Allocate the buffers
 
-		for (size_t i = 0 ; i < prc.size() ; i++)
-		{send(prc.get(i),SEND_SPARSE + NBX_cnt*131072,data.get(i).getPointer(),data.get(i).size());}
+		for (size_t i = 0 ; i < n_send ; i++)
+		{send(prc[i],SEND_SPARSE + NBX_cnt*131072,ptr[i],sz[i]);}
 
-		for (size_t i = 0 ; i < prc_recv.size() ; i++)
+		for (size_t i = 0 ; i < n_recv ; i++)
 		{
-			void * ptr_recv = msg_alloc(recv_sz.get(i),0,0,prc_recv.get(i),i,SEND_SPARSE + NBX_cnt*131072,ptr_arg);
+			void * ptr_recv = msg_alloc(sz_recv[i],0,0,prc_recv[i],i,SEND_SPARSE + NBX_cnt*131072,ptr_arg);
 
-			recv(prc_recv.get(i),SEND_SPARSE + NBX_cnt*131072,ptr_recv,recv_sz.get(i));
+			recv(prc_recv[i],SEND_SPARSE + NBX_cnt*131072,ptr_recv,sz_recv[i]);
 		}
 
 		execute();
@@ -827,6 +2415,7 @@ public:
 	 * function. In this particular case the receiver know from which processor is going
 	 * to receive.
 	 *
+	 * \warning this function only work with one send for each processor
 	 *
 	 * suppose the following situation the calling processor want to communicate
 	 * * 2 messages of size 100 byte to processor 1
@@ -834,16 +2423,15 @@ public:
 	 * * 1 message of size 48 byte to processor 7
 	 * * 1 message of size 70 byte to processor 8
 	 *
+	 * \param n_send number of send for this processor [4]
 	 *
 	 * \param prc list of processor with which it should communicate
 	 *        [1,1,6,7,8]
 	 *
-	 * \param data data to send for each processors in contain a pointer to some type T
-	 *        this type T must have a method size() that return the size of the data-structure
-	 *
-	 * \param prc_recv processor that receive data
+	 * \param sz the array contain the size of the message for each processor
+	 *        (zeros must not be presents) [100,100,50,48,70]
 	 *
-	 * \param recv_sz for each processor indicate the size of the data received
+	 * \param ptr array that contain the pointers to the message to send
 	 *
 	 * \param msg_alloc This is a call-back with the purpose of allocate space
 	 *        for the incoming message and give back a valid pointer, supposing that this call-back has been triggered by
@@ -860,18 +2448,25 @@ public:
 	 *
 	 * \param ptr_arg data passed to the call-back function specified
 	 *
-	 * \param opt options, NONE (ignored in this moment)
+	 * \param opt options, NONE (MPI_COMPRESS is not supported, the messages are received with the size given in the receive list)
 	 *
 	 */
-	template<typename T> void sendrecvMultipleMessagesNBXAsync(
-		openfpm::vector< size_t > & prc,
-		openfpm::vector< T > & data,
-		openfpm::vector< size_t > & prc_recv,
-		openfpm::vector< size_t > & recv_sz ,
-		void * (* msg_alloc)(size_t,size_t,size_t,size_t,size_t,size_t,void *),
-		void * ptr_arg,
-		long int opt=NONE
-	) {
+	void sendrecvMultipleMessagesNBXAsync(size_t n_send , size_t sz[],
+									 size_t prc[] , void * ptr[],
+									 size_t n_recv, size_t prc_recv[] ,
+									 size_t sz_recv[] ,void * (* msg_alloc)(size_t,size_t,size_t,size_t,size_t, size_t,void *),
+									 void * ptr_arg, long int opt=NONE)
+	{
+		if (pe_grp != NULL)
+		{
+			pe_known_nbx(n_send,sz,prc,ptr,n_recv,prc_recv,sz_recv,NULL,msg_alloc,ptr_arg,true);
+			return;
+		}
+
+		vcl_prof_scope ps(prof_api,prof_cat(VCL_PROF_NBX_KNOWN));
+		vcl_trace_scope ts(trace,"nbx_known");
+		cnt.nbx_round();
+
 		NBX_prc_qcnt++;
 		if (NBX_prc_qcnt >= NQUEUE)
 		{
@@ -881,149 +2476,226 @@ public:
 
 		// Allocate the buffers
 
-		for (size_t i = 0 ; i < prc.size() ; i++)
-		{send(prc.get(i),SEND_SPARSE + NBX_cnt*131072,data.get(i).getPointer(),data.get(i).size());}
+		for (size_t i = 0 ; i < n_send ; i++)
+		{send(prc[i],SEND_SPARSE + NBX_cnt*131072,ptr[i],sz[i]);}
 
-		for (size_t i = 0 ; i < prc_recv.size() ; i++)
+		for (size_t i = 0 ; i < n_recv ; i++)
 		{
-			void * ptr_recv = msg_alloc(recv_sz.get(i),0,0,prc_recv.get(i),i,SEND_SPARSE + NBX_cnt*131072,ptr_arg);
+			void * ptr_recv = msg_alloc(sz_recv[i],0,0,prc_recv[i],i,SEND_SPARSE + NBX_cnt*131072,ptr_arg);
 
-			recv(prc_recv.get(i),SEND_SPARSE + NBX_cnt*131072,ptr_recv,recv_sz.get(i));
+			recv(prc_recv[i],SEND_SPARSE + NBX_cnt*131072,ptr_recv,sz_recv[i]);
 		}
 
 		NBX_active[NBX_prc_qcnt] = NBX_Type::NBX_KNOWN;
+		NBX_prc_api[NBX_prc_qcnt] = prof_api;
+		NBX_prc_t0[NBX_prc_qcnt] = hist.begin();
 		if (NBX_prc_qcnt == 0)
 		{NBX_prc_cnt_base = NBX_cnt;}
 	}
 
+	openfpm::vector<size_t> sz_recv_tmp;
+
 	/*! \brief Send and receive multiple messages
 	 *
 	 * It send multiple messages to a set of processors the and receive
 	 * multiple messages from another set of processors, all the processor must call this
-	 * function
+	 * function. In this particular case the receiver know from which processor is going
+	 * to receive, but does not know the size.
+	 *
 	 *
 	 * suppose the following situation the calling processor want to communicate
-	 * * 2 vector of 100 integers to processor 1
-	 * * 1 vector of 50 integers to processor 6
-	 * * 1 vector of 48 integers to processor 7
-	 * * 1 vector of 70 integers to processor 8
+	 * * 2 messages of size 100 byte to processor 1
+	 * * 1 message of size 50 byte to processor 6
+	 * * 1 message of size 48 byte to processor 7
+	 * * 1 message of size 70 byte to processor 8
 	 *
-	 * \param prc list of processors you should communicate with [1,1,6,7,8]
+	 * \param n_send number of send for this processor [4]
 	 *
-	 * \param data vector containing the data to send [v=vector<vector<int>>, v.size()=4, T=vector<int>], T at the moment
-	 *          is only tested for vectors of 0 or more generic elements (without pointers)
+	 * \param prc list of processor with which it should communicate
+	 *        [1,1,6,7,8]
 	 *
-	 * \param msg_alloc This is a call-back with the purpose to allocate space
-	 *        for the incoming messages and give back a valid pointer, supposing that this call-back has been triggered by
+	 * \param sz the array contain the size of the message for each processor
+	 *        (zeros must not be presents) [100,100,50,48,70]
+	 *
+	 * \param ptr array that contain the pointers to the message to send
+	 *
+	 * \param msg_alloc This is a call-back with the purpose of allocate space
+	 *        for the incoming message and give back a valid pointer, supposing that this call-back has been triggered by
 	 *        the processor of id 5 that want to communicate with me a message of size 100 byte the call-back will have
 	 *        the following 6 parameters
-	 *        in the call-back in order:
-	 *        * message size required to receive the message (100)
+	 *        in the call-back are in order:
+	 *        * message size required to receive the message [100]
 	 *        * total message size to receive from all the processors (NBX does not provide this information)
 	 *        * the total number of processor want to communicate with you (NBX does not provide this information)
-	 *        * processor id (5)
+	 *        * processor id [5]
 	 *        * ri request id (it is an id that goes from 0 to total_p, and is incremented
 	 *           every time message_alloc is called)
 	 *        * void pointer, parameter for additional data to pass to the call-back
 	 *
 	 * \param ptr_arg data passed to the call-back function specified
 	 *
-	 * \param opt options, only NONE supported
+	 * \param opt options, NONE (MPI_COMPRESS is not supported, the messages are sent uncompressed)
 	 *
 	 */
-	template<typename T>
-	void sendrecvMultipleMessagesNBX(
-		openfpm::vector< size_t > & prc,
-		openfpm::vector< T > & data,
-		void * (* msg_alloc)(size_t,size_t,size_t,size_t,size_t,size_t,void *),
-		void * ptr_arg, long int opt=NONE)
+	void sendrecvMultipleMessagesNBX(size_t n_send , size_t sz[], size_t prc[] ,
+									 void * ptr[], size_t n_recv, size_t prc_recv[] ,
+									 void * (* msg_alloc)(size_t,size_t,size_t,size_t,size_t,size_t,void *),
+									 void * ptr_arg, long int opt=NONE)
 	{
-#ifdef SE_CLASS1
-		checkType<typename T::value_type>();
+		if (pe_grp != NULL)
+		{
+			sz_recv_tmp.resize(n_recv);
+			pe_known_nbx(n_send,sz,prc,ptr,n_recv,prc_recv,NULL,(size_t *)sz_recv_tmp.getPointer(),msg_alloc,ptr_arg,false);
+			return;
+		}
+
+		vcl_prof_scope ps(prof_api,prof_cat(VCL_PROF_NBX_KNOWN_PRC));
+		vcl_trace_scope ts(trace,"nbx_known_prc");
+		vcl_time_scope tc(cnt,VCL_TIME_NBX);
+		vcl_hist_scope hs(hist,prof_api);
+		cnt.nbx_round();
+
+#ifdef VCLUSTER_PERF_REPORT
+		timer nbx_timer;
+		nbx_timer.start();
 #endif
 
-		// resize the pointer list
-		ptr_send[NBX_prc_qcnt+1].resize(prc.size());
-		sz_send[NBX_prc_qcnt+1].resize(prc.size());
+		sz_recv_tmp.resize(n_recv);
 
-		for (size_t i = 0 ; i < prc.size() ; i++)
+		// First we understand the receive size for each processor
+
+		for (size_t i = 0 ; i < n_send ; i++)
+		{send(prc[i],SEND_SPARSE + NBX_cnt*131072,&sz[i],sizeof(size_t));}
+
+		for (size_t i = 0 ; i < n_recv ; i++)
+		{recv(prc_recv[i],SEND_SPARSE + NBX_cnt*131072,&sz_recv_tmp.get(i),sizeof(size_t));}
+
+		execute();
+
+		// Circular counter
+		NBX_cnt = (NBX_cnt + 1) % nbx_cycle;
+
+		// Allocate the buffers
+
+		for (size_t i = 0 ; i < n_send ; i++)
+		{send(prc[i],SEND_SPARSE + NBX_cnt*131072,ptr[i],sz[i]);}
+
+		for (size_t i = 0 ; i < n_recv ; i++)
 		{
-			ptr_send[NBX_prc_qcnt+1].get(i) = data.get(i).getPointer();
-			sz_send[NBX_prc_qcnt+1].get(i) = data.get(i).size() * sizeof(typename T::value_type);
+			void * ptr_recv = msg_alloc(sz_recv_tmp.get(i),0,0,prc_recv[i],i,0,ptr_arg);
+
+			recv(prc_recv[i],SEND_SPARSE + NBX_cnt*131072,ptr_recv,sz_recv_tmp.get(i));
 		}
 
-		sendrecvMultipleMessagesNBX(prc.size(),(size_t *)sz_send[NBX_prc_qcnt+1].getPointer(),(size_t *)prc.getPointer(),(void **)ptr_send[NBX_prc_qcnt+1].getPointer(),msg_alloc,ptr_arg,opt);
+		execute();
+
+		// Circular counter
+		NBX_cnt = (NBX_cnt + 1) % nbx_cycle;
+
+#ifdef VCLUSTER_PERF_REPORT
+		nbx_timer.stop();
+		time_spent += nbx_timer.getwct();
+#endif
 	}
 
 	/*! \brief Send and receive multiple messages asynchronous version
-	 *
-	 * This is the Asynchronous version of Send and receive NBX. This call return immediately, use
-	 * sendrecvMultipleMessagesNBXWait to synchronize. Optionally you can use the function progress_communication
-	 * to move on the communication
 	 *
 	 * It send multiple messages to a set of processors the and receive
 	 * multiple messages from another set of processors, all the processor must call this
-	 * function
+	 * function. In this particular case the receiver know from which processor is going
+	 * to receive, but does not know the size.
+	 *
 	 *
 	 * suppose the following situation the calling processor want to communicate
-	 * * 2 vector of 100 integers to processor 1
-	 * * 1 vector of 50 integers to processor 6
-	 * * 1 vector of 48 integers to processor 7
-	 * * 1 vector of 70 integers to processor 8
+	 * * 2 messages of size 100 byte to processor 1
+	 * * 1 message of size 50 byte to processor 6
+	 * * 1 message of size 48 byte to processor 7
+	 * * 1 message of size 70 byte to processor 8
 	 *
-	 * \param prc list of processors you should communicate with [1,1,6,7,8]
+	 * \param n_send number of send for this processor [4]
 	 *
-	 * \param data vector containing the data to send [v=vector<vector<int>>, v.size()=4, T=vector<int>], T at the moment
-	 *          is only tested for vectors of 0 or more generic elements (without pointers)
+	 * \param prc list of processor with which it should communicate
+	 *        [1,1,6,7,8]
 	 *
-	 * \param msg_alloc This is a call-back with the purpose to allocate space
-	 *        for the incoming messages and give back a valid pointer, supposing that this call-back has been triggered by
+	 * \param sz the array contain the size of the message for each processor
+	 *        (zeros must not be presents) [100,100,50,48,70]
+	 *
+	 * \param ptr array that contain the pointers to the message to send
+	 *
+	 * \param msg_alloc This is a call-back with the purpose of allocate space
+	 *        for the incoming message and give back a valid pointer, supposing that this call-back has been triggered by
 	 *        the processor of id 5 that want to communicate with me a message of size 100 byte the call-back will have
 	 *        the following 6 parameters
-	 *        in the call-back in order:
-	 *        * message size required to receive the message (100)
+	 *        in the call-back are in order:
+	 *        * message size required to receive the message [100]
 	 *        * total message size to receive from all the processors (NBX does not provide this information)
 	 *        * the total number of processor want to communicate with you (NBX does not provide this information)
-	 *        * processor id (5)
+	 *        * processor id [5]
 	 *        * ri request id (it is an id that goes from 0 to total_p, and is incremented
 	 *           every time message_alloc is called)
 	 *        * void pointer, parameter for additional data to pass to the call-back
 	 *
 	 * \param ptr_arg data passed to the call-back function specified
 	 *
-	 * \param opt options, only NONE supported
+	 * \param opt options, NONE (MPI_COMPRESS is not supported, the messages are sent uncompressed)
 	 *
 	 */
-	template<typename T>
-	void sendrecvMultipleMessagesNBXAsync(openfpm::vector< size_t > & prc,
-									 openfpm::vector< T > & data,
+	void sendrecvMultipleMessagesNBXAsync(size_t n_send , size_t sz[], size_t prc[] ,
+									 void * ptr[], size_t n_recv, size_t prc_recv[] ,
 									 void * (* msg_alloc)(size_t,size_t,size_t,size_t,size_t,size_t,void *),
 									 void * ptr_arg, long int opt=NONE)
 	{
-#ifdef SE_CLASS1
-		checkType<typename T::value_type>();
-#endif
-		// resize the pointer list
-		ptr_send[NBX_prc_qcnt+1].resize(prc.size());
-		sz_send[NBX_prc_qcnt+1].resize(prc.size());
+		if (pe_grp != NULL)
+		{
+			sz_recv_tmp.resize(n_recv);
+			pe_known_nbx(n_send,sz,prc,ptr,n_recv,prc_recv,NULL,(size_t *)sz_recv_tmp.getPointer(),msg_alloc,ptr_arg,true);
+			return;
+		}
 
-		for (size_t i = 0 ; i < prc.size() ; i++)
+		vcl_prof_scope ps(prof_api,prof_cat(VCL_PROF_NBX_KNOWN_PRC));
+		vcl_trace_scope ts(trace,"nbx_known_prc");
+		cnt.nbx_round();
+
+		NBX_prc_qcnt++;
+		if (NBX_prc_qcnt >= NQUEUE)
 		{
-			ptr_send[NBX_prc_qcnt+1].get(i) = data.get(i).getPointer();
-			sz_send[NBX_prc_qcnt+1].get(i) = data.get(i).size() * sizeof(typename T::value_type);
+			std::cout << __FILE__ << ":" << __LINE__ << " error you can queue at most " << NQUEUE << " asychronous communication functions " << std::endl;
+			return;
 		}
 
-		sendrecvMultipleMessagesNBXAsync(prc.size(),(size_t *)sz_send[NBX_prc_qcnt+1].getPointer(),(size_t *)prc.getPointer(),(void **)ptr_send[NBX_prc_qcnt+1].getPointer(),msg_alloc,ptr_arg,opt);
+		sz_recv_tmp.resize(n_recv);
+
+		// First we understand the receive size for each processor
+
+		for (size_t i = 0 ; i < n_send ; i++)
+		{send(prc[i],SEND_SPARSE + NBX_cnt*131072,&sz[i],sizeof(size_t));}
+
+		for (size_t i = 0 ; i < n_recv ; i++)
+		{recv(prc_recv[i],SEND_SPARSE + NBX_cnt*131072,&sz_recv_tmp.get(i),sizeof(size_t));}
+
+		////// Save all the status variables
+
+		NBX_prc_n_send[NBX_prc_qcnt] = n_send;
+		NBX_prc_prc[NBX_prc_qcnt] = prc;
+		NBX_prc_ptr[NBX_prc_qcnt] = ptr;
+		NBX_prc_sz[NBX_prc_qcnt] = sz;
+		NBX_prc_n_recv[NBX_prc_qcnt] = n_recv;
+		NBX_prc_prc_recv[NBX_prc_qcnt] = prc_recv;
+		NBX_prc_msg_alloc[NBX_prc_qcnt] = msg_alloc;
+		NBX_prc_ptr_arg[NBX_prc_qcnt] = ptr_arg;
+
+		NBX_active[NBX_prc_qcnt] = NBX_Type::NBX_KNOWN_PRC;
+		NBX_prc_api[NBX_prc_qcnt] = prof_api;
+		NBX_prc_t0[NBX_prc_qcnt] = hist.begin();
+		if (NBX_prc_qcnt == 0)
+		{NBX_prc_cnt_base = NBX_cnt;}
 	}
 
 	/*! \brief Send and receive multiple messages
 	 *
 	 * It send multiple messages to a set of processors the and receive
 	 * multiple messages from another set of processors, all the processor must call this
-	 * function. In this particular case the receiver know from which processor is going
-	 * to receive.
-	 *
-	 * \warning this function only work with one send for each processor
+	 * function
 	 *
 	 * suppose the following situation the calling processor want to communicate
 	 * * 2 messages of size 100 byte to processor 1
@@ -1056,14 +2728,13 @@ public:
 	 *
 	 * \param ptr_arg data passed to the call-back function specified
 	 *
-	 * \param opt options, NONE (ignored in this moment)
+	 * \param opt options, NONE or MPI_COMPRESS (compress the messages, all the processors must use the same option)
 	 *
 	 */
 	void sendrecvMultipleMessagesNBX(size_t n_send , size_t sz[],
 									 size_t prc[] , void * ptr[],
-									 size_t n_recv, size_t prc_recv[] ,
-									 size_t sz_recv[] ,void * (* msg_alloc)(size_t,size_t,size_t,size_t,size_t, size_t,void *),
-									 void * ptr_arg, long int opt=NONE)
+									 void * (* msg_alloc)(size_t,size_t,size_t,size_t,size_t,size_t,void *),
+									 void * ptr_arg, long int opt = NONE)
 	{
 #ifdef VCLUSTER_PERF_REPORT
 		timer nbx_timer;
@@ -1071,22 +2742,85 @@ public:
 
 #endif
 
-		// Allocate the buffers
+		NBX_prc_qcnt++;
+		if (NBX_prc_qcnt != 0)
+		{
+			std::cout << __FILE__ << ":" << __LINE__ << " error there are some asynchronous call running you have to complete them before go back to synchronous" << std::endl;
+			return;
+		}
 
-		for (size_t i = 0 ; i < n_send ; i++)
-		{send(prc[i],SEND_SPARSE + NBX_cnt*131072,ptr[i],sz[i]);}
+		vcl_trace_scope ts(trace,"nbx");
+		vcl_time_scope tc(cnt,VCL_TIME_NBX);
+		vcl_hist_scope hs(hist,prof_cat(VCL_PROF_NBX_UNKNOWN));
 
-		for (size_t i = 0 ; i < n_recv ; i++)
+		if (opt & MPI_COMPRESS)
+		{cmp.new_exchange();}
+
+		double t_ph = trace.begin();
+
+		queue_all_sends(n_send,sz,prc,ptr,opt);
+
+		trace.end("nbx_isend",t_ph);
+
+		this->NBX_prc_ptr_arg[NBX_prc_qcnt] = ptr_arg;
+		this->NBX_prc_msg_alloc[NBX_prc_qcnt] = msg_alloc;
+
+		rid[NBX_prc_qcnt] = 0;
+
+		deliver_self(sz,ptr);
+		int flag = false;
+		bool in_bar = false;
+		double t_bar = -1.0;
+		double t_reach = 0.0;
+
+		NBX_prc_reached_bar_req[NBX_prc_qcnt] = false;
+		NBX_prc_pe_round[NBX_prc_qcnt] = 0;
+		NBX_active[NBX_prc_qcnt] = NBX_Type::NBX_UNKNOWN;
+		NBX_prc_cnt_base = NBX_cnt;
+
+		log.start(10);
+
+		t_ph = trace.begin();
+
+		// Wait that all the send are acknowledge
+		do
 		{
-			void * ptr_recv = msg_alloc(sz_recv[i],0,0,prc_recv[i],i,SEND_SPARSE + NBX_cnt*131072,ptr_arg);
+			progressCommunication();
 
-			recv(prc_recv[i],SEND_SPARSE + NBX_cnt*131072,ptr_recv,sz_recv[i]);
-		}
+			// Check if all processor reached the async barrier
+			if (NBX_prc_reached_bar_req[NBX_prc_qcnt])
+			{
+				// from here we only wait the other processors
+				if (in_bar == false)
+				{
+					trace.end("nbx_probe",t_ph);
+					t_ph = trace.begin();
+					t_bar = cnt.begin();
+					t_reach = MPI_Wtime();
+					in_bar = true;
+				}
 
-		execute();
+				MPI_SAFE_CALL(MPI_Test(&bar_req,&flag,&bar_stat))
+			};
+
+			// produce a report if communication get stuck
+			log.NBXreport(NBX_cnt,req,NBX_prc_reached_bar_req[NBX_prc_qcnt],bar_stat);
+
+		} while (flag == false);
+
+		trace.end("nbx_ibarrier",t_ph);
+		cnt.time(VCL_TIME_BARRIER,t_bar);
+		nbx_timing(NBX_prc_qcnt,t_reach);
+
+		// Remove the executed request
+
+		req.clear();
+		stat.clear();
+		log.clear();
 
 		// Circular counter
 		NBX_cnt = (NBX_cnt + 1) % nbx_cycle;
+		NBX_prc_qcnt = -1;
 
 #ifdef VCLUSTER_PERF_REPORT
 		nbx_timer.stop();
@@ -1094,14 +2828,15 @@ public:
 #endif
 	}
 
-	/*! \brief Send and receive multiple messages asynchronous version
+	/*! \brief Send and receive multiple messages Asynchronous version
+	 *
+	 * This is the Asynchronous version of Send and receive NBX. This call return immediately, use
+	 * sendrecvMultipleMessagesNBXWait to synchronize. Optionally you can use the function progress_communication
+	 * to move on the communication
 	 *
 	 * It send multiple messages to a set of processors the and receive
 	 * multiple messages from another set of processors, all the processor must call this
-	 * function. In this particular case the receiver know from which processor is going
-	 * to receive.
-	 *
-	 * \warning this function only work with one send for each processor
+	 * function
 	 *
 	 * suppose the following situation the calling processor want to communicate
 	 * * 2 messages of size 100 byte to processor 1
@@ -1114,682 +2849,990 @@ public:
 	 * \param prc list of processor with which it should communicate
 	 *        [1,1,6,7,8]
 	 *
-	 * \param sz the array contain the size of the message for each processor
-	 *        (zeros must not be presents) [100,100,50,48,70]
+	 * \param sz the array contain the size of the message for each processor
+	 *        (zeros must not be presents) [100,100,50,48,70]
+	 *
+	 * \param ptr array that contain the pointers to the message to send
+	 *
+	 * \param msg_alloc This is a call-back with the purpose of allocate space
+	 *        for the incoming message and give back a valid pointer, supposing that this call-back has been triggered by
+	 *        the processor of id 5 that want to communicate with me a message of size 100 byte the call-back will have
+	 *        the following 6 parameters
+	 *        in the call-back are in order:
+	 *        * message size required to receive the message [100]
+	 *        * total message size to receive from all the processors (NBX does not provide this information)
+	 *        * the total number of processor want to communicate with you (NBX does not provide this information)
+	 *        * processor id [5]
+	 *        * ri request id (it is an id that goes from 0 to total_p, and is incremented
+	 *           every time message_alloc is called)
+	 *        * void pointer, parameter for additional data to pass to the call-back
+	 *
+	 * \param ptr_arg data passed to the call-back function specified
+	 *
+	 * \param opt options, NONE or MPI_COMPRESS (compress the messages, all the processors must use the same option)
+	 *
+	 */
+	void sendrecvMultipleMessagesNBXAsync(size_t n_send , size_t sz[],
+									 size_t prc[] , void * ptr[],
+									 void * (* msg_alloc)(size_t,size_t,size_t,size_t,size_t,size_t,void *),
+									 void * ptr_arg, long int opt = NONE)
+	{
+		NBX_prc_qcnt++;
+
+		if (NBX_prc_qcnt == 0 && (opt & MPI_COMPRESS))
+		{cmp.new_exchange();}
+
+		double t_ph = trace.begin();
+
+		queue_all_sends(n_send,sz,prc,ptr,opt);
+
+		trace.end("nbx_isend",t_ph);
+
+		this->NBX_prc_ptr_arg[NBX_prc_qcnt] = ptr_arg;
+		this->NBX_prc_msg_alloc[NBX_prc_qcnt] = msg_alloc;
+
+		rid[NBX_prc_qcnt] = 0;
+
+		deliver_self(sz,ptr);
+
+		NBX_prc_reached_bar_req[NBX_prc_qcnt] = false;
+		NBX_prc_pe_round[NBX_prc_qcnt] = 0;
+		NBX_active[NBX_prc_qcnt] = NBX_Type::NBX_UNKNOWN;
+		NBX_prc_t0[NBX_prc_qcnt] = hist.begin();
+
+		log.start(10);
+		if (NBX_prc_qcnt == 0)
+		{NBX_prc_cnt_base = NBX_cnt;}
+
+		return;
+	}
+
+	/*! \brief Send and receive multiple messages wait NBX communication to complete
+	 *
+	 *
+	 */
+	void sendrecvMultipleMessagesNBXWait()
+	{
+		vcl_trace_scope ts(trace,"nbx_wait");
+		vcl_time_scope tc(cnt,VCL_TIME_NBX);
+
+		for (unsigned int j = 0 ; j < NQUEUE ; j++)
+		{
+			if (NBX_active[j] == NBX_Type::NBX_UNACTIVE)
+			{continue;}
+
+			if (NBX_active[j] == NBX_Type::NBX_KNOWN_PRC)
+			{
+				vcl_prof_scope ps(prof_api,NBX_prc_api[j]);
+
+				execute();
+
+				// Circular counter
+				NBX_cnt = (NBX_cnt + 1) % nbx_cycle;
+
+				// Allocate the buffers
+
+				for (size_t i = 0 ; i < NBX_prc_n_send[j] ; i++)
+				{send(NBX_prc_prc[j][i],SEND_SPARSE + NBX_cnt*131072,NBX_prc_ptr[j][i],NBX_prc_sz[j][i]);}
+
+				for (size_t i = 0 ; i < NBX_prc_n_recv[j] ; i++)
+				{
+					void * ptr_recv = NBX_prc_msg_alloc[j](sz_recv_tmp.get(i),0,0,NBX_prc_prc_recv[j][i],i,0,this->NBX_prc_ptr_arg[j]);
+
+					recv(NBX_prc_prc_recv[j][i],SEND_SPARSE + NBX_cnt*131072,ptr_recv,sz_recv_tmp.get(i));
+				}
+
+				NBX_active[j] = NBX_Type::NBX_KNOWN;
+			}
+
+			if (NBX_active[j] == NBX_Type::NBX_KNOWN)
+			{
+				execute();
+
+				// Circular counter
+				NBX_cnt = (NBX_cnt + 1) % nbx_cycle;
+				NBX_active[j] = NBX_Type::NBX_UNACTIVE;
+
+				hist.latency(NBX_prc_api[j],NBX_prc_t0[j]);
+
+				continue;
+			}
+
+			int flag = false;
+			bool in_bar = false;
+			double t_bar = -1.0;
+			double t_reach = 0.0;
+			double t_ph = trace.begin();
+
+			// Wait that all the send are acknowledge
+			do
+			{
+				progressCommunication();
+
+				// Check if all processor reached the async barrier
+				if (NBX_prc_reached_bar_req[j])
+				{
+					// from here we only wait the other processors
+					if (in_bar == false)
+					{
+						trace.end("nbx_probe",t_ph);
+						t_ph = trace.begin();
+						t_bar = cnt.begin();
+						t_reach = MPI_Wtime();
+						in_bar = true;
+					}
+
+					MPI_SAFE_CALL(MPI_Test(&bar_req,&flag,&bar_stat))
+				};
+
+				// produce a report if communication get stuck
+				log.NBXreport(NBX_cnt,req,NBX_prc_reached_bar_req[j],bar_stat);
+
+			} while (flag == false);
+
+			trace.end("nbx_ibarrier",t_ph);
+			cnt.time(VCL_TIME_BARRIER,t_bar);
+			nbx_timing(j,t_reach);
+
+			// Remove the executed request
+
+			req.clear();
+			stat.clear();
+			log.clear();
+
+			// Circular counter
+			NBX_cnt = (NBX_cnt + 1) % nbx_cycle;
+			NBX_active[j] = NBX_Type::NBX_UNACTIVE;
+
+			hist.latency(NBX_prc_api[j],NBX_prc_t0[j]);
+		}
+
+		NBX_prc_qcnt = -1;
+		return;
+	}
+
+	/*! \brief Send data to a processor
+	 *
+	 * \warning In order to avoid deadlock every send must be coupled with a recv
+	 *          in case you want to send data without knowledge from the other side
+	 *          consider to use sendRecvMultipleMessages
 	 *
-	 * \param ptr array that contain the pointers to the message to send
+	 * \warning operation is asynchronous execute must be called to ensure they are executed
 	 *
-	 * \param msg_alloc This is a call-back with the purpose of allocate space
-	 *        for the incoming message and give back a valid pointer, supposing that this call-back has been triggered by
-	 *        the processor of id 5 that want to communicate with me a message of size 100 byte the call-back will have
-	 *        the following 6 parameters
-	 *        in the call-back are in order:
-	 *        * message size required to receive the message [100]
-	 *        * total message size to receive from all the processors (NBX does not provide this information)
-	 *        * the total number of processor want to communicate with you (NBX does not provide this information)
-	 *        * processor id [5]
-	 *        * ri request id (it is an id that goes from 0 to total_p, and is incremented
-	 *           every time message_alloc is called)
-	 *        * void pointer, parameter for additional data to pass to the call-back
+	 * \see sendRecvMultipleMessages
 	 *
-	 * \param ptr_arg data passed to the call-back function specified
+	 * \param proc processor id
+	 * \param tag id
+	 * \param mem buffer with the data to send
+	 * \param sz size
 	 *
-	 * \param opt options, NONE (ignored in this moment)
+	 * \return true if succeed false otherwise
 	 *
 	 */
-	void sendrecvMultipleMessagesNBXAsync(size_t n_send , size_t sz[],
-									 size_t prc[] , void * ptr[],
-									 size_t n_recv, size_t prc_recv[] ,
-									 size_t sz_recv[] ,void * (* msg_alloc)(size_t,size_t,size_t,size_t,size_t, size_t,void *),
-									 void * ptr_arg, long int opt=NONE)
+	bool send(size_t proc, size_t tag, const void * mem, size_t sz)
 	{
-		NBX_prc_qcnt++;
-		if (NBX_prc_qcnt >= NQUEUE)
-		{
-			std::cout << __FILE__ << ":" << __LINE__ << " error you can queue at most " << NQUEUE << " asychronous communication functions " << std::endl;
-			return;
-		}
-
-		// Allocate the buffers
+		if (check_process_level("send") == false)
+		{return false;}
 
-		for (size_t i = 0 ; i < n_send ; i++)
-		{send(prc[i],SEND_SPARSE + NBX_cnt*131072,ptr[i],sz[i]);}
+		// send over MPI
 
-		for (size_t i = 0 ; i < n_recv ; i++)
-		{
-			void * ptr_recv = msg_alloc(sz_recv[i],0,0,prc_recv[i],i,SEND_SPARSE + NBX_cnt*131072,ptr_arg);
+		// Create one request
+		req.add();
 
-			recv(prc_recv[i],SEND_SPARSE + NBX_cnt*131072,ptr_recv,sz_recv[i]);
-		}
+		// send
+		MPI_IsendWB::send(proc,SEND_RECV_BASE + tag,mem,sz,req.last(),ext_comm);
+		record_send(proc,sz);
+		prof.send(prof_api,proc,sz);
+		hist.size(prof_api,sz);
+		cnt.send(sz);
 
-		NBX_active[NBX_prc_qcnt] = NBX_Type::NBX_KNOWN;
-		if (NBX_prc_qcnt == 0)
-		{NBX_prc_cnt_base = NBX_cnt;}
+		return true;
 	}
 
-	openfpm::vector<size_t> sz_recv_tmp;
 
-	/*! \brief Send and receive multiple messages
-	 *
-	 * It send multiple messages to a set of processors the and receive
-	 * multiple messages from another set of processors, all the processor must call this
-	 * function. In this particular case the receiver know from which processor is going
-	 * to receive, but does not know the size.
-	 *
-	 *
-	 * suppose the following situation the calling processor want to communicate
-	 * * 2 messages of size 100 byte to processor 1
-	 * * 1 message of size 50 byte to processor 6
-	 * * 1 message of size 48 byte to processor 7
-	 * * 1 message of size 70 byte to processor 8
-	 *
-	 * \param n_send number of send for this processor [4]
-	 *
-	 * \param prc list of processor with which it should communicate
-	 *        [1,1,6,7,8]
+	/*! \brief Send data to a processor
 	 *
-	 * \param sz the array contain the size of the message for each processor
-	 *        (zeros must not be presents) [100,100,50,48,70]
+	 * \warning In order to avoid deadlock every send must be coupled with a recv
+	 *          in case you want to send data without knowledge from the other side
+	 *          consider to use sendRecvMultipleMessages
 	 *
-	 * \param ptr array that contain the pointers to the message to send
+	 * \warning operation is asynchronous execute must be called to ensure they are executed
 	 *
-	 * \param msg_alloc This is a call-back with the purpose of allocate space
-	 *        for the incoming message and give back a valid pointer, supposing that this call-back has been triggered by
-	 *        the processor of id 5 that want to communicate with me a message of size 100 byte the call-back will have
-	 *        the following 6 parameters
-	 *        in the call-back are in order:
-	 *        * message size required to receive the message [100]
-	 *        * total message size to receive from all the processors (NBX does not provide this information)
-	 *        * the total number of processor want to communicate with you (NBX does not provide this information)
-	 *        * processor id [5]
-	 *        * ri request id (it is an id that goes from 0 to total_p, and is incremented
-	 *           every time message_alloc is called)
-	 *        * void pointer, parameter for additional data to pass to the call-back
+	 * \see sendRecvMultipleMessages
 	 *
-	 * \param ptr_arg data passed to the call-back function specified
+	 * \param proc processor id
+	 * \param tag id
+	 * \param v buffer to send
 	 *
-	 * \param opt options, NONE (ignored in this moment)
+	 * \return true if succeed false otherwise
 	 *
 	 */
-	void sendrecvMultipleMessagesNBX(size_t n_send , size_t sz[], size_t prc[] ,
-									 void * ptr[], size_t n_recv, size_t prc_recv[] ,
-									 void * (* msg_alloc)(size_t,size_t,size_t,size_t,size_t,size_t,void *),
-									 void * ptr_arg, long int opt=NONE)
+	template<typename T, typename Mem, template<typename> class gr> bool send(size_t proc, size_t tag, openfpm::vector<T,Mem,gr> & v)
 	{
-#ifdef VCLUSTER_PERF_REPORT
-		timer nbx_timer;
-		nbx_timer.start();
-#endif
-
-		sz_recv_tmp.resize(n_recv);
-
-		// First we understand the receive size for each processor
-
-		for (size_t i = 0 ; i < n_send ; i++)
-		{send(prc[i],SEND_SPARSE + NBX_cnt*131072,&sz[i],sizeof(size_t));}
-
-		for (size_t i = 0 ; i < n_recv ; i++)
-		{recv(prc_recv[i],SEND_SPARSE + NBX_cnt*131072,&sz_recv_tmp.get(i),sizeof(size_t));}
-
-		execute();
-
-		// Circular counter
-		NBX_cnt = (NBX_cnt + 1) % nbx_cycle;
-
-		// Allocate the buffers
-
-		for (size_t i = 0 ; i < n_send ; i++)
-		{send(prc[i],SEND_SPARSE + NBX_cnt*131072,ptr[i],sz[i]);}
+		if (check_process_level("send") == false)
+		{return false;}
 
-		for (size_t i = 0 ; i < n_recv ; i++)
-		{
-			void * ptr_recv = msg_alloc(sz_recv_tmp.get(i),0,0,prc_recv[i],i,0,ptr_arg);
+#ifdef SE_CLASS1
+		checkType<T>();
+#endif
 
-			recv(prc_recv[i],SEND_SPARSE + NBX_cnt*131072,ptr_recv,sz_recv_tmp.get(i));
-		}
+		// send over MPI
 
-		execute();
+		// Create one request
+		req.add();
 
-		// Circular counter
-		NBX_cnt = (NBX_cnt + 1) % nbx_cycle;
+		// send
+		MPI_IsendW<T,Mem,gr>::send(proc,SEND_RECV_BASE + tag,v,req.last(),ext_comm);
+		record_send(proc,v.size()*sizeof(T));
+		prof.send(prof_api,proc,v.size()*sizeof(T));
+		hist.size(prof_api,v.size()*sizeof(T));
+		cnt.send(v.size()*sizeof(T));
 
-#ifdef VCLUSTER_PERF_REPORT
-		nbx_timer.stop();
-		time_spent += nbx_timer.getwct();
-#endif
+		return true;
 	}
 
-	/*! \brief Send and receive multiple messages asynchronous version
+	/*! \brief Recv data from a processor
 	 *
-	 * It send multiple messages to a set of processors the and receive
-	 * multiple messages from another set of processors, all the processor must call this
-	 * function. In this particular case the receiver know from which processor is going
-	 * to receive, but does not know the size.
+	 * \warning In order to avoid deadlock every recv must be coupled with a send
+	 *          in case you want to send data without knowledge from the other side
+	 *          consider to use or sendrecvMultipleMessagesNBX
 	 *
+	 * \warning operation is asynchronous execute must be called to ensure they are executed
 	 *
-	 * suppose the following situation the calling processor want to communicate
-	 * * 2 messages of size 100 byte to processor 1
-	 * * 1 message of size 50 byte to processor 6
-	 * * 1 message of size 48 byte to processor 7
-	 * * 1 message of size 70 byte to processor 8
+	 * \see sendrecvMultipleMessagesNBX
 	 *
-	 * \param n_send number of send for this processor [4]
+	 * \param proc processor id
+	 * \param tag id
+	 * \param v buffer to send
+	 * \param sz size of the buffer
 	 *
-	 * \param prc list of processor with which it should communicate
-	 *        [1,1,6,7,8]
+	 * \return true if succeed false otherwise
 	 *
-	 * \param sz the array contain the size of the message for each processor
-	 *        (zeros must not be presents) [100,100,50,48,70]
+	 */
+	bool recv(size_t proc, size_t tag, void * v, size_t sz)
+	{
+		if (check_process_level("recv") == false)
+		{return false;}
+
+		// recv over MPI
+
+		// Create one request
+		req.add();
+
+		// receive
+		MPI_IrecvWB::recv(proc,SEND_RECV_BASE + tag,v,sz,req.last(),ext_comm);
+		prof.recv(prof_api,proc,sz);
+		cnt.recv(sz);
+
+		return true;
+	}
+
+	/*! \brief Recv data from a processor
 	 *
-	 * \param ptr array that contain the pointers to the message to send
+	 * \warning In order to avoid deadlock every recv must be coupled with a send
+	 *          in case you want to send data without knowledge from the other side
+	 *          consider to use sendrecvMultipleMessagesNBX
 	 *
-	 * \param msg_alloc This is a call-back with the purpose of allocate space
-	 *        for the incoming message and give back a valid pointer, supposing that this call-back has been triggered by
-	 *        the processor of id 5 that want to communicate with me a message of size 100 byte the call-back will have
-	 *        the following 6 parameters
-	 *        in the call-back are in order:
-	 *        * message size required to receive the message [100]
-	 *        * total message size to receive from all the processors (NBX does not provide this information)
-	 *        * the total number of processor want to communicate with you (NBX does not provide this information)
-	 *        * processor id [5]
-	 *        * ri request id (it is an id that goes from 0 to total_p, and is incremented
-	 *           every time message_alloc is called)
-	 *        * void pointer, parameter for additional data to pass to the call-back
+	 * \warning operation is asynchronous execute must be called to ensure they are executed
 	 *
-	 * \param ptr_arg data passed to the call-back function specified
+	 * \see sendrecvMultipleMessagesNBX
+	 *
+	 * \param proc processor id
+	 * \param tag id
+	 * \param v vector to send
 	 *
-	 * \param opt options, NONE (ignored in this moment)
+	 * \return true if succeed false otherwise
 	 *
 	 */
-	void sendrecvMultipleMessagesNBXAsync(size_t n_send , size_t sz[], size_t prc[] ,
-									 void * ptr[], size_t n_recv, size_t prc_recv[] ,
-									 void * (* msg_alloc)(size_t,size_t,size_t,size_t,size_t,size_t,void *),
-									 void * ptr_arg, long int opt=NONE)
+	template<typename T, typename Mem, template<typename> class gr> bool recv(size_t proc, size_t tag, openfpm::vector<T,Mem,gr> & v)
 	{
-		NBX_prc_qcnt++;
-		if (NBX_prc_qcnt >= NQUEUE)
-		{
-			std::cout << __FILE__ << ":" << __LINE__ << " error you can queue at most " << NQUEUE << " asychronous communication functions " << std::endl;
-			return;
-		}
-
-		sz_recv_tmp.resize(n_recv);
-
-		// First we understand the receive size for each processor
+		if (check_process_level("recv") == false)
+		{return false;}
 
-		for (size_t i = 0 ; i < n_send ; i++)
-		{send(prc[i],SEND_SPARSE + NBX_cnt*131072,&sz[i],sizeof(size_t));}
+#ifdef SE_CLASS1
+			checkType<T>();
+#endif
 
-		for (size_t i = 0 ; i < n_recv ; i++)
-		{recv(prc_recv[i],SEND_SPARSE + NBX_cnt*131072,&sz_recv_tmp.get(i),sizeof(size_t));}
+			// recv over MPI
 
-		////// Save all the status variables
+			// Create one request
+			req.add();
 
-		NBX_prc_n_send[NBX_prc_qcnt] = n_send;
-		NBX_prc_prc[NBX_prc_qcnt] = prc;
-		NBX_prc_ptr[NBX_prc_qcnt] = ptr;
-		NBX_prc_sz[NBX_prc_qcnt] = sz;
-		NBX_prc_n_recv[NBX_prc_qcnt] = n_recv;
-		NBX_prc_prc_recv[NBX_prc_qcnt] = prc_recv;
-		NBX_prc_msg_alloc[NBX_prc_qcnt] = msg_alloc;
-		NBX_prc_ptr_arg[NBX_prc_qcnt] = ptr_arg;
+			// receive
+			MPI_IrecvW<T>::recv(proc,SEND_RECV_BASE + tag,v,req.last(),ext_comm);
+			prof.recv(prof_api,proc,v.size()*sizeof(T));
+			cnt.recv(v.size()*sizeof(T));
 
-		NBX_active[NBX_prc_qcnt] = NBX_Type::NBX_KNOWN_PRC;
-		if (NBX_prc_qcnt == 0)
-		{NBX_prc_cnt_base = NBX_cnt;}
+			return true;
 	}
 
-	/*! \brief Send and receive multiple messages
-	 *
-	 * It send multiple messages to a set of processors the and receive
-	 * multiple messages from another set of processors, all the processor must call this
-	 * function
-	 *
-	 * suppose the following situation the calling processor want to communicate
-	 * * 2 messages of size 100 byte to processor 1
-	 * * 1 message of size 50 byte to processor 6
-	 * * 1 message of size 48 byte to processor 7
-	 * * 1 message of size 70 byte to processor 8
-	 *
-	 * \param n_send number of send for this processor [4]
-	 *
-	 * \param prc list of processor with which it should communicate
-	 *        [1,1,6,7,8]
-	 *
-	 * \param sz the array contain the size of the message for each processor
-	 *        (zeros must not be presents) [100,100,50,48,70]
+	/*! \brief Gather the data from all processors
 	 *
-	 * \param ptr array that contain the pointers to the message to send
+	 * send a primitive data T receive the same primitive T from all the other processors
 	 *
-	 * \param msg_alloc This is a call-back with the purpose of allocate space
-	 *        for the incoming message and give back a valid pointer, supposing that this call-back has been triggered by
-	 *        the processor of id 5 that want to communicate with me a message of size 100 byte the call-back will have
-	 *        the following 6 parameters
-	 *        in the call-back are in order:
-	 *        * message size required to receive the message [100]
-	 *        * total message size to receive from all the processors (NBX does not provide this information)
-	 *        * the total number of processor want to communicate with you (NBX does not provide this information)
-	 *        * processor id [5]
-	 *        * ri request id (it is an id that goes from 0 to total_p, and is incremented
-	 *           every time message_alloc is called)
-	 *        * void pointer, parameter for additional data to pass to the call-back
+	 * \warning operation is asynchronous execute must be called to ensure they are executed
 	 *
-	 * \param ptr_arg data passed to the call-back function specified
+	 * \param v vector to receive (automaticaly resized)
+	 * \param send data to send
 	 *
-	 * \param opt options, NONE (ignored in this moment)
+	 * \return true if succeed false otherwise
 	 *
 	 */
-	void sendrecvMultipleMessagesNBX(size_t n_send , size_t sz[],
-									 size_t prc[] , void * ptr[],
-									 void * (* msg_alloc)(size_t,size_t,size_t,size_t,size_t,size_t,void *),
-									 void * ptr_arg, long int opt = NONE)
+	template<typename T, typename Mem, template<typename> class gr> bool allGather(T & send, openfpm::vector<T,Mem,gr> & v)
 	{
-#ifdef VCLUSTER_PERF_REPORT
-		timer nbx_timer;
-		nbx_timer.start();
+		if (check_process_level("allGather") == false)
+		{return false;}
 
+#ifdef SE_CLASS1
+		checkType<T>();
 #endif
 
-		NBX_prc_qcnt++;
-		if (NBX_prc_qcnt != 0)
-		{
-			std::cout << __FILE__ << ":" << __LINE__ << " error there are some asynchronous call running you have to complete them before go back to synchronous" << std::endl;
-			return;
-		}
+		// Create one request
+		req.add();
 
-		queue_all_sends(n_send,sz,prc,ptr);
+		// Number of processors
+		v.resize(getProcessingUnits());
 
-		this->NBX_prc_ptr_arg[NBX_prc_qcnt] = ptr_arg;
-		this->NBX_prc_msg_alloc[NBX_prc_qcnt] = msg_alloc;
+		// gather
+		MPI_IAllGatherW<T>::gather(&send,1,v.getPointer(),1,req.last(),ext_comm);
 
-		rid[NBX_prc_qcnt] = 0;
-		int flag = false;
+		return true;
+	}
 
-		NBX_prc_reached_bar_req[NBX_prc_qcnt] = false;
-		NBX_active[NBX_prc_qcnt] = NBX_Type::NBX_UNKNOWN;
-		NBX_prc_cnt_base = NBX_cnt;
+	/*! \brief Broadcast the data to all processors
+	 *
+	 * broadcast a vector of primitives.
+	 *
+	 * \warning operation is asynchronous execute must be called to ensure the operation is executed
+	 *
+	 * \warning the non-root processor must resize the vector to the exact receive size. This mean the
+	 *          each processor must known a priory the receiving size
+	 *
+	 * \param v vector to send in the case of the root processor and vector where to receive in the case of
+	 *          non-root
+	 * \param root processor (who broadcast)
+	 *
+	 * \return true if succeed false otherwise
+	 *
+	 */
+	template<typename T, typename Mem, template<typename> class layout_base >
+	bool Bcast(openfpm::vector<T,Mem,layout_base> & v, size_t root)
+	{
+		if (check_process_level("Bcast") == false)
+		{return false;}
 
-		log.start(10);
+#ifdef SE_CLASS1
+		checkType<T>();
+#endif
 
-		// Wait that all the send are acknowledge
-		do
-		{
-			progressCommunication();
+		b_cast_helper<openfpm::vect_isel<T>::value == STD_VECTOR || is_layout_mlin<layout_base<T>>::value >::bcast_(req,v,root, ext_comm);
 
-			// Check if all processor reached the async barrier
-			if (NBX_prc_reached_bar_req[NBX_prc_qcnt])
-			{MPI_SAFE_CALL(MPI_Test(&bar_req,&flag,&bar_stat))};
+		return true;
+	}
 
-			// produce a report if communication get stuck
-			log.NBXreport(NBX_cnt,req,NBX_prc_reached_bar_req[NBX_prc_qcnt],bar_stat);
+	/*! \brief Execute all the requests
+	 *
+	 * It wait the requests of all the groups
+	 *
+	 */
+	void execute()
+	{
+		// post the fused reductions
+		flush_reductions();
 
-		} while (flag == false);
+		// if req == 0 return
+		if (req.size() == 0)
+			return;
 
-		// Remove the executed request
+		// Wait for all the requests
+		stat.resize(req.size());
+
+		MPI_SAFE_CALL(MPI_Waitall(req.size(),&req.get(0),&stat.get(0)));
 
+		// Remove executed request and status
 		req.clear();
 		stat.clear();
-		log.clear();
+		req_grp.clear();
 
-		// Circular counter
-		NBX_cnt = (NBX_cnt + 1) % nbx_cycle;
-		NBX_prc_qcnt = -1;
+		// execute the post functions
+		for (size_t i = 0 ; i < post_exe.size() ; i++)
+		{post_exe[i]();}
 
-#ifdef VCLUSTER_PERF_REPORT
-		nbx_timer.stop();
-		time_spent += nbx_timer.getwct();
-#endif
+		post_exe.clear();
+		post_grp.clear();
 	}
 
-	/*! \brief Send and receive multiple messages Asynchronous version
+	/*! \brief Set the request group of the next operations
 	 *
-	 * This is the Asynchronous version of Send and receive NBX. This call return immediately, use
-	 * sendrecvMultipleMessagesNBXWait to synchronize. Optionally you can use the function progress_communication
-	 * to move on the communication
+	 * The operations (send, recv, sum, allGather, Bcast ...) issued after this call belong to the
+	 * group g and can be completed independently from the others with wait(g) or test(g).
+	 * The default group is 0. execute() complete all the groups
 	 *
-	 * It send multiple messages to a set of processors the and receive
-	 * multiple messages from another set of processors, all the processor must call this
-	 * function
+	 * \code
+	 * vcl.setRequestGroup(1);
+	 * vcl.send(p,0,big_buffer);
+	 * vcl.setRequestGroup(2);
+	 * vcl.sum(residual);
+	 * vcl.setRequestGroup(0);
 	 *
-	 * suppose the following situation the calling processor want to communicate
-	 * * 2 messages of size 100 byte to processor 1
-	 * * 1 message of size 50 byte to processor 6
-	 * * 1 message of size 48 byte to processor 7
-	 * * 1 message of size 70 byte to processor 8
+	 * vcl.wait(2);
+	 * // residual is ready, big_buffer can still be in flight
+	 * vcl.wait(1);
+	 * \endcode
 	 *
-	 * \param n_send number of send for this processor [4]
+	 * \warning the collective operations must be waited in the same order on all the processors
 	 *
-	 * \param prc list of processor with which it should communicate
-	 *        [1,1,6,7,8]
+	 * \param g group
 	 *
-	 * \param sz the array contain the size of the message for each processor
-	 *        (zeros must not be presents) [100,100,50,48,70]
+	 */
+	void setRequestGroup(size_t g)
+	{
+		// the fused reductions queued so far belong to the current group
+		flush_reductions();
+		tag_requests();
+
+		cur_grp = g;
+	}
+
+	/*! \brief Get the request group of the next operations
 	 *
-	 * \param ptr array that contain the pointers to the message to send
+	 * \return the group
 	 *
-	 * \param msg_alloc This is a call-back with the purpose of allocate space
-	 *        for the incoming message and give back a valid pointer, supposing that this call-back has been triggered by
-	 *        the processor of id 5 that want to communicate with me a message of size 100 byte the call-back will have
-	 *        the following 6 parameters
-	 *        in the call-back are in order:
-	 *        * message size required to receive the message [100]
-	 *        * total message size to receive from all the processors (NBX does not provide this information)
-	 *        * the total number of processor want to communicate with you (NBX does not provide this information)
-	 *        * processor id [5]
-	 *        * ri request id (it is an id that goes from 0 to total_p, and is incremented
-	 *           every time message_alloc is called)
-	 *        * void pointer, parameter for additional data to pass to the call-back
+	 */
+	size_t getRequestGroup()
+	{
+		return cur_grp;
+	}
+
+	/*! \brief Wait the requests of a group
 	 *
-	 * \param ptr_arg data passed to the call-back function specified
+	 * The post-processing of the group (like the copy of the fused reductions) is executed
 	 *
-	 * \param opt options, NONE (ignored in this moment)
+	 * \param g group
 	 *
 	 */
-	void sendrecvMultipleMessagesNBXAsync(size_t n_send , size_t sz[],
-									 size_t prc[] , void * ptr[],
-									 void * (* msg_alloc)(size_t,size_t,size_t,size_t,size_t,size_t,void *),
-									 void * ptr_arg, long int opt = NONE)
+	void wait(size_t g)
 	{
-		NBX_prc_qcnt++;
-		queue_all_sends(n_send,sz,prc,ptr);
+		flush_reductions();
+		tag_requests();
 
-		this->NBX_prc_ptr_arg[NBX_prc_qcnt] = ptr_arg;
-		this->NBX_prc_msg_alloc[NBX_prc_qcnt] = msg_alloc;
+		req_sel.clear();
+		for (size_t i = 0 ; i < req.size() ; i++)
+		{
+			if (req_grp.get(i) == g)
+			{req_sel.add(req.get(i));}
+		}
 
-		rid[NBX_prc_qcnt] = 0;
+		if (req_sel.size() != 0)
+		{MPI_SAFE_CALL(MPI_Waitall(req_sel.size(),req_sel.getPointer(),MPI_STATUSES_IGNORE));}
 
-		NBX_prc_reached_bar_req[NBX_prc_qcnt] = false;
-		NBX_active[NBX_prc_qcnt] = NBX_Type::NBX_UNKNOWN;
+		release_group(g);
+	}
 
-		log.start(10);
-		if (NBX_prc_qcnt == 0)
-		{NBX_prc_cnt_base = NBX_cnt;}
+	/*! \brief Test if the requests of a group are completed
+	 *
+	 * If they are completed the group is released like with wait(g)
+	 *
+	 * \param g group
+	 *
+	 * \return true if the group is completed
+	 *
+	 */
+	bool test(size_t g)
+	{
+		flush_reductions();
+		tag_requests();
 
-		return;
+		req_sel.clear();
+		for (size_t i = 0 ; i < req.size() ; i++)
+		{
+			if (req_grp.get(i) == g)
+			{req_sel.add(req.get(i));}
+		}
+
+		int flag = true;
+
+		if (req_sel.size() != 0)
+		{MPI_SAFE_CALL(MPI_Testall(req_sel.size(),req_sel.getPointer(),&flag,MPI_STATUSES_IGNORE));}
+
+		if (flag == false)
+		{return false;}
+
+		release_group(g);
+
+		return true;
 	}
 
-	/*! \brief Send and receive multiple messages wait NBX communication to complete
+	/*! \brief Wait until one of the groups in progress is completed
+	 *
+	 * The completed group is released like with wait(g)
 	 *
+	 * \return the completed group, (size_t)-1 if there are no requests in progress
 	 *
 	 */
-	void sendrecvMultipleMessagesNBXWait()
+	size_t waitany()
 	{
-		for (unsigned int j = 0 ; j < NQUEUE ; j++)
-		{
-			if (NBX_active[j] == NBX_Type::NBX_UNACTIVE)
-			{continue;}
+		flush_reductions();
+		tag_requests();
 
-			if (NBX_active[j] == NBX_Type::NBX_KNOWN_PRC)
-			{
-				execute();
+		if (req.size() == 0)
+		{return (size_t)-1;}
 
-				// Circular counter
-				NBX_cnt = (NBX_cnt + 1) % nbx_cycle;
+		size_t g = req_grp.get(0);
 
-				// Allocate the buffers
+		while (true)
+		{
+			int idx;
+			MPI_SAFE_CALL(MPI_Waitany(req.size(),req.getPointer(),&idx,MPI_STATUS_IGNORE));
 
-				for (size_t i = 0 ; i < NBX_prc_n_send[j] ; i++)
-				{send(NBX_prc_prc[j][i],SEND_SPARSE + NBX_cnt*131072,NBX_prc_ptr[j][i],NBX_prc_sz[j][i]);}
+			// all the requests are completed
+			if (idx == MPI_UNDEFINED)
+			{break;}
 
-				for (size_t i = 0 ; i < NBX_prc_n_recv[j] ; i++)
-				{
-					void * ptr_recv = NBX_prc_msg_alloc[j](sz_recv_tmp.get(i),0,0,NBX_prc_prc_recv[j][i],i,0,this->NBX_prc_ptr_arg[j]);
+			// the completed requests become MPI_REQUEST_NULL
+			g = req_grp.get(idx);
 
-					recv(NBX_prc_prc_recv[j][i],SEND_SPARSE + NBX_cnt*131072,ptr_recv,sz_recv_tmp.get(i));
-				}
+			bool done = true;
+			for (size_t i = 0 ; i < req.size() ; i++)
+			{done &= (req_grp.get(i) != g || req.get(i) == MPI_REQUEST_NULL);}
 
-				NBX_active[j] = NBX_Type::NBX_KNOWN;
-			}
+			if (done == true)
+			{break;}
+		}
 
-			if (NBX_active[j] == NBX_Type::NBX_KNOWN)
-			{
-				execute();
+		release_group(g);
 
-				// Circular counter
-				NBX_cnt = (NBX_cnt + 1) % nbx_cycle;
-				NBX_active[j] = NBX_Type::NBX_UNACTIVE;
+		return g;
+	}
 
-				continue;
-			}
+	/*! \brief Get the per-peer profiler
+	 *
+	 * \code
+	 * vcl.getProfiler().enable(true);
+	 * vcl.getProfiler().setLabel("ghost_get");
+	 * // ... communications
+	 * vcl.writeProfile("comm.csv");
+	 * \endcode
+	 *
+	 * \return the profiler
+	 *
+	 */
+	Vcluster_profiler & getProfiler()
+	{
+		return prof;
+	}
 
-			int flag = false;
+	/*! \brief Enable the profiler and write the profile at openfpm_finalize
+	 *
+	 * It is also activated setting the environment variable VCLUSTER_PROFILE to the file name
+	 *
+	 * \param file output file (.json for JSON, CSV otherwise)
+	 *
+	 */
+	void setProfileOutput(const std::string & file)
+	{
+		prof_file = file;
+		prof.enable(true);
+	}
 
-			// Wait that all the send are acknowledge
-			do
-			{
-				progressCommunication();
+	/*! \brief Gather the profile of all the processors on the processor 0 and write it
+	 *
+	 * Each row (or JSON object) is a label, a category, a pair of processors and the bytes and
+	 * messages sent and received
+	 *
+	 * \warning it is collective
+	 *
+	 * \param file output file (.json for JSON, CSV otherwise)
+	 *
+	 */
+	void writeProfile(const std::string & file)
+	{
+		bool json = file.size() >= 5 && file.compare(file.size() - 5,5,".json") == 0;
 
-				// Check if all processor reached the async barrier
-				if (NBX_prc_reached_bar_req[j])
-				{MPI_SAFE_CALL(MPI_Test(&bar_req,&flag,&bar_stat))};
+		std::stringstream str;
 
-				// produce a report if communication get stuck
-				log.NBXreport(NBX_cnt,req,NBX_prc_reached_bar_req[j],bar_stat);
+		// every JSON object start with a separator, the first one is removed at the end
+		bool first = false;
 
-			} while (flag == false);
+		if (json == true)
+		{prof.writeJSON(str,m_rank,first);}
+		else
+		{prof.writeCSV(str,m_rank);}
 
-			// Remove the executed request
+		std::vector<char> all;
 
-			req.clear();
-			stat.clear();
-			log.clear();
+		if (gather_text(str.str(),all) == false)
+		{return;}
 
-			// Circular counter
-			NBX_cnt = (NBX_cnt + 1) % nbx_cycle;
-			NBX_active[j] = NBX_Type::NBX_UNACTIVE;
+		std::ofstream out(file);
+
+		if (out.is_open() == false)
+		{
+			std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " cannot open " << file << std::endl;
+			return;
+		}
+
+		const char * rows = all.data();
+		size_t n_rows = all.size() - 1;
 
+		if (json == true && n_rows >= 2)
+		{
+			rows += 2;
+			n_rows -= 2;
 		}
 
-		NBX_prc_qcnt = -1;
-		return;
+		if (json == true)
+		{out << "[\n";}
+		else
+		{out << "rank,label,api,peer,bytes_sent,msgs_sent,bytes_recv,msgs_recv\n";}
+
+		out.write(rows,n_rows);
+
+		if (json == true)
+		{out << "\n]\n";}
 	}
 
-	/*! \brief Send data to a processor
-	 *
-	 * \warning In order to avoid deadlock every send must be coupled with a recv
-	 *          in case you want to send data without knowledge from the other side
-	 *          consider to use sendRecvMultipleMessages
+	/*! \brief Get the timeline of the communication phases
 	 *
-	 * \warning operation is asynchronous execute must be called to ensure they are executed
+	 * \return the trace
 	 *
-	 * \see sendRecvMultipleMessages
+	 */
+	Vcluster_trace & getTrace()
+	{
+		return trace;
+	}
+
+	/*! \brief Enable the trace and write it at openfpm_finalize
 	 *
-	 * \param proc processor id
-	 * \param tag id
-	 * \param mem buffer with the data to send
-	 * \param sz size
+	 * It is also activated setting the environment variable VCLUSTER_TRACE to the file name
 	 *
-	 * \return true if succeed false otherwise
+	 * \param file output file
+	 * \param capacity maximum number of phases stored for each processor
 	 *
 	 */
-	bool send(size_t proc, size_t tag, const void * mem, size_t sz)
+	void setTraceOutput(const std::string & file, size_t capacity = 65536)
 	{
-		// send over MPI
-
-		// Create one request
-		req.add();
-
-		// send
-		MPI_IsendWB::send(proc,SEND_RECV_BASE + tag,mem,sz,req.last(),ext_comm);
-
-		return true;
+		trace_file = file;
+		trace.enable(true,capacity);
 	}
 
-
-	/*! \brief Send data to a processor
-	 *
-	 * \warning In order to avoid deadlock every send must be coupled with a recv
-	 *          in case you want to send data without knowledge from the other side
-	 *          consider to use sendRecvMultipleMessages
-	 *
-	 * \warning operation is asynchronous execute must be called to ensure they are executed
+	/*! \brief Gather the trace of all the processors on the processor 0 and write it in Chrome trace format
 	 *
-	 * \see sendRecvMultipleMessages
+	 * The file can be opened with chrome://tracing or Perfetto, every processor is a process. The
+	 * clocks are aligned at the barrier at the beginning of this function
 	 *
-	 * \param proc processor id
-	 * \param tag id
-	 * \param v buffer to send
+	 * \warning it is collective
 	 *
-	 * \return true if succeed false otherwise
+	 * \param file output file
 	 *
 	 */
-	template<typename T, typename Mem, template<typename> class gr> bool send(size_t proc, size_t tag, openfpm::vector<T,Mem,gr> & v)
+	void writeTrace(const std::string & file)
 	{
-#ifdef SE_CLASS1
-		checkType<T>();
-#endif
+		MPI_SAFE_CALL(MPI_Barrier(ext_comm));
+		double t_ref = MPI_Wtime();
 
-		// send over MPI
+		// shift the timestamps so that the oldest phase of all the processors start at 0
+		double shift = (trace.size() != 0)?(t_ref - trace.get(0).start)*1e6:0.0;
+		MPI_SAFE_CALL(MPI_Allreduce(MPI_IN_PLACE,&shift,1,MPI_DOUBLE,MPI_MAX,ext_comm));
 
-		// Create one request
-		req.add();
+		std::stringstream str;
+		trace.writeJSON(str,m_rank,t_ref,shift);
 
-		// send
-		MPI_IsendW<T,Mem,gr>::send(proc,SEND_RECV_BASE + tag,v,req.last(),ext_comm);
+		std::vector<char> all;
 
-		return true;
+		if (gather_text(str.str(),all) == false)
+		{return;}
+
+		std::ofstream out(file);
+
+		if (out.is_open() == false)
+		{
+			std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " cannot open " << file << std::endl;
+			return;
+		}
+
+		// remove the first separator
+		out << "{\"traceEvents\":[\n";
+		out.write(all.data() + 2,all.size() - 3);
+		out << "\n]}\n";
 	}
 
-	/*! \brief Recv data from a processor
+	/*! \brief Get the histograms of message sizes and exchange latencies of this processor
 	 *
-	 * \warning In order to avoid deadlock every recv must be coupled with a send
-	 *          in case you want to send data without knowledge from the other side
-	 *          consider to use or sendrecvMultipleMessagesNBX
+	 * \return the histograms
 	 *
-	 * \warning operation is asynchronous execute must be called to ensure they are executed
+	 */
+	Vcluster_histograms & getHistograms()
+	{
+		return hist;
+	}
+
+	/*! \brief Start or stop the histograms of message sizes and exchange latencies
 	 *
-	 * \see sendrecvMultipleMessagesNBX
+	 * \param active true to start
 	 *
-	 * \param proc processor id
-	 * \param tag id
-	 * \param v buffer to send
-	 * \param sz size of the buffer
+	 */
+	void enableHistograms(bool active)
+	{
+		hist.enable(active);
+	}
+
+	/*! \brief Enable the histograms and write them at openfpm_finalize
 	 *
-	 * \return true if succeed false otherwise
+	 * It is also activated setting the environment variable VCLUSTER_HISTOGRAMS to the file name
+	 *
+	 * \param file output file
 	 *
 	 */
-	bool recv(size_t proc, size_t tag, void * v, size_t sz)
+	void setHistogramOutput(const std::string & file)
 	{
-		// recv over MPI
-
-		// Create one request
-		req.add();
-
-		// receive
-		MPI_IrecvWB::recv(proc,SEND_RECV_BASE + tag,v,sz,req.last(),ext_comm);
-
-		return true;
+		hist_file = file;
+		hist.enable(true);
 	}
 
-	/*! \brief Recv data from a processor
+	/*! \brief Merge the histograms of all the processors
 	 *
-	 * \warning In order to avoid deadlock every recv must be coupled with a send
-	 *          in case you want to send data without knowledge from the other side
-	 *          consider to use sendrecvMultipleMessagesNBX
+	 * \warning it is collective
 	 *
-	 * \warning operation is asynchronous execute must be called to ensure they are executed
+	 * \param glob histograms of all the processors (output)
 	 *
-	 * \see sendrecvMultipleMessagesNBX
+	 */
+	void reduceHistograms(Vcluster_histograms & glob)
+	{
+		std::vector<size_t> & loc = hist.getData();
+		std::vector<size_t> & all = glob.getData();
+
+		MPI_SAFE_CALL(MPI_Allreduce(loc.data(),all.data(),loc.size(),MPI_UNSIGNED_LONG,MPI_SUM,ext_comm));
+	}
+
+	/*! \brief Merge the histograms of all the processors and write them in JSON on the processor 0
 	 *
-	 * \param proc processor id
-	 * \param tag id
-	 * \param v vector to send
+	 * For each category it write the number of values, the percentiles p50, p95, p99 and the counts
+	 * of the buckets (the bucket b > 0 contain the values in [2^(b-1),2^b))
 	 *
-	 * \return true if succeed false otherwise
+	 * \warning it is collective
+	 *
+	 * \param file output file
 	 *
 	 */
-	template<typename T, typename Mem, template<typename> class gr> bool recv(size_t proc, size_t tag, openfpm::vector<T,Mem,gr> & v)
+	void writeHistograms(const std::string & file)
 	{
-#ifdef SE_CLASS1
-			checkType<T>();
-#endif
+		Vcluster_histograms glob;
 
-			// recv over MPI
+		std::vector<size_t> & loc = hist.getData();
+		std::vector<size_t> & all = glob.getData();
 
-			// Create one request
-			req.add();
+		MPI_SAFE_CALL(MPI_Reduce(loc.data(),all.data(),loc.size(),MPI_UNSIGNED_LONG,MPI_SUM,0,ext_comm));
 
-			// receive
-			MPI_IrecvW<T>::recv(proc,SEND_RECV_BASE + tag,v,req.last(),ext_comm);
+		if (m_rank != 0)
+		{return;}
 
-			return true;
+		std::ofstream out(file);
+
+		if (out.is_open() == false)
+		{
+			std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " cannot open " << file << std::endl;
+			return;
+		}
+
+		glob.writeJSON(out);
+		out << "\n";
 	}
 
-	/*! \brief Gather the data from all processors
-	 *
-	 * send a primitive data T receive the same primitive T from all the other processors
-	 *
-	 * \warning operation is asynchronous execute must be called to ensure they are executed
-	 *
-	 * \param v vector to receive (automaticaly resized)
-	 * \param send data to send
+	//! Write the profile, the trace and the histograms if an output has been set (called by openfpm_finalize)
+	void finalizeProfile()
+	{
+		if (prof_file.size() != 0)
+		{writeProfile(prof_file);}
+
+		if (trace_file.size() != 0)
+		{writeTrace(trace_file);}
+
+		if (hist_file.size() != 0)
+		{writeHistograms(hist_file);}
+	}
+
+	/*! \brief Start to record the communication graph
 	 *
-	 * \return true if succeed false otherwise
+	 * The bytes sent to each processor by the point-to-point and the NBX communications are
+	 * accumulated (the previous recording is discarded)
 	 *
 	 */
-	template<typename T, typename Mem, template<typename> class gr> bool allGather(T & send, openfpm::vector<T,Mem,gr> & v)
+	void startGraphRecording()
 	{
-#ifdef SE_CLASS1
-		checkType<T>();
-#endif
-
-		// Create one request
-		req.add();
+		comm_graph.resize(m_size);
 
-		// Number of processors
-		v.resize(getProcessingUnits());
+		for (size_t i = 0 ; i < comm_graph.size() ; i++)
+		{comm_graph.get(i) = 0;}
 
-		// gather
-		MPI_IAllGatherW<T>::gather(&send,1,v.getPointer(),1,req.last(),ext_comm);
+		graph_rec = true;
+	}
 
-		return true;
+	//! Stop to record the communication graph
+	void stopGraphRecording()
+	{
+		graph_rec = false;
 	}
 
-	/*! \brief Broadcast the data to all processors
+	/*! \brief Get the communication graph recorded
 	 *
-	 * broadcast a vector of primitives.
+	 * \return the bytes sent to each processor
 	 *
-	 * \warning operation is asynchronous execute must be called to ensure the operation is executed
+	 */
+	const openfpm::vector<size_t> & getCommGraph()
+	{
+		return comm_graph;
+	}
+
+	/*! \brief Create a communicator where the processors are reordered following the communication graph
 	 *
-	 * \warning the non-root processor must resize the vector to the exact receive size. This mean the
-	 *          each processor must known a priory the receiving size
+	 * The rank i of the new communicator is the task of the processor i of the old one (with its
+	 * communication pattern), placed on a processor such that the heavy edges stay inside a node.
+	 * It is up to the application to move the data of the task i on the processor that has rank i
+	 * in the new communicator
 	 *
-	 * \param v vector to send in the case of the root processor and vector where to receive in the case of
-	 *          non-root
-	 * \param root processor (who broadcast)
+	 * \warning it is collective
 	 *
-	 * \return true if succeed false otherwise
+	 * \param method GRAPH_REORDER_NODE greedy mapping on the nodes (the edges are gathered on the processor 0,
+	 *        so the memory is linear in the number of edges, at most 2^30 edges in total),
+	 *        GRAPH_REORDER_MPI use MPI_Dist_graph_create with reorder (many MPI implementations ignore it)
+	 *
+	 * \return the new communicator (to free with MPI_Comm_free)
 	 *
 	 */
-	template<typename T, typename Mem, template<typename> class layout_base >
-	bool Bcast(openfpm::vector<T,Mem,layout_base> & v, size_t root)
+	MPI_Comm createGraphComm(int method = GRAPH_REORDER_NODE)
 	{
-#ifdef SE_CLASS1
-		checkType<T>();
-#endif
+		if (comm_graph.size() != (size_t)m_size)
+		{startGraphRecording();graph_rec = false;}
 
-		b_cast_helper<openfpm::vect_isel<T>::value == STD_VECTOR || is_layout_mlin<layout_base<T>>::value >::bcast_(req,v,root, ext_comm);
+		MPI_Comm new_comm;
 
-		return true;
+		if (method == GRAPH_REORDER_MPI)
+		{
+			// the weights must be int, they are scaled on the heaviest edge
+			size_t max_w = 0;
+			for (size_t i = 0 ; i < comm_graph.size() ; i++)
+			{max_w = std::max(max_w,comm_graph.get(i));}
+
+			MPI_SAFE_CALL(MPI_Allreduce(MPI_IN_PLACE,&max_w,1,MPI_UNSIGNED_LONG,MPI_MAX,ext_comm));
+
+			openfpm::vector<int> dest;
+			openfpm::vector<int> weights;
+
+			for (size_t i = 0 ; i < comm_graph.size() ; i++)
+			{
+				if (comm_graph.get(i) == 0 || i == (size_t)m_rank)
+				{continue;}
+
+				dest.add(i);
+				weights.add(1 + (int)((double)comm_graph.get(i) / max_w * 1073741823.0));
+			}
+
+			int src = m_rank;
+			int deg = dest.size();
+
+			// the graph is weighted on all the processors, a processor without edges must say it with
+			// MPI_WEIGHTS_EMPTY (an empty vector can give a NULL pointer, that MPI read as unweighted)
+			int * dest_p = (deg == 0)?&src:(int *)dest.getPointer();
+			int * weights_p = (deg == 0)?MPI_WEIGHTS_EMPTY:(int *)weights.getPointer();
+
+			MPI_SAFE_CALL(MPI_Dist_graph_create(ext_comm,1,&src,&deg,dest_p,weights_p,MPI_INFO_NULL,1,&new_comm));
+
+			return new_comm;
+		}
+
+		// node of each processor (the rank of its first processor)
+		MPI_Comm shmcomm;
+		MPI_SAFE_CALL(MPI_Comm_split_type(ext_comm,MPI_COMM_TYPE_SHARED,m_rank,MPI_INFO_NULL,&shmcomm));
+
+		int node = m_rank;
+		MPI_SAFE_CALL(MPI_Allreduce(MPI_IN_PLACE,&node,1,MPI_INT,MPI_MIN,shmcomm));
+		MPI_SAFE_CALL(MPI_Comm_free(&shmcomm));
+
+		// the edges of this processor (destination, bytes)
+		openfpm::vector<size_t> edges;
+
+		for (size_t i = 0 ; i < comm_graph.size() ; i++)
+		{
+			if (comm_graph.get(i) == 0 || i == (size_t)m_rank)
+			{continue;}
+
+			edges.add(i);
+			edges.add(comm_graph.get(i));
+		}
+
+		openfpm::vector<int> node_of;
+		openfpm::vector<int> n_edges;
+		openfpm::vector<int> displ;
+		openfpm::vector<size_t> all_edges;
+		openfpm::vector<int> key;
+
+		if (m_rank == 0)
+		{
+			node_of.resize(m_size);
+			n_edges.resize(m_size);
+			displ.resize(m_size);
+			key.resize(m_size);
+		}
+
+		int n_loc = edges.size();
+
+		MPI_SAFE_CALL(MPI_Gather(&node,1,MPI_INT,node_of.getPointer(),1,MPI_INT,0,ext_comm));
+		MPI_SAFE_CALL(MPI_Gather(&n_loc,1,MPI_INT,n_edges.getPointer(),1,MPI_INT,0,ext_comm));
+
+		if (m_rank == 0)
+		{
+			size_t tot = 0;
+			for (size_t i = 0 ; i < (size_t)m_size ; i++)
+			{
+				displ.get(i) = tot;
+				tot += n_edges.get(i);
+			}
+
+			all_edges.resize(tot);
+		}
+
+		MPI_SAFE_CALL(MPI_Gatherv(edges.getPointer(),n_loc,MPI_UNSIGNED_LONG,all_edges.getPointer(),n_edges.getPointer(),displ.getPointer(),MPI_UNSIGNED_LONG,0,ext_comm));
+
+		if (m_rank == 0)
+		{
+			// symmetric graph, the edge i -> j and j -> i are both counted on i and j
+			std::vector<std::vector<std::pair<size_t,double>>> adj(m_size);
+
+			for (size_t i = 0 ; i < (size_t)m_size ; i++)
+			{
+				for (size_t k = displ.get(i) ; k < (size_t)displ.get(i) + n_edges.get(i) ; k += 2)
+				{
+					size_t j = all_edges.get(k);
+					double w = (double)all_edges.get(k+1);
+
+					adj[i].push_back(std::make_pair(j,w));
+					adj[j].push_back(std::make_pair(i,w));
+				}
+			}
+
+			greedy_node_map(adj,node_of,key);
+		}
+
+		int my_key;
+		MPI_SAFE_CALL(MPI_Scatter(key.getPointer(),1,MPI_INT,&my_key,1,MPI_INT,0,ext_comm));
+
+		MPI_SAFE_CALL(MPI_Comm_split(ext_comm,0,my_key,&new_comm));
+
+		return new_comm;
 	}
 
-	/*! \brief Execute all the requests
+	/*! \brief Enable or disable the fusion of the scalar reductions
+	 *
+	 * When enabled (default) sum(), max() and min() on primitive scalars are queued and
+	 * the ones with the same type and operation are reduced with one collective at execute()
+	 *
+	 * \param fusion true to enable
 	 *
 	 */
-	void execute()
+	void setReductionFusion(bool fusion)
 	{
-		// if req == 0 return
-		if (req.size() == 0)
-			return;
-
-		// Wait for all the requests
-		stat.resize(req.size());
-
-		MPI_SAFE_CALL(MPI_Waitall(req.size(),&req.get(0),&stat.get(0)));
-
-		// Remove executed request and status
-		req.clear();
-		stat.clear();
+		red_fusion = fusion;
 	}
 
 	/*! \brief Release the buffer used for communication
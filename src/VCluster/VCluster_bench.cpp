@@ -0,0 +1,716 @@
+/*
+ * VCluster_bench.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *
+ * Benchmark of the sparse exchanges of Vcluster
+ *
+ * mpirun -np N ./vcluster_bench [--bench=stencil3d,random,all_to_some,gather_scatter] [--min-size=8]
+ *                               [--max-size=1048576] [--step=8] [--iter=100] [--warmup=10] [--k=6]
+ *                               [--seed=1] [--out=file.json]
+ *
+ * For every pattern and message size all the NBX variants and the SSendRecv overloads are measured.
+ * Rank 0 write the message rate, the bandwidth and the percentiles of the latency in JSON
+ *
+ */
+
+#include "config.h"
+#include "VCluster/VCluster.hpp"
+#include <random>
+#include <set>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cmath>
+#include <sstream>
+#include <fstream>
+#include <algorithm>
+
+//! Options of the benchmark
+struct bench_options
+{
+	//! comma separated list of patterns
+	std::string bench = "stencil3d,random,all_to_some,gather_scatter";
+
+	//! smallest message in bytes
+	size_t min_size = 8;
+
+	//! largest message in bytes
+	size_t max_size = 1048576;
+
+	//! the size is multiplied by step at every point
+	size_t step = 8;
+
+	//! measured iterations
+	size_t n_iter = 100;
+
+	//! not measured iterations
+	size_t n_warmup = 10;
+
+	//! out degree of the random graph
+	size_t k = 6;
+
+	//! seed of the random graph
+	size_t seed = 1;
+
+	//! output file (empty for stdout)
+	std::string out;
+};
+
+/*! \brief Communication pattern
+ *
+ * prc_recv is the inverse of prc_send, it is used by the variants that know the receiving processors
+ *
+ */
+struct bench_pattern
+{
+	//! processors to send
+	openfpm::vector<size_t> prc_send;
+
+	//! processors from which we receive
+	openfpm::vector<size_t> prc_recv;
+};
+
+//! Receive buffers of the NBX
+struct bench_recv
+{
+	//! buffers (std::vector move the inner buffers, so the returned pointers remain valid)
+	std::vector<std::vector<char>> buf;
+
+	//! number of received messages
+	size_t n = 0;
+};
+
+/*! \brief Allocate a message of the NBX
+ *
+ * \param msg_i size of the message
+ * \param total_msg total size to receive
+ * \param total_p number of processors to receive
+ * \param i processor sending
+ * \param ri request id
+ * \param tag tag
+ * \param ptr bench_recv
+ *
+ * \return the pointer where to store the message
+ *
+ */
+static void * bench_msg_alloc(size_t msg_i ,size_t total_msg, size_t total_p, size_t i, size_t ri, size_t tag, void * ptr)
+{
+	bench_recv * r = static_cast<bench_recv *>(ptr);
+
+	if (r->n >= r->buf.size())
+	{r->buf.emplace_back();}
+
+	r->buf[r->n].resize(msg_i);
+	return r->buf[r->n++].data();
+}
+
+/*! \brief Parse the command line
+ *
+ * \param argc number of arguments
+ * \param argv arguments
+ * \param opt options
+ *
+ * \return false if there is an unknown argument
+ *
+ */
+static bool bench_parse(int argc, char * argv[], bench_options & opt)
+{
+	for (int i = 1 ; i < argc ; i++)
+	{
+		const char * a = argv[i];
+		const char * eq = strchr(a,'=');
+
+		if (strncmp(a,"--",2) != 0 || eq == NULL)
+		{return false;}
+
+		std::string key(a+2,eq);
+		std::string val(eq+1);
+
+		if (key == "bench")
+		{opt.bench = val;}
+		else if (key == "min-size")
+		{opt.min_size = std::stoul(val);}
+		else if (key == "max-size")
+		{opt.max_size = std::stoul(val);}
+		else if (key == "step")
+		{opt.step = std::stoul(val);}
+		else if (key == "iter")
+		{opt.n_iter = std::stoul(val);}
+		else if (key == "warmup")
+		{opt.n_warmup = std::stoul(val);}
+		else if (key == "k")
+		{opt.k = std::stoul(val);}
+		else if (key == "seed")
+		{opt.seed = std::stoul(val);}
+		else if (key == "out")
+		{opt.out = val;}
+		else
+		{return false;}
+	}
+
+	if (opt.min_size == 0 || opt.step < 2 || opt.n_iter == 0)
+	{return false;}
+
+	return true;
+}
+
+/*! \brief Calculate the processors from which we receive
+ *
+ * \param vcl Vcluster
+ * \param pt pattern with prc_send filled
+ *
+ */
+static void bench_invert(Vcluster<> & vcl, bench_pattern & pt)
+{
+	size_t np = vcl.getProcessingUnits();
+	std::vector<int> out(np,0);
+	std::vector<int> in(np,0);
+
+	for (size_t i = 0 ; i < pt.prc_send.size() ; i++)
+	{out[pt.prc_send.get(i)] = 1;}
+
+	MPI_SAFE_CALL(MPI_Alltoall(out.data(),1,MPI_INT,in.data(),1,MPI_INT,vcl.getMPIComm()));
+
+	pt.prc_recv.clear();
+	for (size_t i = 0 ; i < np ; i++)
+	{
+		if (in[i] == 1)
+		{pt.prc_recv.add(i);}
+	}
+}
+
+/*! \brief 3D nearest neighbour stencil, the processors are on a periodic cartesian grid
+ *
+ * Every processor send to the 26 neighbours (less if the grid is small)
+ *
+ * \param vcl Vcluster
+ * \param pt pattern
+ *
+ */
+static void bench_stencil3d(Vcluster<> & vcl, bench_pattern & pt)
+{
+	int np = vcl.getProcessingUnits();
+	int rank = vcl.getProcessUnitID();
+	int dims[3] = {0,0,0};
+
+	MPI_SAFE_CALL(MPI_Dims_create(np,3,dims));
+
+	int c[3] = {rank % dims[0], (rank / dims[0]) % dims[1], rank / (dims[0]*dims[1])};
+
+	std::set<size_t> nn;
+	for (int i = -1 ; i <= 1 ; i++)
+	{
+		for (int j = -1 ; j <= 1 ; j++)
+		{
+			for (int k = -1 ; k <= 1 ; k++)
+			{
+				int x = (c[0] + i + dims[0]) % dims[0];
+				int y = (c[1] + j + dims[1]) % dims[1];
+				int z = (c[2] + k + dims[2]) % dims[2];
+
+				int p = x + y*dims[0] + z*dims[0]*dims[1];
+
+				if (p != rank)
+				{nn.insert(p);}
+			}
+		}
+	}
+
+	pt.prc_send.clear();
+	for (auto p : nn)
+	{pt.prc_send.add(p);}
+
+	bench_invert(vcl,pt);
+}
+
+/*! \brief Random graph, every processor send to k random processors
+ *
+ * \param vcl Vcluster
+ * \param pt pattern
+ * \param k out degree
+ * \param seed seed
+ *
+ */
+static void bench_random(Vcluster<> & vcl, bench_pattern & pt, size_t k, size_t seed)
+{
+	size_t np = vcl.getProcessingUnits();
+	size_t rank = vcl.getProcessUnitID();
+
+	std::mt19937_64 gen(seed*1000003 + rank);
+	std::uniform_int_distribution<size_t> dist(0,np-1);
+
+	k = std::min(k,np-1);
+
+	std::set<size_t> out;
+	while (out.size() < k)
+	{
+		size_t p = dist(gen);
+
+		if (p != rank)
+		{out.insert(p);}
+	}
+
+	pt.prc_send.clear();
+	for (auto p : out)
+	{pt.prc_send.add(p);}
+
+	bench_invert(vcl,pt);
+}
+
+/*! \brief All to some, every processor send to the first sqrt(np) processors
+ *
+ * \param vcl Vcluster
+ * \param pt pattern
+ *
+ */
+static void bench_all_to_some(Vcluster<> & vcl, bench_pattern & pt)
+{
+	size_t np = vcl.getProcessingUnits();
+	size_t rank = vcl.getProcessUnitID();
+	size_t m = std::max((size_t)1,(size_t)std::sqrt((double)np));
+
+	pt.prc_send.clear();
+	for (size_t i = 0 ; i < m ; i++)
+	{
+		if (i != rank)
+		{pt.prc_send.add(i);}
+	}
+
+	bench_invert(vcl,pt);
+}
+
+/*! \brief Run the benchmarks and collect the results
+ *
+ */
+class bench_runner
+{
+	//! Vcluster
+	Vcluster<> & vcl;
+
+	//! options
+	bench_options & opt;
+
+	//! results (only on rank 0)
+	std::stringstream res;
+
+	//! no result written yet
+	bool first = true;
+
+public:
+
+	/*! \brief Constructor
+	 *
+	 * \param vcl Vcluster
+	 * \param opt options
+	 *
+	 */
+	bench_runner(Vcluster<> & vcl, bench_options & opt)
+	:vcl(vcl),opt(opt)
+	{}
+
+	/*! \brief Measure an exchange
+	 *
+	 * The time of an iteration is the maximum over the processors
+	 *
+	 * \param bench pattern
+	 * \param variant function used
+	 * \param size size of the messages in bytes
+	 * \param n_msg messages sent by this processor in one exchange
+	 * \param n_bytes bytes sent by this processor in one exchange
+	 * \param f exchange
+	 *
+	 */
+	template<typename F> void run(const char * bench, const char * variant, size_t size, size_t n_msg, size_t n_bytes, F f)
+	{
+		MPI_Comm comm = vcl.getMPIComm();
+
+		for (size_t i = 0 ; i < opt.n_warmup ; i++)
+		{f();}
+
+		std::vector<double> t(opt.n_iter);
+		std::vector<double> t_max(opt.n_iter);
+
+		for (size_t i = 0 ; i < opt.n_iter ; i++)
+		{
+			MPI_SAFE_CALL(MPI_Barrier(comm));
+			double t0 = MPI_Wtime();
+			f();
+			t[i] = MPI_Wtime() - t0;
+		}
+
+		unsigned long loc[2] = {n_msg,n_bytes};
+		unsigned long glob[2] = {0,0};
+
+		MPI_SAFE_CALL(MPI_Reduce(t.data(),t_max.data(),opt.n_iter,MPI_DOUBLE,MPI_MAX,0,comm));
+		MPI_SAFE_CALL(MPI_Reduce(loc,glob,2,MPI_UNSIGNED_LONG,MPI_SUM,0,comm));
+
+		if (vcl.getProcessUnitID() != 0)
+		{return;}
+
+		std::sort(t_max.begin(),t_max.end());
+
+		double tot = 0.0;
+		for (size_t i = 0 ; i < t_max.size() ; i++)
+		{tot += t_max[i];}
+
+		// nearest rank percentile
+		auto perc = [&](double p)
+		{
+			size_t r = (size_t)std::ceil(p*t_max.size());
+			return t_max[(r == 0)?0:r-1]*1e6;
+		};
+
+		double rate = (tot != 0.0)?glob[0]*opt.n_iter / tot:0.0;
+		double bw = (tot != 0.0)?glob[1]*opt.n_iter / tot * 1e-9:0.0;
+
+		res << ((first == true)?"\n":",\n") << "{\"bench\":\"" << bench << "\",\"variant\":\"" << variant << "\",\"size\":" << size
+		    << ",\"msgs\":" << glob[0] << ",\"bytes\":" << glob[1] << ",\"msg_rate\":" << rate << ",\"bandwidth_GBs\":" << bw
+		    << ",\"latency_us\":{\"min\":" << t_max.front()*1e6 << ",\"p50\":" << perc(0.5) << ",\"p95\":" << perc(0.95)
+		    << ",\"p99\":" << perc(0.99) << ",\"max\":" << t_max.back()*1e6 << ",\"avg\":" << tot / opt.n_iter * 1e6 << "}}";
+		first = false;
+	}
+
+	/*! \brief Write the results (only rank 0)
+	 *
+	 * \return false if the output file cannot be opened
+	 *
+	 */
+	bool write()
+	{
+		if (vcl.getProcessUnitID() != 0)
+		{return true;}
+
+		std::stringstream out;
+		out << "{\"np\":" << vcl.getProcessingUnits() << ",\"iter\":" << opt.n_iter << ",\"warmup\":" << opt.n_warmup
+		    << ",\"results\":[" << res.str() << "\n]}\n";
+
+		if (opt.out.size() == 0)
+		{
+			std::cout << out.str();
+			return true;
+		}
+
+		std::ofstream f(opt.out);
+		if (f.is_open() == false)
+		{
+			std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " cannot open " << opt.out << std::endl;
+			return false;
+		}
+
+		f << out.str();
+		return true;
+	}
+};
+
+/*! \brief Measure all the NBX variants and the SSendRecv overloads on a pattern
+ *
+ * \param vcl Vcluster
+ * \param br runner
+ * \param name name of the pattern
+ * \param pt pattern
+ * \param size size of the messages in bytes
+ *
+ */
+static void bench_sparse(Vcluster<> & vcl, bench_runner & br, const char * name, bench_pattern & pt, size_t size)
+{
+	size_t n_send = pt.prc_send.size();
+	size_t n_recv = pt.prc_recv.size();
+	size_t n_bytes = n_send * size;
+
+	// raw buffers for the NBX
+
+	std::vector<std::vector<char>> sbuf(n_send,std::vector<char>(size,1));
+	std::vector<size_t> sz(n_send,size);
+	std::vector<size_t> prc(pt.prc_send.getPointer(),pt.prc_send.getPointer() + n_send);
+	std::vector<void *> ptr(n_send);
+	std::vector<size_t> prc_recv(pt.prc_recv.getPointer(),pt.prc_recv.getPointer() + n_recv);
+	std::vector<size_t> sz_recv(n_recv,size);
+
+	for (size_t i = 0 ; i < n_send ; i++)
+	{ptr[i] = sbuf[i].data();}
+
+	bench_recv r;
+
+	br.run(name,"nbx_unknown",size,n_send,n_bytes,[&]()
+	{
+		r.n = 0;
+		vcl.sendrecvMultipleMessagesNBX(n_send,sz.data(),prc.data(),ptr.data(),bench_msg_alloc,&r);
+	});
+
+	br.run(name,"nbx_unknown_async",size,n_send,n_bytes,[&]()
+	{
+		r.n = 0;
+		vcl.sendrecvMultipleMessagesNBXAsync(n_send,sz.data(),prc.data(),ptr.data(),bench_msg_alloc,&r);
+		vcl.sendrecvMultipleMessagesNBXWait();
+	});
+
+	br.run(name,"nbx_known_prc",size,n_send,n_bytes,[&]()
+	{
+		r.n = 0;
+		vcl.sendrecvMultipleMessagesNBX(n_send,sz.data(),prc.data(),ptr.data(),n_recv,prc_recv.data(),bench_msg_alloc,&r);
+	});
+
+	br.run(name,"nbx_known_prc_async",size,n_send,n_bytes,[&]()
+	{
+		r.n = 0;
+		vcl.sendrecvMultipleMessagesNBXAsync(n_send,sz.data(),prc.data(),ptr.data(),n_recv,prc_recv.data(),bench_msg_alloc,&r);
+		vcl.sendrecvMultipleMessagesNBXWait();
+	});
+
+	br.run(name,"nbx_known",size,n_send,n_bytes,[&]()
+	{
+		r.n = 0;
+		vcl.sendrecvMultipleMessagesNBX(n_send,sz.data(),prc.data(),ptr.data(),n_recv,prc_recv.data(),sz_recv.data(),bench_msg_alloc,&r);
+	});
+
+	br.run(name,"nbx_known_async",size,n_send,n_bytes,[&]()
+	{
+		r.n = 0;
+		vcl.sendrecvMultipleMessagesNBXAsync(n_send,sz.data(),prc.data(),ptr.data(),n_recv,prc_recv.data(),sz_recv.data(),bench_msg_alloc,&r);
+		vcl.sendrecvMultipleMessagesNBXWait();
+	});
+
+	// semantic communication, serialized vectors
+
+	size_t n_el = std::max((size_t)1,size / sizeof(size_t));
+	n_bytes = n_send * n_el * sizeof(size_t);
+
+	openfpm::vector<openfpm::vector<size_t>> v1;
+	openfpm::vector<size_t> v2;
+	openfpm::vector<size_t> s_prc_recv;
+	openfpm::vector<size_t> s_sz_recv;
+
+	v1.resize(n_send);
+	for (size_t i = 0 ; i < n_send ; i++)
+	{
+		v1.get(i).resize(n_el);
+		for (size_t j = 0 ; j < n_el ; j++)
+		{v1.get(i).get(j) = j;}
+	}
+
+	br.run(name,"ssendrecv",size,n_send,n_bytes,[&]()
+	{
+		v2.clear();
+		vcl.SSendRecv(v1,v2,pt.prc_send,s_prc_recv,s_sz_recv);
+	});
+
+	br.run(name,"ssendrecv_async",size,n_send,n_bytes,[&]()
+	{
+		v2.clear();
+		vcl.SSendRecvAsync(v1,v2,pt.prc_send,s_prc_recv,s_sz_recv);
+		vcl.SSendRecvWait(v1,v2,pt.prc_send,s_prc_recv,s_sz_recv);
+	});
+
+	openfpm::vector<size_t> k_prc_recv(pt.prc_recv);
+	openfpm::vector<size_t> k_sz_recv;
+	k_sz_recv.resize(n_recv);
+	for (size_t i = 0 ; i < n_recv ; i++)
+	{k_sz_recv.get(i) = n_el;}
+
+	br.run(name,"ssendrecv_known",size,n_send,n_bytes,[&]()
+	{
+		v2.clear();
+		vcl.SSendRecv(v1,v2,pt.prc_send,k_prc_recv,k_sz_recv,RECEIVE_KNOWN | KNOWN_ELEMENT_OR_BYTE);
+	});
+
+	// semantic communication, properties
+
+	typedef aggregate<float,size_t> prop;
+
+	size_t n_prop = std::max((size_t)1,size / (sizeof(float) + sizeof(size_t)));
+	n_bytes = n_send * n_prop * (sizeof(float) + sizeof(size_t));
+
+	openfpm::vector<openfpm::vector<prop>> p1;
+	openfpm::vector<prop> p2;
+	openfpm::vector<size_t> sz_recv_byte;
+
+	p1.resize(n_send);
+	for (size_t i = 0 ; i < n_send ; i++)
+	{
+		p1.get(i).resize(n_prop);
+		for (size_t j = 0 ; j < n_prop ; j++)
+		{
+			p1.get(i).template get<0>(j) = sin(0.01*j);
+			p1.get(i).template get<1>(j) = j;
+		}
+	}
+
+	br.run(name,"ssendrecvp",size,n_send,n_bytes,[&]()
+	{
+		p2.clear();
+		vcl.SSendRecvP<openfpm::vector<prop>,decltype(p2),memory_traits_lin,0,1>(p1,p2,pt.prc_send,s_prc_recv,s_sz_recv,sz_recv_byte);
+	});
+
+	br.run(name,"ssendrecvp_async",size,n_send,n_bytes,[&]()
+	{
+		p2.clear();
+		vcl.SSendRecvPAsync<openfpm::vector<prop>,decltype(p2),memory_traits_lin,0,1>(p1,p2,pt.prc_send,s_prc_recv,s_sz_recv,sz_recv_byte);
+		vcl.SSendRecvPWait<openfpm::vector<prop>,decltype(p2),memory_traits_lin,0,1>(p1,p2,pt.prc_send,s_prc_recv,s_sz_recv,sz_recv_byte);
+	});
+
+	openfpm::vector<double> err_bound;
+	err_bound.add(1e-3);
+	err_bound.add(0.0);
+
+	br.run(name,"ssendrecvp_lossy",size,n_send,n_bytes,[&]()
+	{
+		p2.clear();
+		vcl.SSendRecvP<openfpm::vector<prop>,decltype(p2),memory_traits_lin,0,1>(p1,p2,pt.prc_send,s_prc_recv,s_sz_recv,err_bound);
+	});
+
+	// the data does not change, after the first exchange only the deltas are sent
+	Vcluster_delta delta;
+
+	br.run(name,"ssendrecvp_delta",size,n_send,n_bytes,[&]()
+	{
+		p2.clear();
+		vcl.SSendRecvP<openfpm::vector<prop>,decltype(p2),memory_traits_lin,0,1>(p1,p2,pt.prc_send,s_prc_recv,s_sz_recv,delta);
+	});
+
+	op_ssend_recv_add<void> opa;
+
+	br.run(name,"ssendrecvp_op",size,n_send,n_bytes,[&]()
+	{
+		p2.clear();
+		vcl.SSendRecvP_op<op_ssend_recv_add<void>,openfpm::vector<prop>,decltype(p2),memory_traits_lin,0,1>(p1,p2,pt.prc_send,opa,s_prc_recv,s_sz_recv);
+	});
+
+	br.run(name,"ssendrecvp_op_async",size,n_send,n_bytes,[&]()
+	{
+		p2.clear();
+		vcl.SSendRecvP_opAsync<op_ssend_recv_add<void>,openfpm::vector<prop>,decltype(p2),memory_traits_lin,0,1>(p1,p2,pt.prc_send,opa,s_prc_recv,s_sz_recv);
+		vcl.SSendRecvP_opWait<op_ssend_recv_add<void>,openfpm::vector<prop>,decltype(p2),memory_traits_lin,0,1>(p1,p2,pt.prc_send,opa,s_prc_recv,s_sz_recv);
+	});
+}
+
+/*! \brief Measure gather, scatter and broadcast to and from the processor 0
+ *
+ * \param vcl Vcluster
+ * \param br runner
+ * \param size size of the chunk of every processor in bytes
+ *
+ */
+static void bench_gather_scatter(Vcluster<> & vcl, bench_runner & br, size_t size)
+{
+	size_t np = vcl.getProcessingUnits();
+	bool root = (vcl.getProcessUnitID() == 0);
+
+	size_t n_el = std::max((size_t)1,size / sizeof(size_t));
+	size_t bytes = n_el * sizeof(size_t);
+
+	openfpm::vector<size_t> v1;
+	openfpm::vector<size_t> v2;
+
+	// gather
+
+	v1.resize(n_el);
+	for (size_t i = 0 ; i < n_el ; i++)
+	{v1.get(i) = i;}
+
+	br.run("gather_scatter","sgather",size,(root == true)?0:1,(root == true)?0:bytes,[&]()
+	{
+		v2.clear();
+		vcl.SGather(v1,v2,0);
+	});
+
+	br.run("gather_scatter","sgather_tree",size,(root == true)?0:1,(root == true)?0:bytes,[&]()
+	{
+		v2.clear();
+		vcl.SGather(v1,v2,0,GATHER_TREE);
+	});
+
+	// scatter
+
+	openfpm::vector<size_t> prc;
+	openfpm::vector<size_t> sz;
+
+	for (size_t i = 0 ; i < np ; i++)
+	{
+		prc.add(i);
+		sz.add(n_el);
+	}
+
+	v1.resize((root == true)?np*n_el:0);
+	for (size_t i = 0 ; i < v1.size() ; i++)
+	{v1.get(i) = i;}
+
+	br.run("gather_scatter","sscatter",size,(root == true)?np-1:0,(root == true)?(np-1)*bytes:0,[&]()
+	{
+		v2.clear();
+		vcl.SScatter(v1,v2,prc,sz,0);
+	});
+
+	br.run("gather_scatter","sscatter_tree",size,(root == true)?np-1:0,(root == true)?(np-1)*bytes:0,[&]()
+	{
+		v2.clear();
+		vcl.SScatter(v1,v2,prc,sz,0,SCATTER_TREE);
+	});
+
+	// broadcast
+
+	v2.resize(n_el);
+
+	br.run("gather_scatter","sbcast",size,(root == true)?np-1:0,(root == true)?(np-1)*bytes:0,[&]()
+	{
+		vcl.SBcast(v2,0);
+	});
+}
+
+int main(int argc, char* argv[])
+{
+	openfpm_init(&argc,&argv);
+
+	Vcluster<> & vcl = create_vcluster();
+
+	bench_options opt;
+	if (bench_parse(argc,argv,opt) == false)
+	{
+		if (vcl.getProcessUnitID() == 0)
+		{
+			std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " usage: " << argv[0]
+			          << " [--bench=stencil3d,random,all_to_some,gather_scatter] [--min-size=8] [--max-size=1048576] [--step=8]"
+			          << " [--iter=100] [--warmup=10] [--k=6] [--seed=1] [--out=file.json]" << std::endl;
+		}
+
+		openfpm_finalize();
+		return 1;
+	}
+
+	std::set<std::string> benchs;
+	std::stringstream ss(opt.bench);
+	std::string b;
+	while (std::getline(ss,b,','))
+	{benchs.insert(b);}
+
+	bench_runner br(vcl,opt);
+
+	bench_pattern stencil;
+	bench_pattern rnd;
+	bench_pattern a2s;
+
+	bench_stencil3d(vcl,stencil);
+	bench_random(vcl,rnd,opt.k,opt.seed);
+	bench_all_to_some(vcl,a2s);
+
+	for (size_t size = opt.min_size ; size <= opt.max_size ; size *= opt.step)
+	{
+		if (benchs.count("stencil3d") != 0)
+		{bench_sparse(vcl,br,"stencil3d",stencil,size);}
+
+		if (benchs.count("random") != 0)
+		{bench_sparse(vcl,br,"random",rnd,size);}
+
+		if (benchs.count("all_to_some") != 0)
+		{bench_sparse(vcl,br,"all_to_some",a2s,size);}
+
+		if (benchs.count("gather_scatter") != 0)
+		{bench_gather_scatter(vcl,br,size);}
+	}
+
+	bool ok = br.write();
+
+	openfpm_finalize();
+
+	return (ok == true)?0:1;
+}
@@ -10,6 +10,7 @@
 
 #include "memory/BHeapMemory.hpp"
 #include "Packer_Unpacker/has_max_prop.hpp"
+#include "util/Vcluster_lossy.hpp"
 
 /*! \brief Return true is MPI is compiled with CUDA
  *
@@ -537,6 +538,129 @@ struct pack_unpack_cond_with_prp
 };
 
 
+/*! \brief Type of a field for lossy compression
+ *
+ * \tparam T base type of the field
+ *
+ */
+template<typename T>
+struct lossy_field_type
+{
+	//! floating point fields can be compressed
+	static const unsigned int value = std::is_same<T,float>::value?VCL_LOSSY_FLOAT:(std::is_same<T,double>::value?VCL_LOSSY_DOUBLE:VCL_LOSSY_RAW);
+};
+
+/*! \brief this class is a functor for "for_each" algorithm
+ *
+ * For each property of the element it add the fields description for lossy compression,
+ * a property like float[3] produce 3 fields
+ *
+ * \tparam Ele element (boost::fusion vector)
+ * \tparam Agg aggregate type
+ *
+ */
+template<typename Ele, typename Agg>
+struct lossy_field_for_each_prop
+{
+	//! fields
+	std::vector<vcl_lossy_field> & fields;
+
+	//! error bound for each property
+	const openfpm::vector<double> & eb;
+
+	//! element used to calculate the offsets
+	Ele & ele;
+
+	/*! \brief constructor
+	 *
+	 * \param fields fields to fill
+	 * \param eb error bound for each property
+	 * \param ele element used to calculate the offsets
+	 *
+	 */
+	inline lossy_field_for_each_prop(std::vector<vcl_lossy_field> & fields, const openfpm::vector<double> & eb, Ele & ele)
+	:fields(fields),eb(eb),ele(ele)
+	{};
+
+	//! It add the fields for each property
+	template<typename T>
+	inline void operator()(T& t) const
+	{
+		typedef typename boost::mpl::at<typename Agg::type,T>::type prp_type;
+		typedef typename std::remove_all_extents<prp_type>::type base_type;
+
+		size_t off = (const char *)&boost::fusion::at_c<T::value>(ele) - (const char *)&ele;
+		double e = (T::value < eb.size())?eb.get(T::value):0.0;
+
+		if (lossy_field_type<base_type>::value == VCL_LOSSY_RAW)
+		{
+			fields.push_back({off,sizeof(prp_type),VCL_LOSSY_RAW,0.0});
+			return;
+		}
+
+		for (size_t c = 0 ; c < sizeof(prp_type) / sizeof(base_type) ; c++)
+		{fields.push_back({off + c*sizeof(base_type),sizeof(base_type),lossy_field_type<base_type>::value,e});}
+	}
+};
+
+//! Construct the fields of an aggregate
+template<typename V, bool is_fundamental = std::is_fundamental<V>::value>
+struct lossy_fields_ele
+{
+	static void fields(std::vector<vcl_lossy_field> & fields, const openfpm::vector<double> & eb)
+	{
+		typename V::type ele;
+
+		lossy_field_for_each_prop<typename V::type,V> lf(fields,eb,ele);
+
+		boost::mpl::for_each_ref<boost::mpl::range_c<int,0,V::max_prop>>(lf);
+	}
+};
+
+//! Construct the fields of a primitive
+template<typename V>
+struct lossy_fields_ele<V,true>
+{
+	static void fields(std::vector<vcl_lossy_field> & fields, const openfpm::vector<double> & eb)
+	{
+		double e = (eb.size() != 0)?eb.get(0):0.0;
+
+		fields.push_back({0,sizeof(V),lossy_field_type<V>::value,e});
+	}
+};
+
+/*! \brief Construct the description of the element for lossy compression
+ *
+ * Lossy compression is supported only for vectors of POD elements with linear layout
+ * (the element is sent as it is, without serialization)
+ *
+ */
+template<typename T,
+         template<typename> class layout_base,
+         bool impl = has_pack_gen<typename T::value_type>::value == false && is_vector<T>::value == true && is_layout_mlin<layout_base<dummy_type>>::value>
+struct lossy_encode_selector
+{
+	static bool fields(std::vector<vcl_lossy_field> & fields, const openfpm::vector<double> & eb, size_t & ele_size)
+	{
+#ifndef DISABLE_ALL_RTTI
+		std::cerr << __FILE__ << ":" << __LINE__ << " Error the type " << demangle(typeid(T).name()) << " does not support lossy compression, data are sent lossless" << std::endl;
+#endif
+		return false;
+	}
+};
+
+template<typename T, template<typename> class layout_base>
+struct lossy_encode_selector<T,layout_base,true>
+{
+	static bool fields(std::vector<vcl_lossy_field> & fields, const openfpm::vector<double> & eb, size_t & ele_size)
+	{
+		lossy_fields_ele<typename T::value_type>::fields(fields,eb);
+		ele_size = sizeof(typename T::value_type);
+
+		return true;
+	}
+};
+
 /////////////////////////////
 
 //! Helper class to add data without serialization
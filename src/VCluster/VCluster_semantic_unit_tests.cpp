@@ -498,6 +498,76 @@ BOOST_AUTO_TEST_CASE (Vcluster_semantic_gather_8)
 	}
 }
 
+BOOST_AUTO_TEST_CASE (Vcluster_semantic_gather_tree)
+{
+	for (size_t i = 0 ; i < 10 ; i++)
+	{
+		Vcluster<> & vcl = create_vcluster();
+
+		if (vcl.getProcessingUnits() >= 32)
+		{return;}
+
+		size_t np = vcl.getProcessingUnits();
+		size_t root = i % np;
+
+		// the processor p send p % 3 elements
+		openfpm::vector<size_t> v1;
+		for (size_t j = 0 ; j < vcl.getProcessUnitID() % 3 ; j++)
+		{v1.add(vcl.getProcessUnitID());}
+
+		// serialized objects
+		openfpm::vector<openfpm::vector<size_t>> v3;
+		v3.resize(vcl.getProcessUnitID() + 1);
+		for (size_t j = 0 ; j < v3.size() ; j++)
+		{v3.get(j).add(vcl.getProcessUnitID());}
+
+		openfpm::vector<size_t> v2;
+		openfpm::vector<openfpm::vector<size_t>> v4;
+		openfpm::vector<size_t> prc;
+		openfpm::vector<size_t> sz;
+
+		vcl.SGather(v1,v2,prc,sz,root,GATHER_TREE);
+		vcl.SGather(v3,v4,root,GATHER_TREE);
+
+		if (vcl.getProcessUnitID() == root)
+		{
+			bool match = true;
+			size_t s = 0;
+			for (size_t k = 0 ; k < prc.size() ; k++)
+			{
+				match &= sz.get(k) == prc.get(k) % 3;
+
+				for (size_t j = 0 ; j < sz.get(k) ; j++)
+				{match &= v2.get(s+j) == prc.get(k);}
+
+				s += sz.get(k);
+			}
+
+			BOOST_REQUIRE_EQUAL(v2.size(),s);
+			BOOST_REQUIRE_EQUAL(prc.last(),root);
+			BOOST_REQUIRE_EQUAL(v4.size(),np*(np+1)/2);
+
+			// the data of root are at the end
+			s = 0;
+			for (size_t p = 0 ; p < np ; p++)
+			{
+				if (p == root)
+				{continue;}
+
+				for (size_t j = 0 ; j < p + 1 ; j++)
+				{match &= v4.get(s+j).get(0) == p;}
+
+				s += p + 1;
+			}
+
+			for (size_t j = 0 ; j < root + 1 ; j++)
+			{match &= v4.get(s+j).get(0) == root;}
+
+			BOOST_REQUIRE_EQUAL(match,true);
+		}
+	}
+}
+
 BOOST_AUTO_TEST_CASE (Vcluster_semantic_struct_gather)
 {
 	for (size_t i = 0 ; i < 100 ; i++)
@@ -648,6 +718,116 @@ BOOST_AUTO_TEST_CASE (Vcluster_semantic_struct_scatter)
 	}
 }
 
+BOOST_AUTO_TEST_CASE (Vcluster_semantic_scatter_tree)
+{
+	for (size_t i = 0 ; i < 10 ; i++)
+	{
+		Vcluster<> & vcl = create_vcluster();
+
+		if (vcl.getProcessingUnits() >= 32)
+		{return;}
+
+		size_t np = vcl.getProcessingUnits();
+		size_t root = i % np;
+
+		// the processor p receive p % 3 elements
+		openfpm::vector<size_t> v1;
+		openfpm::vector<openfpm::vector<size_t>> v3;
+		openfpm::vector<size_t> prc;
+		openfpm::vector<size_t> sz;
+
+		for (size_t p = 0 ; p < np ; p++)
+		{
+			for (size_t j = 0 ; j < p % 3 ; j++)
+			{
+				v1.add(p);
+				v3.add();
+				v3.last().add(p);
+			}
+
+			prc.add(p);
+			sz.add(p % 3);
+		}
+
+		openfpm::vector<size_t> v2;
+		openfpm::vector<openfpm::vector<size_t>> v4;
+		openfpm::vector<openfpm::vector<size_t>> v5;
+
+		vcl.SScatter(v1,v2,prc,sz,root,SCATTER_TREE);
+		vcl.SScatter(v3,v4,prc,sz,root);
+		vcl.SScatter(v3,v5,prc,sz,root,SCATTER_TREE);
+
+		size_t rank = vcl.getProcessUnitID();
+
+		BOOST_REQUIRE_EQUAL(v2.size(),rank % 3);
+		BOOST_REQUIRE_EQUAL(v4.size(),rank % 3);
+		BOOST_REQUIRE_EQUAL(v5.size(),rank % 3);
+
+		bool match = true;
+		for (size_t j = 0 ; j < v2.size() ; j++)
+		{
+			match &= v2.get(j) == rank;
+			match &= v4.get(j).size() == 1 && v4.get(j).get(0) == rank;
+			match &= v5.get(j).size() == 1 && v5.get(j).get(0) == rank;
+		}
+
+		BOOST_REQUIRE_EQUAL(match,true);
+	}
+}
+
+BOOST_AUTO_TEST_CASE (Vcluster_semantic_bcast)
+{
+	for (size_t i = 0 ; i < 10 ; i++)
+	{
+		Vcluster<> & vcl = create_vcluster();
+
+		if (vcl.getProcessingUnits() >= 32)
+		{return;}
+
+		size_t np = vcl.getProcessingUnits();
+		size_t root = i % np;
+		size_t rank = vcl.getProcessUnitID();
+
+		// small segments to test the pipeline
+		vcl.setBcastChunkSize((i % 2 == 0)?1048576:100);
+
+		openfpm::vector<size_t> v1;
+		openfpm::vector<openfpm::vector<size_t>> v2;
+
+		if (rank == root)
+		{
+			for (size_t j = 0 ; j < 1000*i ; j++)
+			{
+				v1.add(j + root);
+				v2.add();
+				v2.last().add(j);
+				v2.last().add(root);
+			}
+		}
+		else
+		{
+			// garbage that must be replaced
+			v1.add(7);
+			v2.add();
+		}
+
+		vcl.SBcast(v1,root);
+		vcl.SBcast(v2,root);
+
+		BOOST_REQUIRE_EQUAL(v1.size(),1000*i);
+		BOOST_REQUIRE_EQUAL(v2.size(),1000*i);
+
+		bool match = true;
+		for (size_t j = 0 ; j < v1.size() ; j++)
+		{
+			match &= v1.get(j) == j + root;
+			match &= v2.get(j).size() == 2 && v2.get(j).get(0) == j && v2.get(j).get(1) == root;
+		}
+
+		BOOST_REQUIRE_EQUAL(match,true);
+	}
+}
+
 template<unsigned int impl, typename VCluster_type, typename vector1, typename vector2, typename vector3>
 void scomm_unknown(VCluster_type & vcl, vector1 & v1, vector2 & v2, vector3 & prc_send, vector3 & prc_recv, vector3 & sz_recv)
 {
@@ -1919,5 +2099,416 @@ BOOST_AUTO_TEST_CASE (Vcluster_semantic_sendrecv_6_async)
 	Vcluster_semantic_sendrecv_6_impl<NBX_ASYNC>();
 }
 
+BOOST_AUTO_TEST_CASE (Vcluster_semantic_sendrecv_self)
+{
+	Vcluster<> & vcl = create_vcluster();
+
+	if (vcl.getProcessingUnits() >= 32)
+		return;
+
+	size_t np = vcl.getProcessingUnits();
+	size_t rank = vcl.getProcessUnitID();
+
+	openfpm::vector<size_t> prc_recv;
+	openfpm::vector<size_t> prc_send;
+	openfpm::vector<size_t> sz_recv;
+
+	// two messages to itself (copied without MPI) and one to the next processor
+	openfpm::vector<openfpm::vector<size_t>> v1;
+	openfpm::vector<size_t> v2;
+
+	v1.resize(3);
+	prc_send.add(rank);
+	prc_send.add((rank+1)%np);
+	prc_send.add(rank);
+
+	for (size_t i = 0 ; i < v1.size() ; i++)
+	{
+		for (size_t j = 0 ; j < 100 ; j++)
+		{v1.get(i).add(rank*1000 + i*100 + j);}
+	}
+
+	vcl.SSendRecv(v1,v2,prc_send,prc_recv,sz_recv);
+
+	BOOST_REQUIRE_EQUAL(v2.size(),300ul);
+
+	// the messages are ordered by processor and, for the same processor, in the order they are sent
+	openfpm::vector<size_t> check;
+	size_t prev = (rank+np-1)%np;
+
+	if (np == 1)
+	{
+		for (size_t i = 0 ; i < 3 ; i++)
+		{
+			for (size_t j = 0 ; j < 100 ; j++)
+			{check.add(i*100 + j);}
+		}
+	}
+	else
+	{
+		for (size_t k = 0 ; k < 2 ; k++)
+		{
+			// the previous processor send the message 1, this processor the 0 and 2
+			size_t p = (k == 0)?std::min(rank,prev):std::max(rank,prev);
+
+			if (p == rank)
+			{
+				for (size_t j = 0 ; j < 100 ; j++)
+				{check.add(rank*1000 + j);}
+				for (size_t j = 0 ; j < 100 ; j++)
+				{check.add(rank*1000 + 200 + j);}
+			}
+			else
+			{
+				for (size_t j = 0 ; j < 100 ; j++)
+				{check.add(prev*1000 + 100 + j);}
+			}
+		}
+	}
+
+	bool match = true;
+	for (size_t i = 0 ; i < v2.size() ; i++)
+	{match &= v2.get(i) == check.get(i);}
+
+	BOOST_REQUIRE_EQUAL(match,true);
+}
+
+BOOST_AUTO_TEST_CASE (Vcluster_semantic_sendrecv_compress)
+{
+	Vcluster<> & vcl = create_vcluster();
+
+	if (vcl.getProcessingUnits() >= 32)
+		return;
+
+	vcl.setCompressionParameters(1024,sizeof(double));
+	vcl.resetCompressionStats();
+
+	openfpm::vector<size_t> prc_recv;
+	openfpm::vector<size_t> prc_send;
+	openfpm::vector<size_t> sz_recv;
+
+	openfpm::vector<openfpm::vector<double>> v1;
+	openfpm::vector<double> v2;
+
+	v1.resize(vcl.getProcessingUnits());
+
+	// smooth field, compress well after byte shuffling
+	for (size_t i = 0 ; i < v1.size() ; i++)
+	{
+		for (size_t j = 0 ; j < 4096 ; j++)
+		{v1.get(i).add(1.0 + 0.001*vcl.getProcessUnitID() + 1e-6*j);}
+
+		prc_send.add(i);
+	}
+
+	vcl.SSendRecv(v1,v2,prc_send,prc_recv,sz_recv,MPI_COMPRESS);
+
+	BOOST_REQUIRE_EQUAL(v2.size(),4096*vcl.getProcessingUnits());
+	BOOST_REQUIRE_EQUAL(prc_recv.size(),vcl.getProcessingUnits());
+
+	bool match = true;
+	size_t s = 0;
+	for (size_t i = 0 ; i < prc_recv.size() ; i++)
+	{
+		for (size_t j = 0 ; j < sz_recv.get(i) ; j++)
+		{match &= (v2.get(s+j) == 1.0 + 0.001*prc_recv.get(i) + 1e-6*j);}
+
+		s += sz_recv.get(i);
+	}
+
+	BOOST_REQUIRE_EQUAL(match,true);
+
+	auto & stats = vcl.getCompressionStats();
+
+	BOOST_REQUIRE_EQUAL(stats.last.raw_sent,4096*sizeof(double)*vcl.getProcessingUnits());
+	BOOST_REQUIRE_EQUAL(stats.last.raw_recv,4096*sizeof(double)*vcl.getProcessingUnits());
+	BOOST_REQUIRE(stats.last.ratio() > 1.0);
+}
+
+BOOST_AUTO_TEST_CASE (Vcluster_semantic_sendrecv_lossy)
+{
+	Vcluster<> & vcl = create_vcluster();
+
+	if (vcl.getProcessingUnits() >= 32)
+		return;
+
+	openfpm::vector<size_t> prc_recv;
+	openfpm::vector<size_t> prc_send;
+	openfpm::vector<size_t> sz_recv;
+
+	openfpm::vector<openfpm::vector<aggregate<float,double[3],int>>> v1;
+	openfpm::vector<aggregate<float,double[3],int>> v2;
+
+	v1.resize(vcl.getProcessingUnits());
+
+	for (size_t i = 0 ; i < v1.size() ; i++)
+	{
+		v1.get(i).resize(1000);
+
+		for (size_t j = 0 ; j < v1.get(i).size() ; j++)
+		{
+			v1.get(i).template get<0>(j) = sin(0.01*j);
+			v1.get(i).template get<1>(j)[0] = cos(0.001*j) + vcl.getProcessUnitID();
+			v1.get(i).template get<1>(j)[1] = 1e5*j;
+			v1.get(i).template get<1>(j)[2] = 0.1*j;
+			v1.get(i).template get<2>(j) = vcl.getProcessUnitID()*1000 + j;
+		}
+
+		prc_send.add(i);
+	}
+
+	// float with 1e-3 error, double with 1e-6 error, the integer is lossless
+	openfpm::vector<double> err_bound;
+	err_bound.add(1e-3);
+	err_bound.add(1e-6);
+	err_bound.add(0.0);
+
+	vcl.SSendRecvP<openfpm::vector<aggregate<float,double[3],int>>,decltype(v2),memory_traits_lin,0,1,2>(v1,v2,prc_send,prc_recv,sz_recv,err_bound);
+
+	BOOST_REQUIRE_EQUAL(v2.size(),1000*vcl.getProcessingUnits());
+
+	bool match = true;
+	size_t s = 0;
+	for (size_t i = 0 ; i < prc_recv.size() ; i++)
+	{
+		for (size_t j = 0 ; j < sz_recv.get(i) ; j++)
+		{
+			match &= fabs(v2.template get<0>(s+j) - (float)sin(0.01*j)) <= 1e-3;
+			match &= fabs(v2.template get<1>(s+j)[0] - (cos(0.001*j) + prc_recv.get(i))) <= 1e-6;
+			match &= fabs(v2.template get<1>(s+j)[1] - 1e5*j) <= 1e-6;
+			match &= fabs(v2.template get<1>(s+j)[2] - 0.1*j) <= 1e-6;
+			match &= v2.template get<2>(s+j) == (int)(prc_recv.get(i)*1000 + j);
+		}
+
+		s += sz_recv.get(i);
+	}
+
+	BOOST_REQUIRE_EQUAL(match,true);
+}
+
+BOOST_AUTO_TEST_CASE (Vcluster_semantic_sendrecv_delta)
+{
+	Vcluster<> & vcl = create_vcluster();
+
+	if (vcl.getProcessingUnits() >= 32)
+		return;
+
+	Vcluster_delta delta;
+
+	openfpm::vector<openfpm::vector<aggregate<double,size_t>>> v1;
+	openfpm::vector<size_t> prc_send;
+
+	v1.resize(vcl.getProcessingUnits());
+
+	for (size_t i = 0 ; i < v1.size() ; i++)
+	{
+		v1.get(i).resize(1000);
+
+		for (size_t j = 0 ; j < v1.get(i).size() ; j++)
+		{
+			v1.get(i).template get<0>(j) = j;
+			v1.get(i).template get<1>(j) = vcl.getProcessUnitID();
+		}
+
+		prc_send.add(i);
+	}
+
+	for (size_t k = 0 ; k < 4 ; k++)
+	{
+		openfpm::vector<size_t> prc_recv;
+		openfpm::vector<size_t> sz_recv;
+		openfpm::vector<aggregate<double,size_t>> v2;
+
+		// change few elements
+		for (size_t i = 0 ; i < v1.size() ; i++)
+		{v1.get(i).template get<0>(k*100) = -1.0*k;}
+
+		vcl.SSendRecvP<openfpm::vector<aggregate<double,size_t>>,decltype(v2),memory_traits_lin,0,1>(v1,v2,prc_send,prc_recv,sz_recv,delta);
+
+		BOOST_REQUIRE_EQUAL(v2.size(),1000*vcl.getProcessingUnits());
+
+		bool match = true;
+		size_t s = 0;
+		for (size_t i = 0 ; i < prc_recv.size() ; i++)
+		{
+			for (size_t j = 0 ; j < sz_recv.get(i) ; j++)
+			{
+				double val = (j % 100 == 0 && j / 100 <= k)?-1.0*(j/100):j;
+
+				match &= v2.template get<0>(s+j) == val;
+				match &= v2.template get<1>(s+j) == prc_recv.get(i);
+			}
+
+			s += sz_recv.get(i);
+		}
+
+		BOOST_REQUIRE_EQUAL(match,true);
+	}
+
+	BOOST_REQUIRE(delta.getSentRatio() < 0.5);
+}
+
+BOOST_AUTO_TEST_CASE (Vcluster_semantic_alltoall)
+{
+	Vcluster<> & vcl = create_vcluster();
+
+	if (vcl.getProcessingUnits() >= 32)
+		return;
+
+	size_t np = vcl.getProcessingUnits();
+	size_t rank = vcl.getProcessUnitID();
+
+	// vectors of aggregates (the message to the processor i has (rank + i) % 3 elements)
+	openfpm::vector<openfpm::vector<aggregate<double,size_t>>> v1;
+	v1.resize(np);
+
+	for (size_t i = 0 ; i < np ; i++)
+	{
+		for (size_t j = 0 ; j < (rank + i) % 3 ; j++)
+		{
+			v1.get(i).add();
+			v1.get(i).template get<0>(j) = i;
+			v1.get(i).template get<1>(j) = rank;
+		}
+	}
+
+	openfpm::vector<aggregate<double,size_t>> v2;
+	openfpm::vector<size_t> prc_recv;
+	openfpm::vector<size_t> sz_recv;
+
+	vcl.SAlltoall(v1,v2,prc_recv,sz_recv);
+
+	bool match = true;
+	size_t s = 0;
+	size_t p = 0;
+	for (size_t i = 0 ; i < np ; i++)
+	{
+		if ((rank + i) % 3 == 0)
+		{continue;}
+
+		match &= prc_recv.get(p) == i;
+		match &= sz_recv.get(p) == (rank + i) % 3;
+
+		for (size_t j = 0 ; j < sz_recv.get(p) ; j++)
+		{
+			match &= v2.template get<0>(s+j) == rank;
+			match &= v2.template get<1>(s+j) == i;
+		}
+
+		s += sz_recv.get(p);
+		p++;
+	}
+
+	BOOST_REQUIRE_EQUAL(prc_recv.size(),p);
+	BOOST_REQUIRE_EQUAL(v2.size(),s);
+	BOOST_REQUIRE_EQUAL(match,true);
+
+	// serialized objects
+	openfpm::vector<openfpm::vector<openfpm::vector<size_t>>> v3;
+	v3.resize(np);
+
+	for (size_t i = 0 ; i < np ; i++)
+	{
+		v3.get(i).resize(i+1);
+		for (size_t j = 0 ; j < v3.get(i).size() ; j++)
+		{v3.get(i).get(j).add(rank);}
+	}
+
+	openfpm::vector<openfpm::vector<size_t>> v4;
+
+	vcl.SAlltoall(v3,v4,prc_recv,sz_recv);
+
+	BOOST_REQUIRE_EQUAL(prc_recv.size(),np);
+	BOOST_REQUIRE_EQUAL(v4.size(),np*(rank+1));
+
+	match = true;
+	for (size_t i = 0 ; i < v4.size() ; i++)
+	{
+		match &= v4.get(i).size() == 1;
+		match &= v4.get(i).get(0) == i / (rank + 1);
+	}
+
+	BOOST_REQUIRE_EQUAL(match,true);
+}
+
+BOOST_AUTO_TEST_CASE (Vcluster_semantic_allgather)
+{
+	Vcluster<> & vcl = create_vcluster();
+
+	if (vcl.getProcessingUnits() >= 32)
+		return;
+
+	size_t np = vcl.getProcessingUnits();
+	size_t rank = vcl.getProcessUnitID();
+
+	// the processor i send i % 3 elements
+	openfpm::vector<aggregate<double,size_t>> v1;
+
+	for (size_t j = 0 ; j < rank % 3 ; j++)
+	{
+		v1.add();
+		v1.template get<0>(j) = j;
+		v1.template get<1>(j) = rank;
+	}
+
+	openfpm::vector<aggregate<double,size_t>> v2;
+	openfpm::vector<size_t> prc;
+	openfpm::vector<size_t> sz;
+
+	vcl.SAllGather(v1,v2,prc,sz);
+
+	bool match = true;
+	size_t s = 0;
+	size_t p = 0;
+	for (size_t i = 0 ; i < np ; i++)
+	{
+		if (i % 3 == 0)
+		{continue;}
+
+		match &= prc.get(p) == i;
+		match &= sz.get(p) == i % 3;
+
+		for (size_t j = 0 ; j < sz.get(p) ; j++)
+		{
+			match &= v2.template get<0>(s+j) == j;
+			match &= v2.template get<1>(s+j) == i;
+		}
+
+		s += sz.get(p);
+		p++;
+	}
+
+	BOOST_REQUIRE_EQUAL(prc.size(),p);
+	BOOST_REQUIRE_EQUAL(v2.size(),s);
+	BOOST_REQUIRE_EQUAL(match,true);
+
+	// serialized objects
+	openfpm::vector<openfpm::vector<size_t>> v3;
+	v3.resize(rank+1);
+
+	for (size_t j = 0 ; j < v3.size() ; j++)
+	{v3.get(j).add(rank);}
+
+	openfpm::vector<openfpm::vector<size_t>> v4;
+
+	vcl.SAllGather(v3,v4);
+
+	BOOST_REQUIRE_EQUAL(v4.size(),np*(np+1)/2);
+
+	match = true;
+	s = 0;
+	for (size_t i = 0 ; i < np ; i++)
+	{
+		for (size_t j = 0 ; j < i + 1 ; j++)
+		{
+			match &= v4.get(s).size() == 1;
+			match &= v4.get(s).get(0) == i;
+			s++;
+		}
+	}
+
+	BOOST_REQUIRE_EQUAL(match,true);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
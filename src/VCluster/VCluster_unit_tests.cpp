@@ -10,6 +10,7 @@
 #include <boost/test/unit_test.hpp>
 #include "timer.hpp"
 #include <random>
+#include <thread>
 #include "VCluster_unit_test_util.hpp"
 #include "Point_test.hpp"
 #include "VCluster_base.hpp"
@@ -113,6 +114,244 @@ BOOST_AUTO_TEST_CASE( VCluster_use_reductions)
 	BOOST_REQUIRE_EQUAL(d_max,(double)vcl.getProcessingUnits()-1);
 }
 
+BOOST_AUTO_TEST_CASE( VCluster_fused_reductions)
+{
+	Vcluster<> & vcl = create_vcluster();
+
+	size_t np = vcl.getProcessingUnits();
+
+	for (size_t k = 0 ; k < 2 ; k++)
+	{
+		vcl.setReductionFusion(k == 0);
+
+		double a = 1.0;
+		double b = vcl.getProcessUnitID();
+		double c = vcl.getProcessUnitID();
+		size_t d = 2;
+		double e = vcl.getProcessUnitID();
+		size_t f = vcl.getProcessUnitID();
+
+		vcl.sum(a);
+		vcl.max(c);
+		vcl.sum(b);
+		vcl.sum(d);
+		vcl.min(e);
+		vcl.max(f);
+		vcl.execute();
+
+		BOOST_REQUIRE_EQUAL(a,(double)np);
+		BOOST_REQUIRE_EQUAL(b,(double)np*(np-1)/2);
+		BOOST_REQUIRE_EQUAL(c,(double)np-1);
+		BOOST_REQUIRE_EQUAL(d,2*np);
+		BOOST_REQUIRE_EQUAL(e,0.0);
+		BOOST_REQUIRE_EQUAL(f,np-1);
+	}
+
+	vcl.setReductionFusion(true);
+}
+
+BOOST_AUTO_TEST_CASE( VCluster_use_vector_reductions)
+{
+	Vcluster<> & vcl = create_vcluster();
+
+	size_t np = vcl.getProcessingUnits();
+
+	openfpm::vector<double> vd;
+	openfpm::vector<int> vi_max;
+	double ad[3] = {1.0,2.0,3.0};
+	aggregate<float,float[3]> ag;
+	openfpm::vector<aggregate<float,float[3]>> vag;
+
+	for (size_t i = 0 ; i < 100 ; i++)
+	{
+		vd.add(i);
+		vi_max.add(vcl.getProcessUnitID() + i);
+	}
+
+	ag.template get<0>() = vcl.getProcessUnitID();
+	ag.template get<1>()[0] = 1.0;
+	ag.template get<1>()[1] = 2.0;
+	ag.template get<1>()[2] = vcl.getProcessUnitID();
+
+	vag.resize(10);
+	for (size_t i = 0 ; i < vag.size() ; i++)
+	{
+		vag.template get<0>(i) = vcl.getProcessUnitID();
+		vag.template get<1>(i)[0] = i;
+		vag.template get<1>(i)[1] = -(float)vcl.getProcessUnitID();
+		vag.template get<1>(i)[2] = 0.0;
+	}
+
+	vcl.sum(vd);
+	vcl.max(vi_max);
+	vcl.sum(ad);
+	vcl.max(ag);
+	vcl.min(vag);
+	vcl.execute();
+
+	bool match = true;
+	for (size_t i = 0 ; i < 100 ; i++)
+	{
+		match &= vd.get(i) == (double)i*np;
+		match &= vi_max.get(i) == (int)(np - 1 + i);
+	}
+
+	match &= ad[0] == 1.0*np;
+	match &= ad[1] == 2.0*np;
+	match &= ad[2] == 3.0*np;
+
+	match &= ag.template get<0>() == np - 1;
+	match &= ag.template get<1>()[0] == 1.0;
+	match &= ag.template get<1>()[1] == 2.0;
+	match &= ag.template get<1>()[2] == np - 1;
+
+	for (size_t i = 0 ; i < vag.size() ; i++)
+	{
+		match &= vag.template get<0>(i) == 0.0;
+		match &= vag.template get<1>(i)[0] == i;
+		match &= vag.template get<1>(i)[1] == -(float)(np - 1);
+		match &= vag.template get<1>(i)[2] == 0.0;
+	}
+
+	BOOST_REQUIRE_EQUAL(match,true);
+}
+
+BOOST_AUTO_TEST_CASE( VCluster_use_scan)
+{
+	Vcluster<> & vcl = create_vcluster();
+
+	size_t rank = vcl.getProcessUnitID();
+
+	size_t offset = rank + 1;
+	size_t incl = rank + 1;
+	double arr[2] = {1.0,(double)rank};
+	openfpm::vector<int> vi;
+
+	for (size_t i = 0 ; i < 10 ; i++)
+	{vi.add(i);}
+
+	vcl.exscan(offset);
+	vcl.scan(incl);
+	vcl.exscan(arr);
+	vcl.scan(vi);
+	vcl.execute();
+
+	BOOST_REQUIRE_EQUAL(offset,rank*(rank+1)/2);
+	BOOST_REQUIRE_EQUAL(incl,(rank+1)*(rank+2)/2);
+	BOOST_REQUIRE_EQUAL(arr[0],(double)rank);
+	BOOST_REQUIRE_EQUAL(arr[1],(rank == 0)?0.0:(double)(rank-1)*rank/2);
+
+	for (size_t i = 0 ; i < vi.size() ; i++)
+	{BOOST_REQUIRE_EQUAL(vi.get(i),(int)(i*(rank+1)));}
+}
+
+BOOST_AUTO_TEST_CASE( VCluster_use_reproducible_sum)
+{
+	Vcluster<> & vcl = create_vcluster();
+
+	size_t np = vcl.getProcessingUnits();
+	size_t rank = vcl.getProcessUnitID();
+
+	// numbers with very different magnitudes, where the plain sum depend on the order
+	auto val = [](size_t p, size_t i)
+	{
+		double sg = (i % 2 == 0)?1.0:-1.0;
+		return sg * std::pow(10.0,(double)((p*7 + i*13) % 33) - 16.0) + 0.1*i;
+	};
+
+	openfpm::vector<double> v;
+	for (size_t i = 0 ; i < 1000 ; i++)
+	{v.add(val(rank,i));}
+
+	// expected result, computed serially on all the numbers
+	Vcluster_repro_acc acc;
+	acc.zero();
+	for (size_t p = 0 ; p < np ; p++)
+	{
+		for (size_t i = 0 ; i < 1000 ; i++)
+		{acc.add(val(p,i));}
+	}
+	double expected = acc.get();
+
+	double res;
+	double one = 0.1;
+	float onef = 0.25f;
+	vcl.sum_reproducible(v,res);
+	vcl.sum_reproducible(one);
+	vcl.sum_reproducible(onef);
+	vcl.execute();
+
+	BOOST_REQUIRE_EQUAL(res,expected);
+	BOOST_REQUIRE_CLOSE(one,0.1*np,1e-12);
+	BOOST_REQUIRE_EQUAL(onef,0.25f*np);
+}
+
+//! minimum with the processor that has it
+struct test_min_loc
+{
+	void operator()(const aggregate<double,size_t> & in, aggregate<double,size_t> & inout) const
+	{
+		if (in.template get<0>() < inout.template get<0>() ||
+		    (in.template get<0>() == inout.template get<0>() && in.template get<1>() < inout.template get<1>()))
+		{
+			inout.template get<0>() = in.template get<0>();
+			inout.template get<1>() = in.template get<1>();
+		}
+	}
+};
+
+//! bounding box
+struct test_bbox
+{
+	float low[3];
+	float high[3];
+
+	void operator()(const test_bbox & in, test_bbox & inout) const
+	{
+		for (size_t i = 0 ; i < 3 ; i++)
+		{
+			inout.low[i] = std::min(in.low[i],inout.low[i]);
+			inout.high[i] = std::max(in.high[i],inout.high[i]);
+		}
+	}
+};
+
+BOOST_AUTO_TEST_CASE( VCluster_use_user_reductions)
+{
+	Vcluster<> & vcl = create_vcluster();
+
+	size_t np = vcl.getProcessingUnits();
+	size_t rank = vcl.getProcessUnitID();
+
+	for (size_t k = 0 ; k < 2 ; k++)
+	{
+		aggregate<double,size_t> ml;
+		ml.template get<0>() = 10.0 + (double)((rank + 1) % np);
+		ml.template get<1>() = rank;
+
+		test_bbox bx;
+		for (size_t i = 0 ; i < 3 ; i++)
+		{
+			bx.low[i] = rank + i;
+			bx.high[i] = rank + i + 1.0;
+		}
+
+		vcl.reduce<test_min_loc>(ml);
+		vcl.reduce<test_bbox>(bx);
+		vcl.execute();
+
+		// the minimum 10.0 is on the processor np - 1
+		BOOST_REQUIRE_EQUAL(ml.template get<0>(),10.0);
+		BOOST_REQUIRE_EQUAL(ml.template get<1>(),np - 1);
+
+		for (size_t i = 0 ; i < 3 ; i++)
+		{
+			BOOST_REQUIRE_EQUAL(bx.low[i],(float)i);
+			BOOST_REQUIRE_EQUAL(bx.high[i],(float)(np - 1 + i + 1.0));
+		}
+	}
+}
+
 #define N_V_ELEMENTS 16
 
 BOOST_AUTO_TEST_CASE(VCluster_send_recv)
@@ -132,6 +371,652 @@ BOOST_AUTO_TEST_CASE(VCluster_send_recv)
 	test_send_recv_primitives<double>(N_V_ELEMENTS,vcl);
 }
 
+BOOST_AUTO_TEST_CASE(VCluster_request_groups)
+{
+	Vcluster<> & vcl = create_vcluster();
+
+	size_t np = vcl.getProcessingUnits();
+	size_t rank = vcl.getProcessUnitID();
+
+	// ring exchange in the group 1
+	openfpm::vector<size_t> snd(1024);
+	openfpm::vector<size_t> rcv(1024);
+
+	for (size_t i = 0 ; i < snd.size() ; i++)
+	{snd.get(i) = rank*1024 + i;}
+
+	vcl.setRequestGroup(1);
+	vcl.send((rank+1)%np,0,snd.getPointer(),snd.size()*sizeof(size_t));
+	vcl.recv((rank+np-1)%np,0,rcv.getPointer(),rcv.size()*sizeof(size_t));
+
+	// reductions in the group 2
+	vcl.setRequestGroup(2);
+	double a = 1.0;
+	size_t b = rank;
+	vcl.sum(a);
+	vcl.max(b);
+	vcl.setRequestGroup(0);
+
+	vcl.wait(2);
+
+	BOOST_REQUIRE_EQUAL(a,(double)np);
+	BOOST_REQUIRE_EQUAL(b,np-1);
+
+	while (vcl.test(1) == false) {}
+
+	bool match = true;
+	for (size_t i = 0 ; i < rcv.size() ; i++)
+	{match &= rcv.get(i) == ((rank+np-1)%np)*1024 + i;}
+
+	BOOST_REQUIRE_EQUAL(match,true);
+
+	// complete the groups in any order
+	size_t c = 1;
+	size_t d = rank;
+
+	vcl.setRequestGroup(3);
+	vcl.sum(c);
+	vcl.setRequestGroup(4);
+	vcl.min(d);
+	vcl.setRequestGroup(0);
+
+	size_t g1 = vcl.waitany();
+	size_t g2 = vcl.waitany();
+
+	BOOST_REQUIRE_EQUAL(g1 + g2,7ul);
+	BOOST_REQUIRE_EQUAL(vcl.waitany(),(size_t)-1);
+	BOOST_REQUIRE_EQUAL(c,np);
+	BOOST_REQUIRE_EQUAL(d,0ul);
+}
+
+BOOST_AUTO_TEST_CASE(VCluster_thread_contexts)
+{
+	Vcluster<> & vcl = create_vcluster();
+
+	size_t np = vcl.getProcessingUnits();
+	size_t rank = vcl.getProcessUnitID();
+
+	// without MPI_THREAD_MULTIPLE the contexts are used one after the other
+	size_t nt = (vcl.isThreadMultiple() == true)?4:1;
+
+	BOOST_REQUIRE_EQUAL(vcl.createThreadContexts(nt),true);
+	BOOST_REQUIRE_EQUAL(vcl.getNThreadContexts(),nt);
+
+	openfpm::vector<size_t> res(nt);
+	openfpm::vector<openfpm::vector<size_t>> rcv(nt);
+
+	auto work = [&](size_t t)
+	{
+		Vcluster<> & tcl = vcl.getThreadContext(t);
+
+		openfpm::vector<size_t> snd(128);
+		rcv.get(t).resize(128);
+
+		for (size_t i = 0 ; i < snd.size() ; i++)
+		{snd.get(i) = rank*1000 + t*128 + i;}
+
+		tcl.send((rank+1)%np,0,snd.getPointer(),snd.size()*sizeof(size_t));
+		tcl.recv((rank+np-1)%np,0,rcv.get(t).getPointer(),rcv.get(t).size()*sizeof(size_t));
+
+		res.get(t) = t;
+		tcl.sum(res.get(t));
+		tcl.execute();
+	};
+
+	if (nt == 1)
+	{work(0);}
+	else
+	{
+		std::vector<std::thread> thr;
+
+		for (size_t t = 0 ; t < nt ; t++)
+		{thr.push_back(std::thread(work,t));}
+
+		for (size_t t = 0 ; t < nt ; t++)
+		{thr[t].join();}
+	}
+
+	bool match = true;
+	for (size_t t = 0 ; t < nt ; t++)
+	{
+		match &= res.get(t) == t*np;
+
+		for (size_t i = 0 ; i < rcv.get(t).size() ; i++)
+		{match &= rcv.get(t).get(i) == ((rank+np-1)%np)*1000 + t*128 + i;}
+	}
+
+	BOOST_REQUIRE_EQUAL(match,true);
+
+	vcl.destroyThreadContexts();
+}
+
+BOOST_AUTO_TEST_CASE(VCluster_pe_contexts)
+{
+	Vcluster<> & vcl = create_vcluster();
+
+	size_t np = vcl.getProcessingUnits();
+	size_t rank = vcl.getProcessUnitID();
+
+	// without MPI_THREAD_MULTIPLE only one processing unit per process
+	size_t nt = (vcl.isThreadMultiple() == true)?3:1;
+
+	BOOST_REQUIRE_EQUAL(vcl.createPEContexts(nt),true);
+	BOOST_REQUIRE_EQUAL(vcl.getNPEContexts(),nt);
+
+	openfpm::vector<size_t> match(nt);
+
+	auto work = [&](size_t t)
+	{
+		Vcluster<> & pcl = vcl.getPEContext(t);
+
+		size_t n = pcl.size();
+		size_t me = pcl.getProcessUnitID();
+		size_t prev = (me+n-1)%n;
+
+		match.get(t) = (n == np*nt && me == rank*nt+t && pcl.getProcessingUnitsPerProcess() == nt);
+
+		// one message to the next processing unit (in the same process or not) and one to itself
+		openfpm::vector<openfpm::vector<size_t>> snd(2);
+		openfpm::vector<size_t> prc_send;
+		openfpm::vector<size_t> prc_recv;
+		openfpm::vector<size_t> sz_recv;
+		openfpm::vector<size_t> rcv;
+
+		prc_send.add((me+1)%n);
+		prc_send.add(me);
+
+		for (size_t i = 0 ; i < 10 ; i++)
+		{
+			snd.get(0).add(me*100 + i);
+			snd.get(1).add(me*100 + 50 + i);
+		}
+
+		for (size_t k = 0 ; k < 8 ; k++)
+		{
+			rcv.clear();
+			pcl.SSendRecv(snd,rcv,prc_send,prc_recv,sz_recv);
+
+			// the messages are ordered by processing unit
+			openfpm::vector<size_t> check;
+
+			if (prev <= me)
+			{
+				for (size_t i = 0 ; i < 10 ; i++)
+				{check.add(prev*100 + i);}
+			}
+
+			for (size_t i = 0 ; i < 10 ; i++)
+			{check.add(me*100 + 50 + i);}
+
+			if (prev > me)
+			{
+				for (size_t i = 0 ; i < 10 ; i++)
+				{check.add(prev*100 + i);}
+			}
+
+			match.get(t) &= rcv.size() == check.size() && prc_recv.size() == 2;
+
+			for (size_t i = 0 ; i < rcv.size() && i < check.size() ; i++)
+			{match.get(t) &= rcv.get(i) == check.get(i);}
+		}
+	};
+
+	if (nt == 1)
+	{work(0);}
+	else
+	{
+		std::vector<std::thread> thr;
+
+		for (size_t t = 0 ; t < nt ; t++)
+		{thr.push_back(std::thread(work,t));}
+
+		for (size_t t = 0 ; t < nt ; t++)
+		{thr[t].join();}
+	}
+
+	for (size_t t = 0 ; t < nt ; t++)
+	{BOOST_REQUIRE_EQUAL(match.get(t),1ul);}
+
+	vcl.destroyPEContexts();
+}
+
+BOOST_AUTO_TEST_CASE(VCluster_sub_views)
+{
+	Vcluster<> & vcl = create_vcluster();
+
+	size_t np = vcl.getProcessingUnits();
+	size_t rank = vcl.getProcessUnitID();
+
+	// even and odd processors
+	Vcluster<> & par = vcl.split(0,rank % 2,rank);
+
+	BOOST_REQUIRE_EQUAL(&par,&vcl.split(0,rank % 2,rank));
+	BOOST_REQUIRE_EQUAL(par.getProcessingUnits(),(rank % 2 == 0)?(np+1)/2:np/2);
+	BOOST_REQUIRE_EQUAL(par.getProcessUnitID(),rank / 2);
+
+	size_t s = rank;
+	par.sum(s);
+	par.execute();
+
+	size_t check = 0;
+	for (size_t i = rank % 2 ; i < np ; i += 2)
+	{check += i;}
+
+	BOOST_REQUIRE_EQUAL(s,check);
+
+	// every processor is in one node and the leaders are one per node
+	Vcluster<> & nd = vcl.node();
+	Vcluster<> & ld = vcl.leaders();
+
+	size_t n_leaders = (nd.getProcessUnitID() == 0)?1:0;
+	vcl.sum(n_leaders);
+	vcl.execute();
+
+	if (nd.getProcessUnitID() == 0)
+	{BOOST_REQUIRE_EQUAL(ld.getProcessingUnits(),n_leaders);}
+
+	size_t one = 1;
+	nd.sum(one);
+	nd.execute();
+
+	BOOST_REQUIRE_EQUAL(one,nd.getProcessingUnits());
+
+	// rows of a 2 x np/2 grid
+	if (np % 2 == 0)
+	{
+		size_t grid[2] = {2,np/2};
+		bool keep[2] = {true,false};
+
+		Vcluster<> & row = vcl.cartSub(grid,keep);
+
+		BOOST_REQUIRE_EQUAL(row.getProcessingUnits(),2ul);
+		BOOST_REQUIRE_EQUAL(row.getProcessUnitID(),rank % 2);
+
+		size_t r = rank;
+		row.sum(r);
+		row.execute();
+
+		BOOST_REQUIRE_EQUAL(r,4*(rank/2) + 1);
+	}
+
+	// rows and columns of a nx * nx grid, the processors on the diagonal have the same
+	// (color,key) in the two splits
+	size_t nx = 1;
+	while ((nx+1)*(nx+1) <= np)
+	{nx++;}
+
+	bool in_grid = (rank < nx*nx);
+	int r_color = (in_grid == true)?rank / nx:nx;
+	int c_color = (in_grid == true)?rank % nx:nx;
+	int r_key = (in_grid == true)?rank % nx:rank;
+	int c_key = (in_grid == true)?rank / nx:rank;
+
+	Vcluster<> & row = vcl.split(1,r_color,r_key);
+	Vcluster<> & col = vcl.split(2,c_color,c_key);
+
+	BOOST_REQUIRE(&row != &col);
+
+	if (in_grid == true)
+	{
+		BOOST_REQUIRE_EQUAL(row.getProcessingUnits(),nx);
+		BOOST_REQUIRE_EQUAL(col.getProcessingUnits(),nx);
+		BOOST_REQUIRE_EQUAL(row.getProcessUnitID(),rank % nx);
+		BOOST_REQUIRE_EQUAL(col.getProcessUnitID(),rank / nx);
+	}
+
+	size_t rs = rank;
+	size_t cs = rank;
+	row.sum(rs);
+	row.execute();
+	col.sum(cs);
+	col.execute();
+
+	if (in_grid == true)
+	{
+		size_t r_check = 0;
+		size_t c_check = 0;
+		for (size_t i = 0 ; i < nx ; i++)
+		{
+			r_check += (rank / nx)*nx + i;
+			c_check += i*nx + rank % nx;
+		}
+
+		BOOST_REQUIRE_EQUAL(rs,r_check);
+		BOOST_REQUIRE_EQUAL(cs,c_check);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(VCluster_graph_reorder)
+{
+	Vcluster<> & vcl = create_vcluster();
+
+	size_t np = vcl.getProcessingUnits();
+	size_t rank = vcl.getProcessUnitID();
+
+	if (np == 1)
+	{return;}
+
+	// heavy traffic between the pairs (i,i+np/2)
+	openfpm::vector<size_t> snd(1024);
+	openfpm::vector<size_t> rcv(1024);
+	size_t peer = (rank + np/2) % np;
+
+	vcl.startGraphRecording();
+
+	if (np % 2 == 0)
+	{
+		vcl.send(peer,0,snd.getPointer(),snd.size()*sizeof(size_t));
+		vcl.recv(peer,0,rcv.getPointer(),rcv.size()*sizeof(size_t));
+		vcl.execute();
+	}
+
+	vcl.stopGraphRecording();
+
+	auto & graph = vcl.getCommGraph();
+
+	BOOST_REQUIRE_EQUAL(graph.size(),np);
+
+	if (np % 2 == 0)
+	{BOOST_REQUIRE_EQUAL(graph.get(peer),1024*sizeof(size_t));}
+
+	for (int method = GRAPH_REORDER_MPI ; method <= GRAPH_REORDER_NODE ; method++)
+	{
+		Vcluster<> & rvcl = vcl.reordered(method);
+
+		BOOST_REQUIRE_EQUAL(rvcl.getProcessingUnits(),np);
+
+		// the new ranks are a permutation
+		openfpm::vector<size_t> ranks;
+		size_t r = rvcl.getProcessUnitID();
+		vcl.allGather(r,ranks);
+		vcl.execute();
+
+		openfpm::vector<int> found(np);
+		for (size_t i = 0 ; i < np ; i++)
+		{found.get(i) = 0;}
+
+		for (size_t i = 0 ; i < ranks.size() ; i++)
+		{found.get(ranks.get(i)) = 1;}
+
+		bool match = true;
+		for (size_t i = 0 ; i < np ; i++)
+		{match &= found.get(i) == 1;}
+
+		BOOST_REQUIRE_EQUAL(match,true);
+	}
+
+	vcl.freeViews();
+}
+
+BOOST_AUTO_TEST_CASE(VCluster_profiler)
+{
+	Vcluster<> & vcl = create_vcluster();
+
+	size_t np = vcl.getProcessingUnits();
+	size_t rank = vcl.getProcessUnitID();
+
+	if (np == 1)
+	{return;}
+
+	Vcluster_profiler & prof = vcl.getProfiler();
+
+	prof.reset();
+	prof.enable(true);
+	prof.setLabel("ring");
+
+	openfpm::vector<size_t> snd(128);
+	openfpm::vector<size_t> rcv(128);
+	size_t next = (rank + 1) % np;
+	size_t prev = (rank + np - 1) % np;
+
+	vcl.send(next,0,snd.getPointer(),snd.size()*sizeof(size_t));
+	vcl.recv(prev,0,rcv.getPointer(),rcv.size()*sizeof(size_t));
+	vcl.execute();
+
+	// communications outside the label are not counted on it
+	prof.setLabel("");
+	prof.enable(false);
+
+	BOOST_REQUIRE_EQUAL(prof.get("ring",VCL_PROF_P2P,next,0),128*sizeof(size_t));
+	BOOST_REQUIRE_EQUAL(prof.get("ring",VCL_PROF_P2P,next,1),1ul);
+	BOOST_REQUIRE_EQUAL(prof.get("ring",VCL_PROF_P2P,prev,2),128*sizeof(size_t));
+	BOOST_REQUIRE_EQUAL(prof.get("ring",VCL_PROF_P2P,prev,3),1ul);
+	BOOST_REQUIRE_EQUAL(prof.get("ring",VCL_PROF_NBX_UNKNOWN,next,1),0ul);
+
+	vcl.writeProfile("vcluster_profile_test.csv");
+
+	if (rank == 0)
+	{
+		std::ifstream in("vcluster_profile_test.csv");
+		BOOST_REQUIRE_EQUAL(in.is_open(),true);
+
+		// header plus one row for each processor and peer
+		size_t n_lines = 0;
+		std::string line;
+		while (std::getline(in,line))
+		{n_lines++;}
+
+		size_t n_peers = (np == 2)?1:2;
+		BOOST_REQUIRE_EQUAL(n_lines,1 + np*n_peers);
+	}
+
+	prof.reset();
+}
+
+BOOST_AUTO_TEST_CASE(VCluster_trace)
+{
+	Vcluster<> & vcl = create_vcluster();
+
+	size_t np = vcl.getProcessingUnits();
+	size_t rank = vcl.getProcessUnitID();
+
+	// the ring buffer keep the newest phases
+	Vcluster_trace tr;
+	tr.enable(true,4);
+
+	for (size_t i = 0 ; i < 10 ; i++)
+	{vcl_trace_scope ts(tr,(i % 2 == 0)?"even":"odd");}
+
+	BOOST_REQUIRE_EQUAL(tr.size(),4ul);
+	BOOST_REQUIRE_EQUAL(std::string(tr.get(3).name),std::string("odd"));
+	BOOST_REQUIRE(tr.get(0).start <= tr.get(3).start);
+
+	// phases of an NBX
+	Vcluster_trace & trace = vcl.getTrace();
+	trace.enable(true);
+	trace.clear();
+
+	openfpm::vector<openfpm::vector<size_t>> snd(1);
+	openfpm::vector<size_t> prc_send;
+	openfpm::vector<size_t> prc_recv;
+	openfpm::vector<size_t> sz_recv;
+	openfpm::vector<size_t> rcv;
+
+	snd.get(0).resize(64);
+	prc_send.add((rank + 1) % np);
+
+	vcl.SSendRecv(snd,rcv,prc_send,prc_recv,sz_recv);
+
+	trace.enable(false);
+
+	BOOST_REQUIRE_EQUAL(rcv.size(),64ul);
+
+	bool pack = false;
+	bool isend = false;
+	bool ibarrier = false;
+	bool unpack = false;
+	for (size_t i = 0 ; i < trace.size() ; i++)
+	{
+		pack |= std::string(trace.get(i).name) == "pack";
+		isend |= std::string(trace.get(i).name) == "nbx_isend";
+		ibarrier |= std::string(trace.get(i).name) == "nbx_ibarrier";
+		unpack |= std::string(trace.get(i).name) == "unpack";
+	}
+
+	BOOST_REQUIRE_EQUAL(pack,true);
+	BOOST_REQUIRE_EQUAL(isend,true);
+	BOOST_REQUIRE_EQUAL(ibarrier,true);
+	BOOST_REQUIRE_EQUAL(unpack,true);
+
+	vcl.writeTrace("vcluster_trace_test.json");
+
+	if (rank == 0)
+	{
+		std::ifstream in("vcluster_trace_test.json");
+		BOOST_REQUIRE_EQUAL(in.is_open(),true);
+
+		std::string line;
+		std::getline(in,line);
+		BOOST_REQUIRE_EQUAL(line,std::string("{\"traceEvents\":["));
+	}
+
+	trace.clear();
+}
+
+BOOST_AUTO_TEST_CASE(VCluster_counters)
+{
+	Vcluster<> & vcl = create_vcluster();
+
+	size_t np = vcl.getProcessingUnits();
+	size_t rank = vcl.getProcessUnitID();
+
+	if (np == 1)
+	{return;}
+
+	vcl.clear_stats();
+	vcl.enableCounters(true);
+
+	openfpm::vector<openfpm::vector<size_t>> snd(1);
+	openfpm::vector<size_t> prc_send;
+	openfpm::vector<size_t> prc_recv;
+	openfpm::vector<size_t> sz_recv;
+	openfpm::vector<size_t> rcv;
+
+	snd.get(0).resize(64);
+	prc_send.add((rank + 1) % np);
+
+	vcl.SSendRecv(snd,rcv,prc_send,prc_recv,sz_recv);
+
+	vcl.enableCounters(false);
+
+	Vcluster_stats st = vcl.getStats();
+
+	BOOST_REQUIRE_EQUAL(st.msgs_sent,1ul);
+	BOOST_REQUIRE_EQUAL(st.msgs_recv,1ul);
+	BOOST_REQUIRE_EQUAL(st.bytes_sent,64*sizeof(size_t));
+	BOOST_REQUIRE_EQUAL(st.bytes_recv,64*sizeof(size_t));
+	BOOST_REQUIRE_EQUAL(st.nbx_rounds,1ul);
+	BOOST_REQUIRE(st.nbx_time >= st.barrier_wait);
+
+	// disabled counters does not change
+	vcl.SSendRecv(snd,rcv,prc_send,prc_recv,sz_recv);
+
+	BOOST_REQUIRE_EQUAL(vcl.getStats().msgs_sent,1ul);
+
+	vcl.clear_stats();
+
+	BOOST_REQUIRE_EQUAL(vcl.getStats().bytes_sent,0ul);
+}
+
+BOOST_AUTO_TEST_CASE(VCluster_histograms)
+{
+	Vcluster<> & vcl = create_vcluster();
+
+	size_t np = vcl.getProcessingUnits();
+	size_t rank = vcl.getProcessUnitID();
+
+	if (np == 1)
+	{return;}
+
+	Vcluster_histograms & hist = vcl.getHistograms();
+
+	hist.reset();
+	vcl.enableHistograms(true);
+
+	openfpm::vector<openfpm::vector<size_t>> snd(1);
+	openfpm::vector<size_t> prc_send;
+	openfpm::vector<size_t> prc_recv;
+	openfpm::vector<size_t> sz_recv;
+	openfpm::vector<size_t> rcv;
+
+	// 800 byte in the bucket [512,1024)
+	snd.get(0).resize(100);
+	prc_send.add((rank + 1) % np);
+
+	vcl.SSendRecv(snd,rcv,prc_send,prc_recv,sz_recv);
+
+	openfpm::vector<size_t> bc;
+	if (rank == 0)
+	{bc.resize(16);}
+
+	vcl.SBcast(bc,0);
+
+	vcl.enableHistograms(false);
+
+	BOOST_REQUIRE_EQUAL(hist.count(VCL_PROF_SSENDRECV,VCL_HIST_SIZE),1ul);
+	BOOST_REQUIRE_EQUAL(hist.get(VCL_PROF_SSENDRECV,VCL_HIST_SIZE,10),1ul);
+	BOOST_REQUIRE_EQUAL(hist.count(VCL_PROF_SSENDRECV,VCL_HIST_LATENCY),1ul);
+	BOOST_REQUIRE_EQUAL(hist.count(VCL_PROF_COLLECTIVE,VCL_HIST_LATENCY),1ul);
+
+	double p50 = hist.percentile(VCL_PROF_SSENDRECV,VCL_HIST_SIZE,0.5);
+	BOOST_REQUIRE(p50 >= 512.0 && p50 <= 1024.0);
+
+	Vcluster_histograms glob;
+	vcl.reduceHistograms(glob);
+
+	BOOST_REQUIRE_EQUAL(glob.count(VCL_PROF_SSENDRECV,VCL_HIST_SIZE),np);
+	BOOST_REQUIRE_EQUAL(glob.count(VCL_PROF_COLLECTIVE,VCL_HIST_LATENCY),np);
+	BOOST_REQUIRE_EQUAL(glob.count(VCL_PROF_COLLECTIVE,VCL_HIST_SIZE),np-1);
+
+	hist.reset();
+}
+
+BOOST_AUTO_TEST_CASE(VCluster_nbx_imbalance)
+{
+	Vcluster<> & vcl = create_vcluster();
+
+	size_t np = vcl.getProcessingUnits();
+	size_t rank = vcl.getProcessUnitID();
+
+	if (np == 1)
+	{return;}
+
+	vcl.resetNBXTiming();
+
+	// the last processor arrive late and is the only one that send
+	openfpm::vector<openfpm::vector<size_t>> snd;
+	openfpm::vector<size_t> prc_send;
+	openfpm::vector<size_t> prc_recv;
+	openfpm::vector<size_t> sz_recv;
+	openfpm::vector<size_t> rcv;
+
+	if (rank == np - 1)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+		snd.resize(1);
+		snd.get(0).resize(16);
+		prc_send.add(0);
+	}
+
+	vcl.SSendRecv(snd,rcv,prc_send,prc_recv,sz_recv);
+
+	const Vcluster_nbx_timing & tm = vcl.getLastNBXTiming();
+
+	BOOST_REQUIRE_EQUAL(tm.n,1ul);
+	BOOST_REQUIRE(tm.t[VCL_NBX_SEND] + tm.t[VCL_NBX_BARRIER] <= tm.t[VCL_NBX_TOTAL] + 1e-6);
+	BOOST_REQUIRE_EQUAL(vcl.getNBXTiming().n,1ul);
+
+	Vcluster_nbx_imbalance imb;
+	vcl.reduceNBXTiming(imb,true);
+
+	BOOST_REQUIRE_EQUAL(imb.slowest(),(int)(np - 1));
+	BOOST_REQUIRE(imb.max[VCL_NBX_BARRIER] >= 0.04);
+	BOOST_REQUIRE(imb.min[VCL_NBX_BARRIER] <= imb.avg[VCL_NBX_BARRIER]);
+
+	vcl.resetNBXTiming();
+}
+
 BOOST_AUTO_TEST_CASE(VCluster_allgather)
 {
 	Vcluster<> & vcl = create_vcluster();
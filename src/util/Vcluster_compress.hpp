@@ -0,0 +1,528 @@
+/*
+ * Vcluster_compress.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef VCLUSTER_COMPRESS_HPP_
+#define VCLUSTER_COMPRESS_HPP_
+
+#include <cstring>
+#include <cstdint>
+#include <vector>
+#include "timer.hpp"
+
+//! message sent as it is (after the header)
+constexpr unsigned int VCL_CMP_RAW = 0;
+//! message byte-shuffled and compressed
+constexpr unsigned int VCL_CMP_LZ = 1;
+
+/*! \brief Header in front of every message of a compressed exchange
+ *
+ */
+struct vcl_compress_header
+{
+	//! VCL_CMP_RAW or VCL_CMP_LZ
+	uint32_t mode;
+
+	//! stride used for byte shuffling
+	uint32_t stride;
+
+	//! size of the original message
+	uint64_t raw_size;
+
+	//! size of the payload after the header
+	uint64_t cmp_size;
+};
+
+/*! \brief Compression counters
+ *
+ */
+struct Vcluster_compress_counters
+{
+	//! bytes given to the exchange by the user (send side)
+	size_t raw_sent = 0;
+
+	//! bytes actually sent (headers included)
+	size_t cmp_sent = 0;
+
+	//! bytes delivered to the user (receive side)
+	size_t raw_recv = 0;
+
+	//! bytes actually received (headers included)
+	size_t cmp_recv = 0;
+
+	//! time spent in compression
+	double t_compress = 0.0;
+
+	//! time spent in decompression
+	double t_decompress = 0.0;
+
+	/*! \brief Compression ratio of the sent data
+	 *
+	 * \return raw/compressed ratio (1.0 if nothing has been sent)
+	 *
+	 */
+	double ratio() const
+	{
+		if (cmp_sent == 0)
+		{return 1.0;}
+
+		return (double)raw_sent / cmp_sent;
+	}
+
+	//! reset the counters
+	void reset()
+	{
+		raw_sent = 0;
+		cmp_sent = 0;
+		raw_recv = 0;
+		cmp_recv = 0;
+		t_compress = 0.0;
+		t_decompress = 0.0;
+	}
+};
+
+/*! \brief Compression statistics, of the last exchange and accumulated
+ *
+ */
+struct Vcluster_compress_stats
+{
+	//! counters of the last compressed exchange
+	Vcluster_compress_counters last;
+
+	//! counters since the last reset
+	Vcluster_compress_counters total;
+};
+
+/*! \brief Lossless compression of the messages
+ *
+ * The message is byte-shuffled (the k-byte of every element are stored contiguously, this
+ * put together exponents and high bytes of the mantissa of floating point numbers) and
+ * compressed with a greedy LZ77 coder in the LZ4 block format. If the compressed message
+ * is not smaller the message is sent raw
+ *
+ */
+class Vcluster_compress
+{
+	//! hash table size (log2)
+	static const unsigned int hash_log = 12;
+
+	//! maximum match offset
+	static const size_t max_offset = 65535;
+
+	//! hash table of the compressor (position + 1, 0 mean empty)
+	std::vector<size_t> htable;
+
+	//! shuffled message
+	std::vector<unsigned char> shf;
+
+	//! messages smaller than this are not compressed
+	size_t threshold = 4096;
+
+	//! element size used for byte shuffling
+	size_t stride = 8;
+
+	//! statistics
+	Vcluster_compress_stats stats;
+
+	static inline uint32_t read32(const unsigned char * p)
+	{
+		uint32_t v;
+		memcpy(&v,p,sizeof(uint32_t));
+		return v;
+	}
+
+	static inline size_t hash(uint32_t v)
+	{
+		return (v * 2654435761u) >> (32 - hash_log);
+	}
+
+	/*! \brief Write a length in the LZ4 extension format
+	 *
+	 * \return false if there is no space in the output
+	 *
+	 */
+	static inline bool write_len(unsigned char * dst, size_t & op, size_t cap, size_t len)
+	{
+		while (len >= 255)
+		{
+			if (op >= cap) {return false;}
+			dst[op++] = 255;
+			len -= 255;
+		}
+
+		if (op >= cap) {return false;}
+		dst[op++] = (unsigned char)len;
+
+		return true;
+	}
+
+	/*! \brief Emit one sequence (literals + optionally a match)
+	 *
+	 * \return false if there is no space in the output
+	 *
+	 */
+	static inline bool emit(const unsigned char * src, size_t anchor, size_t n_lit,
+			                size_t offset, size_t mlen,
+			                unsigned char * dst, size_t & op, size_t cap)
+	{
+		size_t ml = (mlen >= 4)?mlen - 4:0;
+
+		if (op >= cap) {return false;}
+		dst[op++] = (unsigned char)(((n_lit >= 15)?15:n_lit) << 4 | ((ml >= 15)?15:ml));
+
+		if (n_lit >= 15 && write_len(dst,op,cap,n_lit - 15) == false)
+		{return false;}
+
+		if (op + n_lit > cap) {return false;}
+		memcpy(dst + op,src + anchor,n_lit);
+		op += n_lit;
+
+		// last sequence has only literals
+		if (mlen == 0)
+		{return true;}
+
+		if (op + 2 > cap) {return false;}
+		dst[op++] = offset & 0xFF;
+		dst[op++] = (offset >> 8) & 0xFF;
+
+		if (ml >= 15 && write_len(dst,op,cap,ml - 15) == false)
+		{return false;}
+
+		return true;
+	}
+
+public:
+
+	/*! \brief Byte shuffle
+	 *
+	 * \param src source
+	 * \param dst destination (must not overlap src)
+	 * \param n size in byte
+	 * \param stride element size
+	 *
+	 */
+	static void shuffle(const unsigned char * src, unsigned char * dst, size_t n, size_t stride)
+	{
+		size_t ne = n / stride;
+
+		for (size_t b = 0 ; b < stride ; b++)
+		{
+			unsigned char * d = dst + b*ne;
+			const unsigned char * s = src + b;
+
+			for (size_t e = 0 ; e < ne ; e++)
+			{d[e] = s[e*stride];}
+		}
+
+		memcpy(dst + ne*stride,src + ne*stride,n - ne*stride);
+	}
+
+	/*! \brief Inverse of shuffle
+	 *
+	 * \param src source
+	 * \param dst destination (must not overlap src)
+	 * \param n size in byte
+	 * \param stride element size
+	 *
+	 */
+	static void unshuffle(const unsigned char * src, unsigned char * dst, size_t n, size_t stride)
+	{
+		size_t ne = n / stride;
+
+		for (size_t b = 0 ; b < stride ; b++)
+		{
+			const unsigned char * s = src + b*ne;
+			unsigned char * d = dst + b;
+
+			for (size_t e = 0 ; e < ne ; e++)
+			{d[e*stride] = s[e];}
+		}
+
+		memcpy(dst + ne*stride,src + ne*stride,n - ne*stride);
+	}
+
+	/*! \brief Compress a buffer
+	 *
+	 * \param src buffer to compress
+	 * \param n size of the buffer
+	 * \param dst output
+	 * \param cap capacity of the output
+	 *
+	 * \return the compressed size, 0 if it does not fit in cap
+	 *
+	 */
+	size_t lz_compress(const unsigned char * src, size_t n, unsigned char * dst, size_t cap)
+	{
+		htable.resize(1 << hash_log);
+		std::fill(htable.begin(),htable.end(),0);
+
+		size_t op = 0;
+		size_t anchor = 0;
+		size_t ip = 0;
+
+		// the last 12 byte are always literals (as in LZ4)
+		size_t limit = (n > 12)?n - 12:0;
+		size_t m_limit = (n > 5)?n - 5:0;
+
+		while (ip < limit)
+		{
+			uint32_t seq = read32(src + ip);
+			size_t h = hash(seq);
+			size_t ref = htable[h];
+			htable[h] = ip + 1;
+
+			if (ref != 0 && ip - (ref - 1) <= max_offset && read32(src + ref - 1) == seq)
+			{
+				ref--;
+
+				size_t mlen = 4;
+				while (ip + mlen < m_limit && src[ref + mlen] == src[ip + mlen])
+				{mlen++;}
+
+				if (emit(src,anchor,ip - anchor,ip - ref,mlen,dst,op,cap) == false)
+				{return 0;}
+
+				ip += mlen;
+				anchor = ip;
+			}
+			else
+			{
+				// skip faster on incompressible data
+				ip += 1 + ((ip - anchor) >> 6);
+			}
+		}
+
+		if (emit(src,anchor,n - anchor,0,0,dst,op,cap) == false)
+		{return 0;}
+
+		return op;
+	}
+
+	/*! \brief Decompress a buffer
+	 *
+	 * \param src compressed buffer
+	 * \param n size of the compressed buffer
+	 * \param dst output
+	 * \param raw size of the decompressed buffer
+	 *
+	 * \return true if the buffer has been decoded correctly
+	 *
+	 */
+	static bool lz_decompress(const unsigned char * src, size_t n, unsigned char * dst, size_t raw)
+	{
+		size_t ip = 0;
+		size_t op = 0;
+
+		while (ip < n)
+		{
+			unsigned int token = src[ip++];
+
+			size_t n_lit = token >> 4;
+			if (n_lit == 15)
+			{
+				unsigned int b;
+				do
+				{
+					if (ip >= n) {return false;}
+					b = src[ip++];
+					n_lit += b;
+				} while (b == 255);
+			}
+
+			if (ip + n_lit > n || op + n_lit > raw) {return false;}
+			memcpy(dst + op,src + ip,n_lit);
+			ip += n_lit;
+			op += n_lit;
+
+			if (ip == n)
+			{break;}
+
+			if (ip + 2 > n) {return false;}
+			size_t offset = src[ip] | ((size_t)src[ip+1] << 8);
+			ip += 2;
+
+			size_t mlen = (token & 15);
+			if (mlen == 15)
+			{
+				unsigned int b;
+				do
+				{
+					if (ip >= n) {return false;}
+					b = src[ip++];
+					mlen += b;
+				} while (b == 255);
+			}
+			mlen += 4;
+
+			if (offset == 0 || offset > op || op + mlen > raw) {return false;}
+
+			// matches can overlap the output
+			const unsigned char * ref = dst + op - offset;
+			for (size_t i = 0 ; i < mlen ; i++)
+			{dst[op + i] = ref[i];}
+			op += mlen;
+		}
+
+		return op == raw;
+	}
+
+	/*! \brief Set the compression parameters
+	 *
+	 * \param threshold messages smaller than threshold (in byte) are sent without compression
+	 * \param stride size of the element used for byte shuffling (8 for double, 4 for float, 1 disable)
+	 *
+	 */
+	void setParameters(size_t threshold, size_t stride)
+	{
+		this->threshold = threshold;
+		this->stride = (stride == 0)?1:stride;
+	}
+
+	/*! \brief Encode a message, header included
+	 *
+	 * \param src message
+	 * \param n size of the message
+	 * \param out encoded message
+	 *
+	 */
+	void encode(const void * src, size_t n, std::vector<unsigned char> & out)
+	{
+		timer t;
+		t.start();
+
+		vcl_compress_header hd;
+		hd.mode = VCL_CMP_RAW;
+		hd.stride = stride;
+		hd.raw_size = n;
+		hd.cmp_size = n;
+
+		out.resize(sizeof(vcl_compress_header) + n);
+
+		if (n >= threshold)
+		{
+			const unsigned char * s = (const unsigned char *)src;
+
+			if (stride > 1)
+			{
+				shf.resize(n);
+				shuffle(s,shf.data(),n,stride);
+				s = shf.data();
+			}
+
+			// If does not compress at least 1/16 is not worth
+			size_t cap = n - (n >> 4);
+			size_t c = lz_compress(s,n,out.data() + sizeof(vcl_compress_header),cap);
+
+			if (c != 0)
+			{
+				hd.mode = VCL_CMP_LZ;
+				hd.cmp_size = c;
+			}
+		}
+
+		if (hd.mode == VCL_CMP_RAW)
+		{memcpy(out.data() + sizeof(vcl_compress_header),src,n);}
+
+		out.resize(sizeof(vcl_compress_header) + hd.cmp_size);
+		memcpy(out.data(),&hd,sizeof(vcl_compress_header));
+
+		t.stop();
+
+		stats.last.raw_sent += n;
+		stats.last.cmp_sent += out.size();
+		stats.last.t_compress += t.getwct();
+		stats.total.raw_sent += n;
+		stats.total.cmp_sent += out.size();
+		stats.total.t_compress += t.getwct();
+	}
+
+	/*! \brief Get the size of the decoded message
+	 *
+	 * \param src encoded message (header)
+	 *
+	 * \return the original size
+	 *
+	 */
+	static size_t raw_size(const void * src)
+	{
+		vcl_compress_header hd;
+		memcpy(&hd,src,sizeof(vcl_compress_header));
+
+		return hd.raw_size;
+	}
+
+	/*! \brief Decode a message
+	 *
+	 * \param src encoded message (header included)
+	 * \param n size of the encoded message
+	 * \param dst where to decode (must have raw_size(src) bytes)
+	 *
+	 * \return true if the message has been decoded correctly
+	 *
+	 */
+	bool decode(const void * src, size_t n, void * dst)
+	{
+		timer t;
+		t.start();
+
+		vcl_compress_header hd;
+		memcpy(&hd,src,sizeof(vcl_compress_header));
+
+		const unsigned char * s = (const unsigned char *)src + sizeof(vcl_compress_header);
+		bool ret = true;
+
+		if (hd.cmp_size + sizeof(vcl_compress_header) > n)
+		{ret = false;}
+		else if (hd.mode == VCL_CMP_RAW)
+		{memcpy(dst,s,hd.raw_size);}
+		else
+		{
+			if (hd.stride > 1)
+			{
+				shf.resize(hd.raw_size);
+				ret = lz_decompress(s,hd.cmp_size,shf.data(),hd.raw_size);
+				unshuffle(shf.data(),(unsigned char *)dst,hd.raw_size,hd.stride);
+			}
+			else
+			{ret = lz_decompress(s,hd.cmp_size,(unsigned char *)dst,hd.raw_size);}
+		}
+
+		t.stop();
+
+		stats.last.raw_recv += hd.raw_size;
+		stats.last.cmp_recv += hd.cmp_size + sizeof(vcl_compress_header);
+		stats.last.t_decompress += t.getwct();
+		stats.total.raw_recv += hd.raw_size;
+		stats.total.cmp_recv += hd.cmp_size + sizeof(vcl_compress_header);
+		stats.total.t_decompress += t.getwct();
+
+		return ret;
+	}
+
+	//! a new compressed exchange start
+	void new_exchange()
+	{
+		stats.last.reset();
+	}
+
+	/*! \brief Get the statistics
+	 *
+	 * \return the compression statistics
+	 *
+	 */
+	const Vcluster_compress_stats & getStats() const
+	{
+		return stats;
+	}
+
+	//! Reset the statistics
+	void resetStats()
+	{
+		stats.last.reset();
+		stats.total.reset();
+	}
+};
+
+#endif /* VCLUSTER_COMPRESS_HPP_ */
@@ -0,0 +1,242 @@
+/*
+ * Vcluster_counters.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef VCLUSTER_COUNTERS_HPP_
+#define VCLUSTER_COUNTERS_HPP_
+
+#include <mpi.h>
+#include <atomic>
+#include <cstdint>
+
+//! time spent in the NBX (and in the known-size exchanges)
+constexpr int VCL_TIME_NBX = 0;
+//! time spent waiting the MPI_Ibarrier of the NBX (the local sends are completed)
+constexpr int VCL_TIME_BARRIER = 1;
+//! time spent packing the semantic send buffers
+constexpr int VCL_TIME_PACK = 2;
+//! time spent unpacking the semantic receive buffers
+constexpr int VCL_TIME_UNPACK = 3;
+//! number of timers
+constexpr int VCL_TIME_N = 4;
+
+/*! \brief Snapshot of the communication counters
+ *
+ */
+struct Vcluster_stats
+{
+	//! bytes sent
+	size_t bytes_sent;
+
+	//! bytes received
+	size_t bytes_recv;
+
+	//! messages sent
+	size_t msgs_sent;
+
+	//! messages received
+	size_t msgs_recv;
+
+	//! number of NBX exchanges
+	size_t nbx_rounds;
+
+	//! seconds spent in the NBX
+	double nbx_time;
+
+	//! seconds spent waiting the barrier of the NBX
+	double barrier_wait;
+
+	//! seconds spent packing
+	double pack_time;
+
+	//! seconds spent unpacking
+	double unpack_time;
+};
+
+/*! \brief Communication counters of a Vcluster
+ *
+ * They are always compiled and switched at runtime. When disabled the cost is one relaxed load per
+ * message, when enabled the updates are relaxed atomic additions, so they can be updated by
+ * several threads. Times are accumulated in nanoseconds
+ *
+ */
+class Vcluster_counters
+{
+	//! the counters are recording
+	std::atomic<bool> active;
+
+	//! bytes sent
+	std::atomic<size_t> bytes_sent;
+
+	//! bytes received
+	std::atomic<size_t> bytes_recv;
+
+	//! messages sent
+	std::atomic<size_t> msgs_sent;
+
+	//! messages received
+	std::atomic<size_t> msgs_recv;
+
+	//! NBX exchanges
+	std::atomic<size_t> nbx_rounds;
+
+	//! timers in nanoseconds
+	std::atomic<uint64_t> times[VCL_TIME_N];
+
+public:
+
+	Vcluster_counters()
+	:active(false)
+	{
+		reset();
+	}
+
+	/*! \brief Start or stop the counters
+	 *
+	 * \param active true to start
+	 *
+	 */
+	void enable(bool active)
+	{
+		this->active.store(active,std::memory_order_relaxed);
+	}
+
+	/*! \brief Return true if the counters are recording
+	 *
+	 * \return true if recording
+	 *
+	 */
+	inline bool isActive() const
+	{
+		return active.load(std::memory_order_relaxed);
+	}
+
+	/*! \brief Count a sent message
+	 *
+	 * \param bytes size of the message
+	 *
+	 */
+	inline void send(size_t bytes)
+	{
+		if (isActive() == false)
+		{return;}
+
+		bytes_sent.fetch_add(bytes,std::memory_order_relaxed);
+		msgs_sent.fetch_add(1,std::memory_order_relaxed);
+	}
+
+	/*! \brief Count a received message
+	 *
+	 * \param bytes size of the message
+	 *
+	 */
+	inline void recv(size_t bytes)
+	{
+		if (isActive() == false)
+		{return;}
+
+		bytes_recv.fetch_add(bytes,std::memory_order_relaxed);
+		msgs_recv.fetch_add(1,std::memory_order_relaxed);
+	}
+
+	//! Count an NBX exchange
+	inline void nbx_round()
+	{
+		if (isActive() == true)
+		{nbx_rounds.fetch_add(1,std::memory_order_relaxed);}
+	}
+
+	/*! \brief Start a timer
+	 *
+	 * \return the start time to pass to time (-1 if disabled)
+	 *
+	 */
+	inline double begin() const
+	{
+		return (isActive() == true)?MPI_Wtime():-1.0;
+	}
+
+	/*! \brief Stop a timer
+	 *
+	 * \param t timer (VCL_TIME_NBX ...)
+	 * \param start value returned by begin
+	 *
+	 */
+	inline void time(int t, double start)
+	{
+		if (isActive() == false || start < 0.0)
+		{return;}
+
+		times[t].fetch_add((uint64_t)((MPI_Wtime() - start)*1e9),std::memory_order_relaxed);
+	}
+
+	//! Set all the counters to zero
+	void reset()
+	{
+		bytes_sent.store(0,std::memory_order_relaxed);
+		bytes_recv.store(0,std::memory_order_relaxed);
+		msgs_sent.store(0,std::memory_order_relaxed);
+		msgs_recv.store(0,std::memory_order_relaxed);
+		nbx_rounds.store(0,std::memory_order_relaxed);
+
+		for (int i = 0 ; i < VCL_TIME_N ; i++)
+		{times[i].store(0,std::memory_order_relaxed);}
+	}
+
+	/*! \brief Get the counters
+	 *
+	 * \return a snapshot of the counters
+	 *
+	 */
+	Vcluster_stats get() const
+	{
+		Vcluster_stats st;
+
+		st.bytes_sent = bytes_sent.load(std::memory_order_relaxed);
+		st.bytes_recv = bytes_recv.load(std::memory_order_relaxed);
+		st.msgs_sent = msgs_sent.load(std::memory_order_relaxed);
+		st.msgs_recv = msgs_recv.load(std::memory_order_relaxed);
+		st.nbx_rounds = nbx_rounds.load(std::memory_order_relaxed);
+		st.nbx_time = times[VCL_TIME_NBX].load(std::memory_order_relaxed)*1e-9;
+		st.barrier_wait = times[VCL_TIME_BARRIER].load(std::memory_order_relaxed)*1e-9;
+		st.pack_time = times[VCL_TIME_PACK].load(std::memory_order_relaxed)*1e-9;
+		st.unpack_time = times[VCL_TIME_UNPACK].load(std::memory_order_relaxed)*1e-9;
+
+		return st;
+	}
+};
+
+/*! \brief Accumulate the time of a scope in a timer
+ *
+ */
+struct vcl_time_scope
+{
+	//! counters
+	Vcluster_counters & cnt;
+
+	//! timer
+	int t;
+
+	//! start time
+	double start;
+
+	/*! \brief Start the timer
+	 *
+	 * \param cnt counters
+	 * \param t timer
+	 *
+	 */
+	vcl_time_scope(Vcluster_counters & cnt, int t)
+	:cnt(cnt),t(t),start(cnt.begin())
+	{}
+
+	//! stop the timer
+	~vcl_time_scope()
+	{
+		cnt.time(t,start);
+	}
+};
+
+#endif /* VCLUSTER_COUNTERS_HPP_ */
@@ -0,0 +1,234 @@
+/*
+ * Vcluster_delta.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef VCLUSTER_DELTA_HPP_
+#define VCLUSTER_DELTA_HPP_
+
+#include <cstring>
+#include <cstdint>
+#include <vector>
+#include <map>
+
+//! full message
+constexpr unsigned int VCL_DELTA_FULL = 0;
+//! only the changed ranges
+constexpr unsigned int VCL_DELTA_RUNS = 1;
+
+/*! \brief State of an incremental (delta) exchange
+ *
+ * For each peer it keep the last message sent and the last message received. Messages are
+ * identified by processor and by the order of the message among the ones exchanged with the same
+ * processor. When a message has the same size of the previous one only the ranges that changed are
+ * sent, the receiver apply them on its copy of the previous message.
+ *
+ * One object must be used for each exchange site (the same object must be passed on all the
+ * processors at every call). If the communication pattern change call reset() on all the processors
+ *
+ */
+class Vcluster_delta
+{
+	//! Message header
+	struct header
+	{
+		//! VCL_DELTA_FULL or VCL_DELTA_RUNS
+		uint64_t mode;
+
+		//! size of the message
+		uint64_t raw_size;
+
+		//! number of ranges
+		uint64_t n_runs;
+	};
+
+	//! Changed range
+	struct run
+	{
+		//! start of the range
+		uint64_t start;
+
+		//! size of the range
+		uint64_t size;
+	};
+
+	//! previous sent message (processor, occurrence)
+	std::map<std::pair<size_t,size_t>,std::vector<unsigned char>> sent;
+
+	//! previous received message (processor, occurrence)
+	std::map<std::pair<size_t,size_t>,std::vector<unsigned char>> recv;
+
+	//! granularity of the comparison in byte
+	size_t block = 64;
+
+	//! ranges of the message in construction
+	std::vector<run> runs;
+
+	//! bytes given to the exchange
+	size_t raw_bytes = 0;
+
+	//! bytes actually sent
+	size_t sent_bytes = 0;
+
+public:
+
+	/*! \brief Set the granularity of the comparison
+	 *
+	 * \param block size in byte of the blocks compared
+	 *
+	 */
+	void setBlockSize(size_t block)
+	{
+		this->block = (block == 0)?1:block;
+	}
+
+	/*! \brief Encode a message
+	 *
+	 * \param prc destination processor
+	 * \param occ order of the message among the ones sent to prc
+	 * \param src message
+	 * \param n size of the message
+	 * \param out encoded message
+	 *
+	 */
+	void encode(size_t prc, size_t occ, const void * src, size_t n, std::vector<unsigned char> & out)
+	{
+		const unsigned char * s = (const unsigned char *)src;
+		std::vector<unsigned char> & prev = sent[std::make_pair(prc,occ)];
+
+		header hd;
+		hd.raw_size = n;
+		hd.n_runs = 0;
+		hd.mode = VCL_DELTA_FULL;
+
+		runs.clear();
+		size_t changed = 0;
+
+		if (prev.size() == n && n != 0)
+		{
+			for (size_t i = 0 ; i < n ; i += block)
+			{
+				size_t bs = (n - i < block)?n - i:block;
+
+				if (memcmp(s + i,prev.data() + i,bs) == 0)
+				{continue;}
+
+				if (runs.size() != 0 && runs.back().start + runs.back().size == i)
+				{runs.back().size += bs;}
+				else
+				{runs.push_back({i,bs});}
+
+				changed += bs;
+			}
+
+			if (sizeof(header) + runs.size()*sizeof(run) + changed < sizeof(header) + n)
+			{
+				hd.mode = VCL_DELTA_RUNS;
+				hd.n_runs = runs.size();
+			}
+		}
+
+		if (hd.mode == VCL_DELTA_FULL)
+		{
+			out.resize(sizeof(header) + n);
+			memcpy(out.data() + sizeof(header),s,n);
+		}
+		else
+		{
+			out.resize(sizeof(header) + runs.size()*sizeof(run) + changed);
+			memcpy(out.data() + sizeof(header),runs.data(),runs.size()*sizeof(run));
+
+			unsigned char * d = out.data() + sizeof(header) + runs.size()*sizeof(run);
+			for (size_t i = 0 ; i < runs.size() ; i++)
+			{
+				memcpy(d,s + runs[i].start,runs[i].size);
+				d += runs[i].size;
+			}
+		}
+
+		memcpy(out.data(),&hd,sizeof(header));
+
+		prev.resize(n);
+		memcpy(prev.data(),s,n);
+
+		raw_bytes += n;
+		sent_bytes += out.size();
+	}
+
+	/*! \brief Decode a message
+	 *
+	 * \param prc source processor
+	 * \param occ order of the message among the ones received from prc
+	 * \param src encoded message
+	 * \param n size of the encoded message
+	 *
+	 * \return the decoded message, NULL if the message cannot be decoded
+	 *
+	 */
+	const std::vector<unsigned char> * decode(size_t prc, size_t occ, const void * src, size_t n)
+	{
+		const unsigned char * s = (const unsigned char *)src;
+		std::vector<unsigned char> & prev = recv[std::make_pair(prc,occ)];
+
+		if (n < sizeof(header))
+		{return NULL;}
+
+		header hd;
+		memcpy(&hd,s,sizeof(header));
+
+		if (hd.mode == VCL_DELTA_FULL)
+		{
+			if (n < sizeof(header) + hd.raw_size)
+			{return NULL;}
+
+			prev.resize(hd.raw_size);
+			memcpy(prev.data(),s + sizeof(header),hd.raw_size);
+
+			return &prev;
+		}
+
+		// apply the changes on the previous message
+		if (prev.size() != hd.raw_size || n < sizeof(header) + hd.n_runs*sizeof(run))
+		{return NULL;}
+
+		const unsigned char * d = s + sizeof(header) + hd.n_runs*sizeof(run);
+		for (size_t i = 0 ; i < hd.n_runs ; i++)
+		{
+			run r;
+			memcpy(&r,s + sizeof(header) + i*sizeof(run),sizeof(run));
+
+			if (r.start + r.size > prev.size() || d + r.size > s + n)
+			{return NULL;}
+
+			memcpy(prev.data() + r.start,d,r.size);
+			d += r.size;
+		}
+
+		return &prev;
+	}
+
+	/*! \brief Get the ratio between the bytes sent and the bytes of the messages
+	 *
+	 * \return the ratio (1.0 if nothing has been sent)
+	 *
+	 */
+	double getSentRatio() const
+	{
+		if (raw_bytes == 0)
+		{return 1.0;}
+
+		return (double)sent_bytes / raw_bytes;
+	}
+
+	//! Forget all the previous messages (must be called on all the processors)
+	void reset()
+	{
+		sent.clear();
+		recv.clear();
+		raw_bytes = 0;
+		sent_bytes = 0;
+	}
+};
+
+#endif /* VCLUSTER_DELTA_HPP_ */
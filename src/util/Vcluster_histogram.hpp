@@ -0,0 +1,287 @@
+/*
+ * Vcluster_histogram.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef VCLUSTER_HISTOGRAM_HPP_
+#define VCLUSTER_HISTOGRAM_HPP_
+
+#include <mpi.h>
+#include <vector>
+#include <ostream>
+#include <algorithm>
+#include "util/Vcluster_profiler.hpp"
+
+//! histogram of the message sizes (bytes)
+constexpr int VCL_HIST_SIZE = 0;
+//! histogram of the exchange latencies (nanoseconds)
+constexpr int VCL_HIST_LATENCY = 1;
+
+/*! \brief Histograms of message sizes and exchange latencies for each category of communication
+ *
+ * The categories are the ones of Vcluster_profiler. The buckets are powers of two, the bucket 0
+ * contain the value 0 and the bucket b > 0 the values in [2^(b-1),2^b). All the histograms are
+ * stored in one array, so that they can be merged across processors with one reduction
+ *
+ */
+class Vcluster_histograms
+{
+	//! number of buckets
+	static const size_t n_buckets = 64;
+
+	//! the histograms are recording
+	bool active = false;
+
+	//! counts [api][histogram][bucket]
+	std::vector<size_t> data;
+
+	/*! \brief Bucket of a value
+	 *
+	 * \param v value
+	 *
+	 * \return the bucket
+	 *
+	 */
+	static inline size_t bucket(size_t v)
+	{
+		size_t b = 0;
+		while (v != 0)
+		{
+			v >>= 1;
+			b++;
+		}
+
+		return (b < n_buckets)?b:n_buckets-1;
+	}
+
+	/*! \brief Add a value
+	 *
+	 * \param api category
+	 * \param h histogram
+	 * \param v value
+	 *
+	 */
+	inline void add(int api, int h, size_t v)
+	{
+		data[((size_t)api*2 + h)*n_buckets + bucket(v)]++;
+	}
+
+public:
+
+	Vcluster_histograms()
+	:data(VCL_PROF_N_API*2*n_buckets,0)
+	{}
+
+	/*! \brief Start or stop the recording
+	 *
+	 * \param active true to start
+	 *
+	 */
+	void enable(bool active)
+	{
+		this->active = active;
+	}
+
+	/*! \brief Return true if the histograms are recording
+	 *
+	 * \return true if recording
+	 *
+	 */
+	bool isActive() const
+	{
+		return active;
+	}
+
+	/*! \brief Record the size of a sent message
+	 *
+	 * \param api category
+	 * \param bytes size
+	 *
+	 */
+	inline void size(int api, size_t bytes)
+	{
+		if (active == true)
+		{add(api,VCL_HIST_SIZE,bytes);}
+	}
+
+	/*! \brief Start an exchange
+	 *
+	 * \return the start time to pass to latency (-1 if disabled)
+	 *
+	 */
+	inline double begin() const
+	{
+		return (active == true)?MPI_Wtime():-1.0;
+	}
+
+	/*! \brief Record the latency of an exchange
+	 *
+	 * \param api category
+	 * \param start value returned by begin
+	 *
+	 */
+	inline void latency(int api, double start)
+	{
+		if (active == true && start >= 0.0)
+		{add(api,VCL_HIST_LATENCY,(size_t)((MPI_Wtime() - start)*1e9));}
+	}
+
+	//! Set all the counts to zero
+	void reset()
+	{
+		std::fill(data.begin(),data.end(),0);
+	}
+
+	/*! \brief Get the count of a bucket
+	 *
+	 * \param api category
+	 * \param h histogram (VCL_HIST_SIZE or VCL_HIST_LATENCY)
+	 * \param b bucket
+	 *
+	 * \return the count
+	 *
+	 */
+	size_t get(int api, int h, size_t b) const
+	{
+		return data[((size_t)api*2 + h)*n_buckets + b];
+	}
+
+	/*! \brief Number of values in a histogram
+	 *
+	 * \param api category
+	 * \param h histogram
+	 *
+	 * \return the number of values
+	 *
+	 */
+	size_t count(int api, int h) const
+	{
+		size_t tot = 0;
+		for (size_t b = 0 ; b < n_buckets ; b++)
+		{tot += get(api,h,b);}
+
+		return tot;
+	}
+
+	/*! \brief Percentile of a histogram
+	 *
+	 * The value is interpolated linearly inside the bucket
+	 *
+	 * \param api category
+	 * \param h histogram
+	 * \param p percentile in [0,1] (0.5 is the median)
+	 *
+	 * \return the percentile (0 if the histogram is empty)
+	 *
+	 */
+	double percentile(int api, int h, double p) const
+	{
+		double target = p * count(api,h);
+		double cum = 0.0;
+
+		for (size_t b = 0 ; b < n_buckets ; b++)
+		{
+			double c = get(api,h,b);
+
+			if (c != 0.0 && cum + c >= target)
+			{
+				double lo = (b == 0)?0.0:(double)(1ul << (b-1));
+				double hi = (b == 0)?0.0:2.0*lo;
+
+				return lo + (hi - lo) * (target - cum) / c;
+			}
+
+			cum += c;
+		}
+
+		return 0.0;
+	}
+
+	/*! \brief Get all the counts (to merge the histograms of several processors)
+	 *
+	 * \return the counts
+	 *
+	 */
+	std::vector<size_t> & getData()
+	{
+		return data;
+	}
+
+	/*! \brief Write the non-empty histograms as a JSON array
+	 *
+	 * \param out stream
+	 *
+	 */
+	void writeJSON(std::ostream & out) const
+	{
+		const char * h_name[] = {"size_bytes","latency_ns"};
+		bool first = true;
+
+		out << "[";
+
+		for (int a = 0 ; a < VCL_PROF_N_API ; a++)
+		{
+			if (count(a,VCL_HIST_SIZE) == 0 && count(a,VCL_HIST_LATENCY) == 0)
+			{continue;}
+
+			out << ((first == true)?"\n":",\n") << "{\"api\":\"" << Vcluster_profiler::apiName(a) << "\"";
+			first = false;
+
+			for (int h = 0 ; h < 2 ; h++)
+			{
+				size_t last = 0;
+				for (size_t b = 0 ; b < n_buckets ; b++)
+				{
+					if (get(a,h,b) != 0)
+					{last = b + 1;}
+				}
+
+				out << ",\"" << h_name[h] << "\":{\"count\":" << count(a,h) << ",\"p50\":" << percentile(a,h,0.5)
+				    << ",\"p95\":" << percentile(a,h,0.95) << ",\"p99\":" << percentile(a,h,0.99) << ",\"buckets\":[";
+
+				for (size_t b = 0 ; b < last ; b++)
+				{out << ((b == 0)?"":",") << get(a,h,b);}
+
+				out << "]}";
+			}
+
+			out << "}";
+		}
+
+		out << "\n]";
+	}
+};
+
+/*! \brief Record the latency of an exchange for the duration of a scope
+ *
+ */
+struct vcl_hist_scope
+{
+	//! histograms
+	Vcluster_histograms & hist;
+
+	//! category
+	int api;
+
+	//! start time
+	double start;
+
+	/*! \brief Start the exchange
+	 *
+	 * \param hist histograms
+	 * \param api category
+	 *
+	 */
+	vcl_hist_scope(Vcluster_histograms & hist, int api)
+	:hist(hist),api(api),start(hist.begin())
+	{}
+
+	//! record the latency
+	~vcl_hist_scope()
+	{
+		hist.latency(api,start);
+	}
+};
+
+#endif /* VCLUSTER_HISTOGRAM_HPP_ */
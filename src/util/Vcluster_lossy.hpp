@@ -0,0 +1,333 @@
+/*
+ * Vcluster_lossy.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef VCLUSTER_LOSSY_HPP_
+#define VCLUSTER_LOSSY_HPP_
+
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+
+//! field copied as it is
+constexpr unsigned int VCL_LOSSY_RAW = 0;
+//! field of float
+constexpr unsigned int VCL_LOSSY_FLOAT = 1;
+//! field of double
+constexpr unsigned int VCL_LOSSY_DOUBLE = 2;
+
+/*! \brief Description of one field of an element (a property or a property component)
+ *
+ */
+struct vcl_lossy_field
+{
+	//! offset of the field inside the element
+	size_t offset;
+
+	//! size of the field in byte
+	size_t size;
+
+	//! VCL_LOSSY_RAW, VCL_LOSSY_FLOAT or VCL_LOSSY_DOUBLE
+	unsigned int type;
+
+	//! absolute error bound (<= 0 mean lossless)
+	double eb;
+};
+
+/*! \brief Error bounded lossy compression of arrays of structures
+ *
+ * Each field of the elements is encoded as a column. Floating point fields with a positive
+ * error bound are quantized with step 2*eb, predicted from the previous value and the
+ * residuals are stored by blocks of 64 values with bit-plane coding (only the bit-planes
+ * needed by the largest residual of the block are written). Blocks where the bound cannot be
+ * guaranteed (inf, nan, overflow) are stored raw. All the other fields are stored raw.
+ *
+ */
+class Vcluster_lossy
+{
+	//! values for each block
+	static const size_t block = 64;
+
+	//! block stored raw
+	static const unsigned char raw_block = 255;
+
+	//! Message header
+	struct header
+	{
+		//! number of elements
+		uint64_t n_ele;
+
+		//! size of the element
+		uint64_t ele_size;
+	};
+
+	static inline void write(std::vector<unsigned char> & out, const void * src, size_t n)
+	{
+		size_t sz = out.size();
+		out.resize(sz + n);
+		memcpy(out.data() + sz,src,n);
+	}
+
+	static inline uint64_t zigzag(int64_t v)
+	{
+		return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+	}
+
+	static inline int64_t unzigzag(uint64_t v)
+	{
+		return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+	}
+
+	template<typename F>
+	static void encode_column(const unsigned char * src, size_t n_ele, size_t ele_size,
+			                  size_t offset, double eb, std::vector<unsigned char> & out)
+	{
+		double step = 2.0*eb;
+		write(out,&step,sizeof(double));
+
+		int64_t q[block];
+		uint64_t zz[block];
+		int64_t prev = 0;
+
+		for (size_t s = 0 ; s < n_ele ; s += block)
+		{
+			size_t c = (n_ele - s < block)?n_ele - s:block;
+			bool ok = true;
+			uint64_t mx = 0;
+
+			for (size_t k = 0 ; k < c ; k++)
+			{
+				F x;
+				memcpy(&x,src + (s+k)*ele_size + offset,sizeof(F));
+
+				double qd = std::round((double)x / step);
+
+				// residuals must fit in 63 bit
+				if (!(std::fabs(qd) < 4.6e18))
+				{ok = false;break;}
+
+				q[k] = (int64_t)qd;
+
+				// check the bound on the reconstructed value
+				F xr = (F)(q[k]*step);
+				if (!(std::fabs((double)xr - (double)x) <= eb))
+				{ok = false;break;}
+
+				int64_t p = (k == 0)?prev:q[k-1];
+				zz[k] = zigzag(q[k] - p);
+				mx |= zz[k];
+			}
+
+			if (ok == false)
+			{
+				unsigned char nb = raw_block;
+				write(out,&nb,1);
+
+				for (size_t k = 0 ; k < c ; k++)
+				{write(out,src + (s+k)*ele_size + offset,sizeof(F));}
+
+				prev = 0;
+				continue;
+			}
+
+			unsigned char nb = 0;
+			while (nb < 64 && (mx >> nb) != 0)
+			{nb++;}
+
+			write(out,&nb,1);
+
+			// bit-planes from the most significant
+			size_t plane_sz = (c + 7) / 8;
+			size_t pos = out.size();
+			out.resize(pos + nb*plane_sz,0);
+
+			for (int b = nb - 1 ; b >= 0 ; b--)
+			{
+				unsigned char * pl = out.data() + pos;
+				for (size_t k = 0 ; k < c ; k++)
+				{pl[k >> 3] |= ((zz[k] >> b) & 1) << (k & 7);}
+
+				pos += plane_sz;
+			}
+
+			prev = q[c-1];
+		}
+	}
+
+	template<typename F>
+	static bool decode_column(const unsigned char * src, size_t n, size_t & ip,
+			                  unsigned char * dst, size_t n_ele, size_t ele_size, size_t offset)
+	{
+		double step;
+		if (ip + sizeof(double) > n) {return false;}
+		memcpy(&step,src + ip,sizeof(double));
+		ip += sizeof(double);
+
+		int64_t prev = 0;
+
+		for (size_t s = 0 ; s < n_ele ; s += block)
+		{
+			size_t c = (n_ele - s < block)?n_ele - s:block;
+
+			if (ip >= n) {return false;}
+			unsigned char nb = src[ip++];
+
+			if (nb == raw_block)
+			{
+				if (ip + c*sizeof(F) > n) {return false;}
+
+				for (size_t k = 0 ; k < c ; k++)
+				{memcpy(dst + (s+k)*ele_size + offset,src + ip + k*sizeof(F),sizeof(F));}
+
+				ip += c*sizeof(F);
+				prev = 0;
+				continue;
+			}
+
+			size_t plane_sz = (c + 7) / 8;
+			if (nb > 64 || ip + nb*plane_sz > n) {return false;}
+
+			uint64_t zz[block];
+			for (size_t k = 0 ; k < c ; k++)
+			{zz[k] = 0;}
+
+			for (int b = nb - 1 ; b >= 0 ; b--)
+			{
+				const unsigned char * pl = src + ip;
+				for (size_t k = 0 ; k < c ; k++)
+				{zz[k] |= (uint64_t)((pl[k >> 3] >> (k & 7)) & 1) << b;}
+
+				ip += plane_sz;
+			}
+
+			for (size_t k = 0 ; k < c ; k++)
+			{
+				prev += unzigzag(zz[k]);
+				F x = (F)(prev*step);
+				memcpy(dst + (s+k)*ele_size + offset,&x,sizeof(F));
+			}
+		}
+
+		return true;
+	}
+
+public:
+
+	/*! \brief Encode an array of elements
+	 *
+	 * \param src array of elements
+	 * \param n_ele number of elements
+	 * \param ele_size size of one element
+	 * \param fields fields of the element
+	 * \param out encoded message
+	 *
+	 */
+	static void encode(const void * src, size_t n_ele, size_t ele_size,
+			           const std::vector<vcl_lossy_field> & fields,
+			           std::vector<unsigned char> & out)
+	{
+		const unsigned char * s = (const unsigned char *)src;
+
+		out.clear();
+
+		header hd;
+		hd.n_ele = n_ele;
+		hd.ele_size = ele_size;
+		write(out,&hd,sizeof(header));
+
+		for (size_t f = 0 ; f < fields.size() ; f++)
+		{
+			const vcl_lossy_field & fl = fields[f];
+
+			unsigned char mode = (fl.eb > 0.0)?fl.type:VCL_LOSSY_RAW;
+			write(out,&mode,1);
+
+			if (mode == VCL_LOSSY_FLOAT)
+			{encode_column<float>(s,n_ele,ele_size,fl.offset,fl.eb,out);}
+			else if (mode == VCL_LOSSY_DOUBLE)
+			{encode_column<double>(s,n_ele,ele_size,fl.offset,fl.eb,out);}
+			else
+			{
+				size_t pos = out.size();
+				out.resize(pos + n_ele*fl.size);
+
+				for (size_t k = 0 ; k < n_ele ; k++)
+				{memcpy(out.data() + pos + k*fl.size,s + k*ele_size + fl.offset,fl.size);}
+			}
+		}
+	}
+
+	/*! \brief Get the size of the decoded message
+	 *
+	 * \param src encoded message
+	 *
+	 * \return the size of the array of elements
+	 *
+	 */
+	static size_t raw_size(const void * src)
+	{
+		header hd;
+		memcpy(&hd,src,sizeof(header));
+
+		return hd.n_ele * hd.ele_size;
+	}
+
+	/*! \brief Decode an array of elements
+	 *
+	 * \param src encoded message
+	 * \param n size of the encoded message
+	 * \param fields fields of the element (the same used to encode)
+	 * \param dst output (must have raw_size(src) bytes)
+	 *
+	 * \return true if the message has been decoded correctly
+	 *
+	 */
+	static bool decode(const void * src, size_t n, const std::vector<vcl_lossy_field> & fields, void * dst)
+	{
+		const unsigned char * s = (const unsigned char *)src;
+		unsigned char * d = (unsigned char *)dst;
+
+		if (n < sizeof(header)) {return false;}
+
+		header hd;
+		memcpy(&hd,src,sizeof(header));
+		size_t ip = sizeof(header);
+
+		// padding between fields is not transmitted
+		memset(dst,0,hd.n_ele*hd.ele_size);
+
+		for (size_t f = 0 ; f < fields.size() ; f++)
+		{
+			const vcl_lossy_field & fl = fields[f];
+
+			if (ip >= n) {return false;}
+			unsigned char mode = s[ip++];
+
+			bool ret = true;
+
+			if (mode == VCL_LOSSY_FLOAT)
+			{ret = decode_column<float>(s,n,ip,d,hd.n_ele,hd.ele_size,fl.offset);}
+			else if (mode == VCL_LOSSY_DOUBLE)
+			{ret = decode_column<double>(s,n,ip,d,hd.n_ele,hd.ele_size,fl.offset);}
+			else
+			{
+				if (ip + hd.n_ele*fl.size > n) {return false;}
+
+				for (size_t k = 0 ; k < hd.n_ele ; k++)
+				{memcpy(d + k*hd.ele_size + fl.offset,s + ip + k*fl.size,fl.size);}
+
+				ip += hd.n_ele*fl.size;
+			}
+
+			if (ret == false)
+			{return false;}
+		}
+
+		return ip == n;
+	}
+};
+
+#endif /* VCLUSTER_LOSSY_HPP_ */
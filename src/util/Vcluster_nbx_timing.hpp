@@ -0,0 +1,103 @@
+/*
+ * Vcluster_nbx_timing.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef VCLUSTER_NBX_TIMING_HPP_
+#define VCLUSTER_NBX_TIMING_HPP_
+
+#include <cstddef>
+
+//! time from the start of the NBX to the completion of the local sends
+constexpr int VCL_NBX_SEND = 0;
+//! time waiting the MPI_Ibarrier (waiting the other processors)
+constexpr int VCL_NBX_BARRIER = 1;
+//! time spent receiving the messages
+constexpr int VCL_NBX_RECV = 2;
+//! total time of the NBX
+constexpr int VCL_NBX_TOTAL = 3;
+//! number of times
+constexpr int VCL_NBX_N = 4;
+
+/*! \brief Times of the NBX with unknown processors
+ *
+ * For the asynchronous NBX the times are measured from the post of the exchange, so the send time
+ * include the computation overlapped before sendrecvMultipleMessagesNBXWait
+ *
+ */
+struct Vcluster_nbx_timing
+{
+	//! number of exchanges
+	size_t n;
+
+	//! times in seconds (VCL_NBX_SEND ...)
+	double t[VCL_NBX_N];
+
+	//! Set to zero
+	void zero()
+	{
+		n = 0;
+		for (int i = 0 ; i < VCL_NBX_N ; i++)
+		{t[i] = 0.0;}
+	}
+
+	/*! \brief Add the times of an exchange
+	 *
+	 * \param tm times of the exchange
+	 *
+	 */
+	void add(const Vcluster_nbx_timing & tm)
+	{
+		n += tm.n;
+		for (int i = 0 ; i < VCL_NBX_N ; i++)
+		{t[i] += tm.t[i];}
+	}
+};
+
+/*! \brief NBX times reduced over all the processors
+ *
+ * The processor that arrive last at the barrier wait the least, so the processor with the minimum
+ * barrier time is the slowest one. If the barrier time is a large part of the total the exchange
+ * is dominated by load imbalance, if it is small the cost is in the network (send and receive)
+ *
+ */
+struct Vcluster_nbx_imbalance
+{
+	//! maximum of each time
+	double max[VCL_NBX_N];
+
+	//! processor with the maximum
+	int max_rank[VCL_NBX_N];
+
+	//! minimum of each time
+	double min[VCL_NBX_N];
+
+	//! processor with the minimum
+	int min_rank[VCL_NBX_N];
+
+	//! average of each time
+	double avg[VCL_NBX_N];
+
+	/*! \brief Get the slowest processor (the one that reach the barrier last)
+	 *
+	 * \return the processor
+	 *
+	 */
+	int slowest() const
+	{
+		return min_rank[VCL_NBX_BARRIER];
+	}
+
+	/*! \brief Average fraction of the time spent waiting the other processors
+	 *
+	 * \return the fraction (0 if no exchange)
+	 *
+	 */
+	double waitFraction() const
+	{
+		return (avg[VCL_NBX_TOTAL] != 0.0)?avg[VCL_NBX_BARRIER] / avg[VCL_NBX_TOTAL]:0.0;
+	}
+};
+
+#endif /* VCLUSTER_NBX_TIMING_HPP_ */
@@ -0,0 +1,254 @@
+/*
+ * Vcluster_pe.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef VCLUSTER_PE_HPP_
+#define VCLUSTER_PE_HPP_
+
+#include <mpi.h>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <iostream>
+#include "MPI_wrapper/MPI_util.hpp"
+
+/*! \brief Message for a processing unit of the same process
+ *
+ * The message is not copied when posted, the receiver copy it directly from the send buffer
+ *
+ */
+struct Vcluster_pe_msg
+{
+	//! send buffer
+	const void * ptr;
+
+	//! size in byte
+	size_t sz;
+
+	//! processing unit that sent the message
+	size_t src;
+
+	//! tag of the message (same as over MPI)
+	size_t tag;
+
+	//! messages of the sender not yet copied (decremented by the receiver)
+	std::atomic<size_t> * pending;
+};
+
+/*! \brief Processing units of one process (hybrid mode)
+ *
+ * Every processing unit has a duplicate of the communicator of the process, messages for the
+ * processing unit p of another process are sent on the communicator p. Messages between the
+ * processing units of the same process are posted in the mailbox of the receiver and copied by it.
+ * The NBX barrier of a processing unit is called only when all the processing units of the process
+ * completed their sends, so when the barrier complete all the messages of all the processing units
+ * have been received
+ *
+ */
+class Vcluster_pe_group
+{
+	//! number of processing units
+	size_t n;
+
+	//! communicator of each processing unit
+	std::vector<MPI_Comm> comm;
+
+	//! lock of each mailbox
+	std::unique_ptr<std::mutex[]> mtx;
+
+	//! mailbox of each processing unit
+	std::vector<std::vector<Vcluster_pe_msg>> box;
+
+	//! number of completed sends (NBX rounds) of each processing unit
+	std::unique_ptr<std::atomic<size_t>[]> round;
+
+public:
+
+	/*! \brief Create the processing units (collective on parent)
+	 *
+	 * \param n number of processing units per process
+	 * \param parent communicator of the processes
+	 *
+	 */
+	Vcluster_pe_group(size_t n, MPI_Comm parent)
+	:n(n),comm(n),mtx(new std::mutex[n]),box(n),round(new std::atomic<size_t>[n])
+	{
+		for (size_t i = 0 ; i < n ; i++)
+		{
+			MPI_SAFE_CALL(MPI_Comm_dup(parent,&comm[i]));
+			round[i] = 0;
+		}
+	}
+
+	//! Free the communicators (collective)
+	~Vcluster_pe_group()
+	{
+		for (size_t i = 0 ; i < n ; i++)
+		{MPI_Comm_free(&comm[i]);}
+	}
+
+	/*! \brief Number of processing units per process
+	 *
+	 * \return the number of processing units
+	 *
+	 */
+	size_t size() const
+	{
+		return n;
+	}
+
+	/*! \brief Communicator of a processing unit
+	 *
+	 * \param p processing unit
+	 *
+	 * \return the communicator
+	 *
+	 */
+	MPI_Comm getComm(size_t p) const
+	{
+		return comm[p];
+	}
+
+	/*! \brief Post a message in the mailbox of a processing unit
+	 *
+	 * \param p receiving processing unit
+	 * \param m message
+	 *
+	 */
+	void post(size_t p, const Vcluster_pe_msg & m)
+	{
+		std::lock_guard<std::mutex> lk(mtx[p]);
+
+		box[p].push_back(m);
+	}
+
+	/*! \brief Take from the mailbox the messages that can be received
+	 *
+	 * The messages are only moved under the lock, the copy is done by the caller
+	 *
+	 * \param p processing unit
+	 * \param accept return true for the messages to take
+	 * \param out messages taken (appended)
+	 *
+	 */
+	template<typename F> void drain(size_t p, F accept, std::vector<Vcluster_pe_msg> & out)
+	{
+		std::lock_guard<std::mutex> lk(mtx[p]);
+
+		size_t k = 0;
+		for (size_t i = 0 ; i < box[p].size() ; i++)
+		{
+			if (accept(box[p][i]) == true)
+			{out.push_back(box[p][i]);}
+			else
+			{box[p][k++] = box[p][i];}
+		}
+
+		box[p].resize(k);
+	}
+
+	/*! \brief Signal that a processing unit completed its sends
+	 *
+	 * \param p processing unit
+	 *
+	 * \return the round reached
+	 *
+	 */
+	size_t signal(size_t p)
+	{
+		return round[p].fetch_add(1) + 1;
+	}
+
+	/*! \brief Check if all the processing units reached a round
+	 *
+	 * \param r round
+	 *
+	 * \return true if all the processing units completed the sends of the round r
+	 *
+	 */
+	bool reached(size_t r) const
+	{
+		for (size_t i = 0 ; i < n ; i++)
+		{
+			if (round[i].load() < r)
+			{return false;}
+		}
+
+		return true;
+	}
+};
+
+/*! \brief Receive list of an exchange with known processors redirected on the NBX
+ *
+ * With several processing units per process the exchanges with known processors run on the NBX,
+ * the call-back map every message on its position in the receive list, so the user call-back get
+ * the same request id as with MPI
+ *
+ */
+struct Vcluster_pe_known
+{
+	//! number of receive
+	size_t n_recv;
+
+	//! processing units from which we receive
+	size_t * prc_recv;
+
+	//! expected sizes (NULL if not known)
+	size_t * sz_recv;
+
+	//! where to store the received sizes (NULL if not needed)
+	size_t * sz_out;
+
+	//! receive done
+	std::vector<bool> done;
+
+	//! user call-back
+	void * (* msg_alloc)(size_t,size_t,size_t,size_t,size_t,size_t,void *);
+
+	//! argument of the user call-back
+	void * ptr_arg;
+
+	//! buffer for the unexpected messages
+	std::vector<unsigned char> discard;
+
+	/*! \brief Call-back of the NBX
+	 *
+	 * \param msg_i size of the message
+	 * \param total_msg total size to receive (unused)
+	 * \param total_p number of processors (unused)
+	 * \param i processing unit that sent the message
+	 * \param ri request id of the NBX
+	 * \param tag tag of the message
+	 * \param ptr Vcluster_pe_known
+	 *
+	 * \return the buffer of the user call-back
+	 *
+	 */
+	static void * msg_alloc_pe(size_t msg_i, size_t total_msg, size_t total_p, size_t i, size_t ri, size_t tag, void * ptr)
+	{
+		Vcluster_pe_known & k = *(Vcluster_pe_known *)ptr;
+
+		for (size_t j = 0 ; j < k.n_recv ; j++)
+		{
+			if (k.done[j] == false && k.prc_recv[j] == i && (k.sz_recv == NULL || k.sz_recv[j] == msg_i))
+			{
+				k.done[j] = true;
+
+				if (k.sz_out != NULL)
+				{k.sz_out[j] = msg_i;}
+
+				return k.msg_alloc(msg_i,total_msg,total_p,i,j,tag,k.ptr_arg);
+			}
+		}
+
+		std::cerr << "Error: " << __FILE__ << ":" << __LINE__ << " unexpected message of size " << msg_i << " from processor " << i << ", it is discarded" << std::endl;
+
+		k.discard.resize(msg_i);
+		return k.discard.data();
+	}
+};
+
+#endif /* VCLUSTER_PE_HPP_ */
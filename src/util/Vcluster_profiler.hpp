@@ -0,0 +1,316 @@
+/*
+ * Vcluster_profiler.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef VCLUSTER_PROFILER_HPP_
+#define VCLUSTER_PROFILER_HPP_
+
+#include <vector>
+#include <string>
+#include <ostream>
+#include <algorithm>
+
+//! point-to-point send() and recv()
+constexpr int VCL_PROF_P2P = 0;
+//! NBX with unknown processors and sizes
+constexpr int VCL_PROF_NBX_UNKNOWN = 1;
+//! NBX with known processors and sizes
+constexpr int VCL_PROF_NBX_KNOWN = 2;
+//! NBX with known processors
+constexpr int VCL_PROF_NBX_KNOWN_PRC = 3;
+//! semantic send and receive (SSendRecv and its variants)
+constexpr int VCL_PROF_SSENDRECV = 4;
+//! semantic collectives (SGather, SScatter, SAlltoall, SAllGather, SBcast)
+constexpr int VCL_PROF_COLLECTIVE = 5;
+//! number of categories
+constexpr int VCL_PROF_N_API = 6;
+
+/*! \brief Set the category of the communications in a scope
+ *
+ * The previous category is restored at the end of the scope
+ *
+ */
+struct vcl_prof_scope
+{
+	//! category
+	int & api;
+
+	//! previous category
+	int old;
+
+	/*! \brief Set the category
+	 *
+	 * \param api category to set
+	 * \param val new value
+	 *
+	 */
+	vcl_prof_scope(int & api, int val)
+	:api(api),old(api)
+	{
+		api = val;
+	}
+
+	//! restore the category
+	~vcl_prof_scope()
+	{
+		api = old;
+	}
+};
+
+/*! \brief Per-peer communication profiler
+ *
+ * For each label (set by the user) and each category of communication it count the bytes and the
+ * messages sent to and received from every processor. When disabled the cost is one branch per message,
+ * and the counters are allocated only the first time the profiler is enabled
+ *
+ */
+class Vcluster_profiler
+{
+	//! number of counters for each peer
+	static const size_t n_cnt = 4;
+
+	//! the profiler is recording
+	bool active = false;
+
+	//! number of processors
+	size_t np = 0;
+
+	//! labels
+	std::vector<std::string> labels;
+
+	//! current label
+	size_t cur = 0;
+
+	//! for each label the counters [api][peer][bytes sent, messages sent, bytes received, messages received]
+	std::vector<std::vector<size_t>> data;
+
+	//! the counters are allocated (the first time the profiler is enabled)
+	bool allocated = false;
+
+	//! Allocate the counters of all the labels
+	void allocate()
+	{
+		for (size_t i = 0 ; i < data.size() ; i++)
+		{data[i].resize(VCL_PROF_N_API*np*n_cnt,0);}
+
+		allocated = true;
+	}
+
+	/*! \brief Add a message to the counters
+	 *
+	 * \param api category
+	 * \param peer processor
+	 * \param bytes size of the message
+	 * \param off 0 for the sent counters, 2 for the received
+	 *
+	 */
+	inline void add(int api, size_t peer, size_t bytes, size_t off)
+	{
+		if (peer >= np)
+		{return;}
+
+		size_t * c = &data[cur][((size_t)api*np + peer)*n_cnt + off];
+		c[0] += bytes;
+		c[1]++;
+	}
+
+public:
+
+	/*! \brief Set the number of processors
+	 *
+	 * The counters are allocated only when the profiler is enabled
+	 *
+	 * \param np number of processors
+	 *
+	 */
+	void init(size_t np)
+	{
+		this->np = np;
+		labels.clear();
+		data.clear();
+		cur = 0;
+		allocated = false;
+
+		setLabel("");
+
+		if (active == true)
+		{allocate();}
+	}
+
+	/*! \brief Start or stop the recording
+	 *
+	 * \param active true to start
+	 *
+	 */
+	void enable(bool active)
+	{
+		if (active == true && allocated == false)
+		{allocate();}
+
+		this->active = active;
+	}
+
+	/*! \brief Return true if the profiler is recording
+	 *
+	 * \return true if recording
+	 *
+	 */
+	bool isActive() const
+	{
+		return active;
+	}
+
+	/*! \brief Set the label of the next communications (for example the name of the phase)
+	 *
+	 * \param label label ("" is the default), it must not contain commas or quotes
+	 *
+	 */
+	void setLabel(const std::string & label)
+	{
+		for (cur = 0 ; cur < labels.size() ; cur++)
+		{
+			if (labels[cur] == label)
+			{return;}
+		}
+
+		labels.push_back(label);
+		data.push_back(std::vector<size_t>((allocated == true)?VCL_PROF_N_API*np*n_cnt:0,0));
+	}
+
+	/*! \brief Record a sent message
+	 *
+	 * \param api category
+	 * \param peer destination
+	 * \param bytes size
+	 *
+	 */
+	inline void send(int api, size_t peer, size_t bytes)
+	{
+		if (active == true)
+		{add(api,peer,bytes,0);}
+	}
+
+	/*! \brief Record a received message
+	 *
+	 * \param api category
+	 * \param peer source
+	 * \param bytes size
+	 *
+	 */
+	inline void recv(int api, size_t peer, size_t bytes)
+	{
+		if (active == true)
+		{add(api,peer,bytes,2);}
+	}
+
+	//! Set all the counters to zero
+	void reset()
+	{
+		for (size_t i = 0 ; i < data.size() ; i++)
+		{std::fill(data[i].begin(),data[i].end(),0);}
+	}
+
+	/*! \brief Get a counter
+	 *
+	 * \param label label
+	 * \param api category
+	 * \param peer processor
+	 * \param c 0 bytes sent, 1 messages sent, 2 bytes received, 3 messages received
+	 *
+	 * \return the counter (0 if the label does not exist)
+	 *
+	 */
+	size_t get(const std::string & label, int api, size_t peer, size_t c) const
+	{
+		for (size_t l = 0 ; l < labels.size() ; l++)
+		{
+			if (labels[l] == label && allocated == true)
+			{return data[l][((size_t)api*np + peer)*n_cnt + c];}
+		}
+
+		return 0;
+	}
+
+	/*! \brief Name of a category
+	 *
+	 * \param api category
+	 *
+	 * \return the name
+	 *
+	 */
+	static const char * apiName(int api)
+	{
+		const char * names[] = {"p2p","nbx_unknown","nbx_known","nbx_known_prc","ssendrecv","collective"};
+
+		return names[api];
+	}
+
+	/*! \brief Write the non-zero counters as CSV rows
+	 *
+	 * rank,label,api,peer,bytes_sent,msgs_sent,bytes_recv,msgs_recv
+	 *
+	 * \param out stream
+	 * \param rank processor that own the counters
+	 *
+	 */
+	void writeCSV(std::ostream & out, size_t rank) const
+	{
+		if (allocated == false)
+		{return;}
+
+		for (size_t l = 0 ; l < labels.size() ; l++)
+		{
+			for (int a = 0 ; a < VCL_PROF_N_API ; a++)
+			{
+				for (size_t p = 0 ; p < np ; p++)
+				{
+					const size_t * c = &data[l][((size_t)a*np + p)*n_cnt];
+
+					if (c[1] == 0 && c[3] == 0)
+					{continue;}
+
+					out << rank << "," << labels[l] << "," << apiName(a) << "," << p << "," << c[0] << "," << c[1] << "," << c[2] << "," << c[3] << "\n";
+				}
+			}
+		}
+	}
+
+	/*! \brief Write the non-zero counters as a JSON array of objects (without the brackets)
+	 *
+	 * \param out stream
+	 * \param rank processor that own the counters
+	 * \param first true if no object has been written before in the array
+	 *
+	 */
+	void writeJSON(std::ostream & out, size_t rank, bool & first) const
+	{
+		if (allocated == false)
+		{return;}
+
+		for (size_t l = 0 ; l < labels.size() ; l++)
+		{
+			for (int a = 0 ; a < VCL_PROF_N_API ; a++)
+			{
+				for (size_t p = 0 ; p < np ; p++)
+				{
+					const size_t * c = &data[l][((size_t)a*np + p)*n_cnt];
+
+					if (c[1] == 0 && c[3] == 0)
+					{continue;}
+
+					if (first == false)
+					{out << ",\n";}
+
+					out << "{\"rank\":" << rank << ",\"label\":\"" << labels[l] << "\",\"api\":\"" << apiName(a) << "\",\"peer\":" << p
+					    << ",\"bytes_sent\":" << c[0] << ",\"msgs_sent\":" << c[1] << ",\"bytes_recv\":" << c[2] << ",\"msgs_recv\":" << c[3] << "}";
+
+					first = false;
+				}
+			}
+		}
+	}
+};
+
+#endif /* VCLUSTER_PROFILER_HPP_ */
@@ -0,0 +1,253 @@
+/*
+ * Vcluster_repro_sum.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef VCLUSTER_REPRO_SUM_HPP_
+#define VCLUSTER_REPRO_SUM_HPP_
+
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+
+/*! \brief Accumulator for reproducible sums of floating point numbers
+ *
+ * It is a fixed point number that cover the full range of double (from 2^-1074 up to 2^1024 with
+ * room for carries). Every double is added exactly, so the result does not depend on the order of
+ * the additions, on the number of processors or on the reduction tree. The digits are in base 2^32
+ * stored in int64_t, so up to 2^31 numbers can be added before propagating the carries.
+ *
+ * Infinities and NaN are counted separately and give the same result of an ordinary sum
+ *
+ */
+struct Vcluster_repro_acc
+{
+	//! number of digits
+	static const int n_words = 68;
+
+	//! digits (the digit i has weight 2^(32*i - 1074))
+	int64_t w[n_words];
+
+	//! number of +inf
+	int64_t inf_p;
+
+	//! number of -inf
+	int64_t inf_n;
+
+	//! number of NaN
+	int64_t nan;
+
+	//! Set the accumulator to zero
+	void zero()
+	{
+		memset(w,0,sizeof(w));
+		inf_p = 0;
+		inf_n = 0;
+		nan = 0;
+	}
+
+	/*! \brief Add a number
+	 *
+	 * \param x number to add
+	 *
+	 */
+	inline void add(double x)
+	{
+		uint64_t bits;
+		memcpy(&bits,&x,sizeof(double));
+
+		uint64_t ex = (bits >> 52) & 0x7ff;
+		uint64_t m = bits & 0xfffffffffffffull;
+		bool neg = (bits >> 63) != 0;
+
+		if (ex == 0x7ff)
+		{
+			if (m != 0) {nan++;}
+			else if (neg) {inf_n++;}
+			else {inf_p++;}
+
+			return;
+		}
+
+		// the number is m*2^(p - 1074)
+		int p = 0;
+		if (ex != 0)
+		{
+			m |= 0x10000000000000ull;
+			p = ex - 1;
+		}
+
+		int k = p >> 5;
+		int s = p & 31;
+
+		int64_t lo = (int64_t)((m << s) & 0xffffffffull);
+		int64_t mid = (s == 0)?(int64_t)(m >> 32):(int64_t)((m >> (32 - s)) & 0xffffffffull);
+		int64_t hi = (s == 0)?0:(int64_t)(m >> (64 - s));
+
+		if (neg)
+		{
+			w[k] -= lo;
+			w[k+1] -= mid;
+			w[k+2] -= hi;
+		}
+		else
+		{
+			w[k] += lo;
+			w[k+1] += mid;
+			w[k+2] += hi;
+		}
+	}
+
+	/*! \brief Add an array of numbers
+	 *
+	 * \param v array
+	 * \param n number of elements
+	 *
+	 */
+	template<typename T> void add(const T * v, size_t n)
+	{
+		const size_t chunk = 1073741824;
+
+		for (size_t i = 0 ; i < n ; i += chunk)
+		{
+			size_t stop = (n - i < chunk)?n:i + chunk;
+
+			for (size_t j = i ; j < stop ; j++)
+			{add((double)v[j]);}
+
+			normalize();
+		}
+	}
+
+	//! Propagate the carries (every digit except the last go in [0,2^32))
+	void normalize()
+	{
+		for (int i = 0 ; i < n_words - 1 ; i++)
+		{
+			int64_t c = w[i] >> 32;
+			w[i] -= c * 4294967296ll;
+			w[i+1] += c;
+		}
+	}
+
+	/*! \brief Merge another accumulator
+	 *
+	 * \param acc accumulator (normalized)
+	 *
+	 */
+	void merge(const Vcluster_repro_acc & acc)
+	{
+		for (int i = 0 ; i < n_words ; i++)
+		{w[i] += acc.w[i];}
+
+		inf_p += acc.inf_p;
+		inf_n += acc.inf_n;
+		nan += acc.nan;
+
+		normalize();
+	}
+
+	/*! \brief Bit of the accumulator (normalized, not negative)
+	 *
+	 * \param i bit (the bit i has weight 2^(i - 1074))
+	 *
+	 * \return the bit
+	 *
+	 */
+	inline uint64_t bit(int i) const
+	{
+		return ((uint64_t)w[i >> 5] >> (i & 31)) & 1;
+	}
+
+	/*! \brief Round the accumulator to double
+	 *
+	 * The exact sum is rounded once to the nearest double (ties to even), so the result depend
+	 * only on the exact sum and it is reproducible
+	 *
+	 * \return the sum
+	 *
+	 */
+	double get()
+	{
+		if (nan != 0 || (inf_p != 0 && inf_n != 0))
+		{return std::nan("");}
+
+		if (inf_p != 0)
+		{return INFINITY;}
+
+		if (inf_n != 0)
+		{return -INFINITY;}
+
+		normalize();
+
+		// get the magnitude
+		double sign = 1.0;
+		if (w[n_words-1] < 0)
+		{
+			sign = -1.0;
+			for (int i = 0 ; i < n_words ; i++)
+			{w[i] = -w[i];}
+
+			normalize();
+		}
+
+		int top = n_words - 1;
+		while (top >= 0 && w[top] == 0)
+		{top--;}
+
+		if (top < 0)
+		{return 0.0;}
+
+		// the last digit is not bounded, but a bit over 2^1024 overflow anyway
+		if (w[top] >= 4294967296ll)
+		{return sign*INFINITY;}
+
+		// leading bit
+		int l = 32*top + 31;
+		while (bit(l) == 0)
+		{l--;}
+
+		// less than 53 bits, the number is exact
+		if (l < 53)
+		{
+			uint64_t m = 0;
+			for (int i = l ; i >= 0 ; i--)
+			{m = (m << 1) | bit(i);}
+
+			return sign*std::ldexp((double)m,-1074);
+		}
+
+		// mantissa, guard bit and sticky bits
+		uint64_t m = 0;
+		for (int i = l ; i >= l - 52 ; i--)
+		{m = (m << 1) | bit(i);}
+
+		int g = l - 53;
+		bool sticky = false;
+		for (int i = 0 ; i < (g >> 5) && sticky == false ; i++)
+		{sticky = (w[i] != 0);}
+
+		for (int i = g - 1 ; i >= ((g >> 5) << 5) && sticky == false ; i--)
+		{sticky = (bit(i) != 0);}
+
+		// round to nearest, ties to even (m can become 2^53, ldexp handle it and the overflow)
+		if (bit(g) != 0 && (sticky == true || (m & 1) != 0))
+		{m++;}
+
+		return sign*std::ldexp((double)m,l - 52 - 1074);
+	}
+
+	/*! \brief Reduction operation (to use with MPI_IallreduceW_op)
+	 *
+	 * \param in accumulator
+	 * \param inout accumulator where to merge
+	 *
+	 */
+	void operator()(const Vcluster_repro_acc & in, Vcluster_repro_acc & inout) const
+	{
+		inout.merge(in);
+	}
+};
+
+#endif /* VCLUSTER_REPRO_SUM_HPP_ */
@@ -0,0 +1,201 @@
+/*
+ * Vcluster_trace.hpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef VCLUSTER_TRACE_HPP_
+#define VCLUSTER_TRACE_HPP_
+
+#include <mpi.h>
+#include <vector>
+#include <ostream>
+#include <iomanip>
+
+/*! \brief Phase of a communication
+ *
+ * The name must be a string literal (only the pointer is stored)
+ *
+ */
+struct vcl_trace_event
+{
+	//! name of the phase
+	const char * name;
+
+	//! start time (MPI_Wtime)
+	double start;
+
+	//! end time (MPI_Wtime)
+	double end;
+};
+
+/*! \brief Timeline of the communication phases of one processor
+ *
+ * The phases are stored in a ring buffer, when it is full the oldest are overwritten. When disabled
+ * the cost is one branch per phase
+ *
+ */
+class Vcluster_trace
+{
+	//! the trace is recording
+	bool active = false;
+
+	//! ring buffer
+	std::vector<vcl_trace_event> ring;
+
+	//! next position to write
+	size_t pos = 0;
+
+	//! number of stored phases
+	size_t n = 0;
+
+public:
+
+	/*! \brief Start or stop the recording
+	 *
+	 * \param active true to start
+	 * \param capacity maximum number of phases stored (the buffer is allocated at the first start)
+	 *
+	 */
+	void enable(bool active, size_t capacity = 65536)
+	{
+		if (active == true && ring.size() == 0)
+		{ring.resize((capacity == 0)?1:capacity);}
+
+		this->active = active;
+	}
+
+	/*! \brief Return true if the trace is recording
+	 *
+	 * \return true if recording
+	 *
+	 */
+	bool isActive() const
+	{
+		return active;
+	}
+
+	/*! \brief Start a phase
+	 *
+	 * \return the start time to pass to end (0 if disabled)
+	 *
+	 */
+	inline double begin() const
+	{
+		return (active == true)?MPI_Wtime():0.0;
+	}
+
+	/*! \brief Finish a phase
+	 *
+	 * \param name name of the phase (string literal)
+	 * \param start value returned by begin
+	 *
+	 */
+	inline void end(const char * name, double start)
+	{
+		if (active == false)
+		{return;}
+
+		vcl_trace_event & ev = ring[pos];
+		ev.name = name;
+		ev.start = start;
+		ev.end = MPI_Wtime();
+
+		pos = (pos + 1) % ring.size();
+		n = (n < ring.size())?n+1:n;
+	}
+
+	//! Remove all the phases
+	void clear()
+	{
+		pos = 0;
+		n = 0;
+	}
+
+	/*! \brief Number of stored phases
+	 *
+	 * \return the number of phases
+	 *
+	 */
+	size_t size() const
+	{
+		return n;
+	}
+
+	/*! \brief Get a phase
+	 *
+	 * \param i phase (0 is the oldest)
+	 *
+	 * \return the phase
+	 *
+	 */
+	const vcl_trace_event & get(size_t i) const
+	{
+		return ring[(pos + ring.size() - n + i) % ring.size()];
+	}
+
+	/*! \brief Write the phases as Chrome trace events (without the brackets of the array)
+	 *
+	 * Every processor is a process of the trace. The events start with a separator, so the first
+	 * two characters of the output of the first processor must be removed
+	 *
+	 * \param out stream
+	 * \param rank processor that own the trace
+	 * \param t_ref time subtracted from the timestamps
+	 * \param shift microseconds added to the timestamps
+	 *
+	 */
+	void writeJSON(std::ostream & out, size_t rank, double t_ref, double shift) const
+	{
+		// microseconds with nanosecond resolution
+		std::ios_base::fmtflags flags = out.flags();
+		std::streamsize prec = out.precision();
+		out << std::fixed << std::setprecision(3);
+
+		out << ",\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << rank << ",\"tid\":0,\"args\":{\"name\":\"rank " << rank << "\"}}";
+
+		for (size_t i = 0 ; i < n ; i++)
+		{
+			const vcl_trace_event & ev = get(i);
+
+			out << ",\n{\"name\":\"" << ev.name << "\",\"cat\":\"vcluster\",\"ph\":\"X\",\"pid\":" << rank << ",\"tid\":0,\"ts\":"
+			    << (ev.start - t_ref)*1e6 + shift << ",\"dur\":" << (ev.end - ev.start)*1e6 << "}";
+		}
+
+		out.flags(flags);
+		out.precision(prec);
+	}
+};
+
+/*! \brief Record a phase for the duration of a scope
+ *
+ */
+struct vcl_trace_scope
+{
+	//! trace
+	Vcluster_trace & tr;
+
+	//! name of the phase
+	const char * name;
+
+	//! start time
+	double start;
+
+	/*! \brief Start the phase
+	 *
+	 * \param tr trace
+	 * \param name name of the phase (string literal)
+	 *
+	 */
+	vcl_trace_scope(Vcluster_trace & tr, const char * name)
+	:tr(tr),name(name),start(tr.begin())
+	{}
+
+	//! finish the phase
+	~vcl_trace_scope()
+	{
+		tr.end(name,start);
+	}
+};
+
+#endif /* VCLUSTER_TRACE_HPP_ */